@@ -0,0 +1,736 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Minimal BGP speaker used by the convergence benchmark.
+ * In inject mode the RIB entries of a TABLE_DUMP_V2 file are turned
+ * into UPDATE messages up front and then streamed to bgpd as fast as
+ * the socket allows. In receive mode (-R) the session only counts the
+ * NLRI and withdraws sent by bgpd.
+ * All events are reported as single lines of key=value pairs on stdout
+ * with wall clock timestamps so the results of multiple instances can
+ * be correlated.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bgpd.h"
+#include "rde.h"
+#include "session.h"
+#include "mrtparser.h"
+
+#define INJECT_HOLDTIME		90
+#define INJECT_KEEPALIVE	30
+
+enum inject_state {
+	S_CONNECT,
+	S_OPENSENT,
+	S_OPENCONFIRM,
+	S_ESTABLISHED,
+};
+
+struct inject {
+	struct ibuf		*updates;	/* pre-built UPDATE stream */
+	struct ibuf		*wbuf;		/* pending output */
+	size_t			 woff;
+	u_char			 rbuf[4 * MAX_PKTSIZE];
+	size_t			 rlen;
+	struct bgpd_addr	 local;
+	uint32_t		 as;
+	uint32_t		 entry;
+	uint8_t			 aid;
+	enum inject_state	 state;
+	int			 fd;
+	int			 receiver;
+	uint64_t		 prefixes;
+	uint64_t		 skipped;
+	uint64_t		 nlri;
+	uint64_t		 withdraws;
+	uint64_t		 updates_rcvd;
+	uint64_t		 reported;
+	struct timespec		 last;
+	int			 eor_rcvd;
+	int			 injected;
+};
+
+static volatile sig_atomic_t	quit;
+static volatile sig_atomic_t	shutdown_req;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: bgpinject [-c] [-i entry] -a as -l local "
+	    "mrtfile [remote]\n"
+	    "       bgpinject -R -a as -l local remote\n");
+	exit(1);
+}
+
+static void
+sighdlr(int sig)
+{
+	switch (sig) {
+	case SIGTERM:
+	case SIGINT:
+		quit = 1;
+		break;
+	case SIGUSR1:
+		shutdown_req = 1;
+		break;
+	}
+}
+
+static void
+report(const char *event, const char *fmt, ...)
+{
+	struct timespec ts;
+	va_list ap;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	printf("event=%s time=%lld.%06ld", event, (long long)ts.tv_sec,
+	    ts.tv_nsec / 1000);
+	if (fmt != NULL) {
+		printf(" ");
+		va_start(ap, fmt);
+		vprintf(fmt, ap);
+		va_end(ap);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+static size_t
+msg_start(struct ibuf *b, uint8_t type)
+{
+	size_t off = ibuf_size(b);
+
+	if (ibuf_add_n32(b, 0xffffffff) == -1 ||
+	    ibuf_add_n32(b, 0xffffffff) == -1 ||
+	    ibuf_add_n32(b, 0xffffffff) == -1 ||
+	    ibuf_add_n32(b, 0xffffffff) == -1 ||
+	    ibuf_add_n16(b, 0) == -1 ||
+	    ibuf_add_n8(b, type) == -1)
+		err(1, "msg_start");
+	return off;
+}
+
+static int
+msg_end(struct ibuf *b, size_t off)
+{
+	size_t len = ibuf_size(b) - off;
+
+	if (len > MAX_PKTSIZE) {
+		if (ibuf_truncate(b, off) == -1)
+			err(1, "msg_end");
+		return -1;
+	}
+	if (ibuf_set_n16(b, off + 16, len) == -1)
+		err(1, "msg_end");
+	return 0;
+}
+
+static int
+attr_add(struct ibuf *b, uint8_t flags, uint8_t type, const void *data,
+    size_t len)
+{
+	if (len > 255)
+		flags |= ATTR_EXTLEN;
+	if (ibuf_add_n8(b, flags) == -1 || ibuf_add_n8(b, type) == -1)
+		return -1;
+	if (flags & ATTR_EXTLEN) {
+		if (ibuf_add_n16(b, len) == -1)
+			return -1;
+	} else if (ibuf_add_n8(b, len) == -1)
+		return -1;
+	return ibuf_add(b, data, len);
+}
+
+static int
+prefix_add(struct ibuf *b, struct bgpd_addr *prefix, uint8_t plen)
+{
+	if (ibuf_add_n8(b, plen) == -1)
+		return -1;
+	return ibuf_add(b, &prefix->v6, MRT_PREFIX_LEN(plen));
+}
+
+/*
+ * Convert one RIB entry into an UPDATE message. The AS_PATH is prepended
+ * with our own AS and the nexthop is rewritten to the local session
+ * address. Attributes that are not valid on an eBGP session are dropped.
+ */
+static void
+inject_dump(struct mrt_rib *mr, struct mrt_peer *mpeer, void *arg)
+{
+	struct inject		*in = arg;
+	struct mrt_rib_entry	*mre;
+	struct ibuf		*b = in->updates;
+	u_char			*aspath;
+	size_t			 off, aoff, len;
+	uint16_t		 i, afi;
+	uint8_t			 safi, type;
+
+	if (mr->nentries == 0 || mr->prefix.aid != in->aid)
+		return;
+	mre = &mr->entries[in->entry % mr->nentries];
+
+	off = msg_start(b, BGP_UPDATE);
+	if (ibuf_add_n16(b, 0) == -1)	/* withdrawn routes length */
+		err(1, NULL);
+	aoff = ibuf_size(b);
+	if (ibuf_add_n16(b, 0) == -1)	/* path attribute length */
+		err(1, NULL);
+
+	if (attr_add(b, ATTR_WELL_KNOWN, ATTR_ORIGIN, &mre->origin, 1) == -1)
+		err(1, NULL);
+
+	len = mre->aspath_len + 6;
+	if ((aspath = malloc(len)) == NULL)
+		err(1, NULL);
+	aspath[0] = AS_SEQUENCE;
+	aspath[1] = 1;
+	aspath[2] = in->as >> 24;
+	aspath[3] = in->as >> 16;
+	aspath[4] = in->as >> 8;
+	aspath[5] = in->as;
+	memcpy(aspath + 6, mre->aspath, mre->aspath_len);
+	if (attr_add(b, ATTR_WELL_KNOWN, ATTR_ASPATH, aspath, len) == -1)
+		err(1, NULL);
+	free(aspath);
+
+	if (in->aid == AID_INET) {
+		if (attr_add(b, ATTR_WELL_KNOWN, ATTR_NEXTHOP,
+		    &in->local.v4, sizeof(in->local.v4)) == -1)
+			err(1, NULL);
+	}
+	if (mre->med != 0) {
+		uint32_t med = htonl(mre->med);
+
+		if (attr_add(b, ATTR_OPTIONAL, ATTR_MED, &med,
+		    sizeof(med)) == -1)
+			err(1, NULL);
+	}
+
+	for (i = 0; i < mre->nattrs; i++) {
+		type = ((u_char *)mre->attrs[i].attr)[1];
+		switch (type) {
+		case ATTR_LOCALPREF:
+		case ATTR_ORIGINATOR_ID:
+		case ATTR_CLUSTER_LIST:
+		case ATTR_AS4_PATH:
+		case ATTR_AS4_AGGREGATOR:
+		case ATTR_MP_REACH_NLRI:
+		case ATTR_MP_UNREACH_NLRI:
+			continue;
+		}
+		if (ibuf_add(b, mre->attrs[i].attr,
+		    mre->attrs[i].attr_len) == -1)
+			err(1, NULL);
+	}
+
+	if (in->aid != AID_INET) {
+		struct ibuf *reach;
+
+		if (aid2afi(in->aid, &afi, &safi) == -1)
+			errx(1, "bad aid");
+		if ((reach = ibuf_dynamic(64, MAX_PKTSIZE)) == NULL)
+			err(1, NULL);
+		if (ibuf_add_n16(reach, afi) == -1 ||
+		    ibuf_add_n8(reach, safi) == -1 ||
+		    ibuf_add_n8(reach, sizeof(in->local.v6)) == -1 ||
+		    ibuf_add(reach, &in->local.v6,
+		    sizeof(in->local.v6)) == -1 ||
+		    ibuf_add_n8(reach, 0) == -1 ||
+		    prefix_add(reach, &mr->prefix, mr->prefixlen) == -1 ||
+		    attr_add(b, ATTR_OPTIONAL, ATTR_MP_REACH_NLRI,
+		    ibuf_data(reach), ibuf_size(reach)) == -1)
+			err(1, NULL);
+		ibuf_free(reach);
+	}
+	if (ibuf_set_n16(b, aoff, ibuf_size(b) - aoff - 2) == -1)
+		err(1, NULL);
+
+	if (in->aid == AID_INET)
+		if (prefix_add(b, &mr->prefix, mr->prefixlen) == -1)
+			err(1, NULL);
+
+	if (msg_end(b, off) == -1)
+		in->skipped++;
+	else
+		in->prefixes++;
+}
+
+static void
+inject_eor(struct inject *in, struct ibuf *b)
+{
+	size_t off;
+	uint16_t afi;
+	uint8_t safi;
+
+	off = msg_start(b, BGP_UPDATE);
+	if (ibuf_add_n16(b, 0) == -1)
+		err(1, NULL);
+	if (in->aid == AID_INET) {
+		if (ibuf_add_n16(b, 0) == -1)
+			err(1, NULL);
+	} else {
+		if (aid2afi(in->aid, &afi, &safi) == -1)
+			errx(1, "bad aid");
+		if (ibuf_add_n16(b, 6) == -1 ||
+		    ibuf_add_n8(b, ATTR_OPTIONAL) == -1 ||
+		    ibuf_add_n8(b, ATTR_MP_UNREACH_NLRI) == -1 ||
+		    ibuf_add_n8(b, 3) == -1 ||
+		    ibuf_add_n16(b, afi) == -1 ||
+		    ibuf_add_n8(b, safi) == -1)
+			err(1, NULL);
+	}
+	msg_end(b, off);
+}
+
+static void
+inject_open(struct inject *in)
+{
+	struct ibuf *b = in->wbuf;
+	size_t off, poff;
+	uint32_t id;
+	uint16_t afi;
+	uint8_t safi;
+
+	if (aid2afi(in->aid, &afi, &safi) == -1)
+		errx(1, "bad aid");
+	/* use the lower bits of the AS and the entry as BGP ID */
+	id = htonl(0x0a000000 | (in->as & 0xffff) << 8 | (in->entry & 0xff));
+
+	off = msg_start(b, BGP_OPEN);
+	if (ibuf_add_n8(b, BGP_VERSION) == -1 ||
+	    ibuf_add_n16(b, in->as > USHRT_MAX ? AS_TRANS : in->as) == -1 ||
+	    ibuf_add_n16(b, INJECT_HOLDTIME) == -1 ||
+	    ibuf_add(b, &id, sizeof(id)) == -1)
+		err(1, NULL);
+	poff = ibuf_size(b);
+	if (ibuf_add_n8(b, 0) == -1 ||
+	    ibuf_add_n8(b, OPT_PARAM_CAPABILITIES) == -1 ||
+	    ibuf_add_n8(b, 0) == -1)
+		err(1, NULL);
+	/* multiprotocol */
+	if (ibuf_add_n8(b, CAPA_MP) == -1 || ibuf_add_n8(b, 4) == -1 ||
+	    ibuf_add_n16(b, afi) == -1 || ibuf_add_n8(b, 0) == -1 ||
+	    ibuf_add_n8(b, safi) == -1)
+		err(1, NULL);
+	/* graceful restart, needed so that bgpd sends an End-of-RIB */
+	if (ibuf_add_n8(b, CAPA_RESTART) == -1 || ibuf_add_n8(b, 6) == -1 ||
+	    ibuf_add_n16(b, 0) == -1 || ibuf_add_n16(b, afi) == -1 ||
+	    ibuf_add_n8(b, safi) == -1 || ibuf_add_n8(b, 0) == -1)
+		err(1, NULL);
+	/* 4-byte AS numbers */
+	if (ibuf_add_n8(b, CAPA_AS4BYTE) == -1 || ibuf_add_n8(b, 4) == -1 ||
+	    ibuf_add_n32(b, in->as) == -1)
+		err(1, NULL);
+	if (ibuf_set_n8(b, poff, ibuf_size(b) - poff - 1) == -1 ||
+	    ibuf_set_n8(b, poff + 2, ibuf_size(b) - poff - 3) == -1)
+		err(1, NULL);
+	msg_end(b, off);
+}
+
+static void
+inject_keepalive(struct inject *in)
+{
+	msg_end(in->wbuf, msg_start(in->wbuf, BGP_KEEPALIVE));
+}
+
+static void
+inject_notification(struct inject *in, uint8_t errcode, uint8_t subcode)
+{
+	size_t off;
+
+	off = msg_start(in->wbuf, BGP_NOTIFICATION);
+	if (ibuf_add_n8(in->wbuf, errcode) == -1 ||
+	    ibuf_add_n8(in->wbuf, subcode) == -1)
+		err(1, NULL);
+	msg_end(in->wbuf, off);
+}
+
+static uint64_t
+count_prefixes(const u_char *p, size_t len)
+{
+	uint64_t cnt = 0;
+	size_t plen;
+
+	while (len > 0) {
+		plen = 1 + MRT_PREFIX_LEN(p[0]);
+		if (plen > len)
+			errx(1, "bad prefix encoding");
+		p += plen;
+		len -= plen;
+		cnt++;
+	}
+	return cnt;
+}
+
+static void
+parse_update(struct inject *in, const u_char *p, size_t len)
+{
+	const u_char *attr;
+	size_t wlen, alen, l, hlen;
+	uint64_t nlri = 0;
+	uint8_t flags, type;
+	int mpeor = 0;
+
+	if (len < 4)
+		errx(1, "short UPDATE");
+	wlen = p[0] << 8 | p[1];
+	if (wlen + 4 > len)
+		errx(1, "bad withdrawn length");
+	in->withdraws += count_prefixes(p + 2, wlen);
+	p += 2 + wlen;
+	len -= 2 + wlen;
+	alen = p[0] << 8 | p[1];
+	if (alen + 2 > len)
+		errx(1, "bad attribute length");
+	attr = p + 2;
+	p += 2 + alen;
+	len -= 2 + alen;
+	nlri += count_prefixes(p, len);
+
+	while (alen > 0) {
+		if (alen < 3)
+			errx(1, "bad attribute");
+		flags = attr[0];
+		type = attr[1];
+		if (flags & ATTR_EXTLEN) {
+			if (alen < 4)
+				errx(1, "bad attribute");
+			l = attr[2] << 8 | attr[3];
+			hlen = 4;
+		} else {
+			l = attr[2];
+			hlen = 3;
+		}
+		if (l + hlen > alen)
+			errx(1, "bad attribute length");
+		if (type == ATTR_MP_REACH_NLRI && l > 4) {
+			/* skip afi, safi, nexthop and reserved byte */
+			size_t skip = 3 + 1 + attr[hlen + 3] + 1;
+
+			if (skip <= l)
+				nlri += count_prefixes(attr + hlen + skip,
+				    l - skip);
+		} else if (type == ATTR_MP_UNREACH_NLRI) {
+			if (l == 3)
+				mpeor = 1;
+			else if (l > 3)
+				in->withdraws += count_prefixes(attr + hlen + 3,
+				    l - 3);
+		}
+		attr += hlen + l;
+		alen -= hlen + l;
+	}
+
+	in->nlri += nlri;
+	in->updates_rcvd++;
+	clock_gettime(CLOCK_REALTIME, &in->last);
+	if (nlri != 0 && in->nlri == nlri)
+		report("first", "nlri=%llu", (unsigned long long)nlri);
+	if (!in->eor_rcvd && (mpeor || (wlen == 0 && alen == 0 && len == 0 &&
+	    in->aid == AID_INET))) {
+		in->eor_rcvd = 1;
+		report("eor", "nlri=%llu withdraws=%llu",
+		    (unsigned long long)in->nlri,
+		    (unsigned long long)in->withdraws);
+	}
+}
+
+static void
+inject_established(struct inject *in)
+{
+	in->state = S_ESTABLISHED;
+	report("established", "as=%u", in->as);
+	if (in->receiver)
+		return;
+
+	report("inject-start", "prefixes=%llu",
+	    (unsigned long long)in->prefixes);
+	if (ibuf_add_ibuf(in->wbuf, in->updates) == -1)
+		err(1, NULL);
+	inject_eor(in, in->wbuf);
+	ibuf_free(in->updates);
+	in->updates = NULL;
+	in->injected = 1;
+}
+
+static void
+parse_msgs(struct inject *in)
+{
+	u_char *p = in->rbuf;
+	size_t len;
+	uint8_t type;
+
+	while (in->rlen >= MSGSIZE_HEADER) {
+		len = p[16] << 8 | p[17];
+		type = p[18];
+		if (len < MSGSIZE_HEADER || len > MAX_PKTSIZE)
+			errx(1, "bad message length %zu", len);
+		if (len > in->rlen)
+			break;
+
+		switch (type) {
+		case BGP_OPEN:
+			if (in->state != S_OPENSENT)
+				errx(1, "unexpected OPEN");
+			inject_keepalive(in);
+			in->state = S_OPENCONFIRM;
+			break;
+		case BGP_KEEPALIVE:
+			if (in->state == S_OPENCONFIRM)
+				inject_established(in);
+			break;
+		case BGP_UPDATE:
+			if (in->state != S_ESTABLISHED)
+				errx(1, "unexpected UPDATE");
+			parse_update(in, p + MSGSIZE_HEADER,
+			    len - MSGSIZE_HEADER);
+			break;
+		case BGP_NOTIFICATION:
+			errx(1, "received NOTIFICATION %u/%u",
+			    len > MSGSIZE_HEADER ? p[19] : 0,
+			    len > MSGSIZE_HEADER + 1 ? p[20] : 0);
+		default:
+			/* ignore ROUTE-REFRESH and friends */
+			break;
+		}
+		p += len;
+		in->rlen -= len;
+	}
+	memmove(in->rbuf, p, in->rlen);
+}
+
+static int
+inject_connect(struct inject *in, const char *remote)
+{
+	struct addrinfo hints, *res;
+	struct sockaddr *sa;
+	socklen_t salen;
+	int fd, error;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = aid2af(in->aid);
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST;
+	if ((error = getaddrinfo(remote, "179", &hints, &res)) != 0)
+		errx(1, "%s: %s", remote, gai_strerror(error));
+
+	if ((fd = socket(res->ai_family, SOCK_STREAM, 0)) == -1)
+		err(1, "socket");
+	sa = addr2sa(&in->local, 0, &salen);
+	if (bind(fd, sa, salen) == -1)
+		err(1, "bind %s", log_addr(&in->local));
+	if (connect(fd, res->ai_addr, res->ai_addrlen) == -1)
+		err(1, "connect %s", remote);
+	freeaddrinfo(res);
+
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1)
+		err(1, "fcntl");
+	return fd;
+}
+
+static void
+inject_loop(struct inject *in)
+{
+	struct pollfd pfd;
+	time_t lastka, laststatus = 0, now;
+	ssize_t n;
+
+	inject_open(in);
+	in->state = S_OPENSENT;
+	lastka = time(NULL);
+
+	while (!quit) {
+		now = time(NULL);
+		if (in->state == S_ESTABLISHED &&
+		    now - lastka >= INJECT_KEEPALIVE) {
+			inject_keepalive(in);
+			lastka = now;
+		}
+		if (shutdown_req && in->state == S_ESTABLISHED &&
+		    ibuf_size(in->wbuf) == in->woff) {
+			inject_notification(in, ERR_CEASE,
+			    ERR_CEASE_ADMIN_DOWN);
+			shutdown_req = 0;
+			quit = 1;
+		}
+		if (in->receiver && in->reported != in->updates_rcvd &&
+		    now != laststatus) {
+			in->reported = in->updates_rcvd;
+			laststatus = now;
+			report("status", "nlri=%llu withdraws=%llu "
+			    "last=%lld.%06ld", (unsigned long long)in->nlri,
+			    (unsigned long long)in->withdraws,
+			    (long long)in->last.tv_sec,
+			    in->last.tv_nsec / 1000);
+		}
+
+		pfd.fd = in->fd;
+		pfd.events = POLLIN;
+		if (ibuf_size(in->wbuf) > in->woff)
+			pfd.events |= POLLOUT;
+		if (poll(&pfd, 1, 1000) == -1) {
+			if (errno == EINTR)
+				continue;
+			err(1, "poll");
+		}
+
+		if (pfd.revents & POLLOUT) {
+			n = write(in->fd, (u_char *)ibuf_data(in->wbuf) +
+			    in->woff, ibuf_size(in->wbuf) - in->woff);
+			if (n == -1 && errno != EAGAIN && errno != EINTR)
+				err(1, "write");
+			if (n > 0)
+				in->woff += n;
+			if (in->woff == ibuf_size(in->wbuf)) {
+				if (in->injected) {
+					in->injected = 0;
+					report("inject-done", "prefixes=%llu",
+					    (unsigned long long)in->prefixes);
+				}
+				ibuf_truncate(in->wbuf, 0);
+				in->woff = 0;
+			}
+		}
+		if (pfd.revents & (POLLIN | POLLHUP)) {
+			n = read(in->fd, in->rbuf + in->rlen,
+			    sizeof(in->rbuf) - in->rlen);
+			if (n == -1) {
+				if (errno == EAGAIN || errno == EINTR)
+					continue;
+				err(1, "read");
+			}
+			if (n == 0)
+				errx(1, "connection closed by peer");
+			in->rlen += n;
+			parse_msgs(in);
+		}
+	}
+
+	/* flush a pending NOTIFICATION */
+	if (ibuf_size(in->wbuf) > in->woff)
+		(void)write(in->fd, (u_char *)ibuf_data(in->wbuf) + in->woff,
+		    ibuf_size(in->wbuf) - in->woff);
+	report("down", "nlri=%llu withdraws=%llu last=%lld.%06ld",
+	    (unsigned long long)in->nlri, (unsigned long long)in->withdraws,
+	    (long long)in->last.tv_sec, in->last.tv_nsec / 1000);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct inject in;
+	struct mrt_parser p;
+	const char *errstr, *mrtfile = NULL, *local = NULL;
+	int ch, fd, count = 0;
+
+	memset(&in, 0, sizeof(in));
+	while ((ch = getopt(argc, argv, "a:ci:l:R")) != -1) {
+		switch (ch) {
+		case 'a':
+			in.as = strtonum(optarg, 1, UINT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "as is %s: %s", errstr, optarg);
+			break;
+		case 'c':
+			count = 1;
+			break;
+		case 'i':
+			in.entry = strtonum(optarg, 0, USHRT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "entry is %s: %s", errstr, optarg);
+			break;
+		case 'l':
+			local = optarg;
+			break;
+		case 'R':
+			in.receiver = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (local == NULL || (!count && in.as == 0))
+		usage();
+	if (inet_pton(AF_INET, local, &in.local.v4) == 1)
+		in.local.aid = AID_INET;
+	else if (inet_pton(AF_INET6, local, &in.local.v6) == 1)
+		in.local.aid = AID_INET6;
+	else
+		errx(1, "bad local address %s", local);
+	in.aid = in.local.aid;
+
+	if (!in.receiver) {
+		if (argc < 1)
+			usage();
+		mrtfile = *argv++;
+		argc--;
+
+		if ((fd = open(mrtfile, O_RDONLY)) == -1)
+			err(1, "%s", mrtfile);
+		if ((in.updates = ibuf_dynamic(1024 * 1024, SIZE_MAX)) == NULL)
+			err(1, NULL);
+		memset(&p, 0, sizeof(p));
+		p.dump = inject_dump;
+		p.arg = &in;
+		mrt_parse(fd, &p, 0);
+		close(fd);
+		report("loaded", "prefixes=%llu skipped=%llu bytes=%zu",
+		    (unsigned long long)in.prefixes,
+		    (unsigned long long)in.skipped, ibuf_size(in.updates));
+		if (count)
+			exit(0);
+	}
+	if (argc != 1)
+		usage();
+
+	if ((in.wbuf = ibuf_dynamic(MAX_PKTSIZE, SIZE_MAX)) == NULL)
+		err(1, NULL);
+
+	signal(SIGTERM, sighdlr);
+	signal(SIGINT, sighdlr);
+	signal(SIGUSR1, sighdlr);
+	signal(SIGPIPE, SIG_IGN);
+
+	in.fd = inject_connect(&in, argv[0]);
+	inject_loop(&in);
+	close(in.fd);
+	return 0;
+}
@@ -0,0 +1,219 @@
+#!/bin/ksh
+#	$OpenBSD$
+
+# Convergence benchmark: inject the full table of an MRT TABLE_DUMP_V2 file
+# from NPEERS eBGP sessions over loopback into bgpd and distribute the result
+# to NRECV receivers. One line of key=value pairs is appended to OUTFILE:
+#   first_best	first prefix seen by a receiver after the injection started
+#   converge	RDE queues drained after all injectors finished
+#   drain	last UPDATE received by any receiver (Adj-RIB-Out drained)
+#   rss_kb	peak RSS of all bgpd processes, rde_rss_kb only of the RDE
+#   down_*	same measurements after one injector closed its session
+# All times are in seconds relative to the start of the injection.
+
+set -e
+
+BGPD=$1
+BGPDCONFIGDIR=$2
+RDOMAIN1=$3
+MRTFILE=$4
+NPEERS=${5:-4}
+NRECV=${6:-4}
+OUTFILE=${7:-convergence.out}
+
+INJECT=${PWD}/bgpinject
+NET=10.12.60
+LOCALAS=64500
+RDE_RSS=0
+RSS=0
+
+error_notify() {
+	pkill -T ${RDOMAIN1} bgpinject || true
+	pkill -T ${RDOMAIN1} bgpd || true
+	sleep 1
+	route -qn -T ${RDOMAIN1} flush || true
+	ifconfig lo${RDOMAIN1} destroy || true
+	if [ $1 -ne 0 ]; then
+		echo FAILED
+		exit 1
+	else
+		echo SUCCESS
+	fi
+}
+
+now() {
+	perl -MTime::HiRes=time -e 'printf "%.6f\n", time'
+}
+
+elapsed() {
+	awk -v a="$1" -v b="$2" 'BEGIN { printf "%.3f\n", a - b }'
+}
+
+# first or last value of key $2 for event $1 in the given logs
+event_time() {
+	local _ev=$1 _sel=$2
+	shift 2
+	sed -n "s/.*event=${_ev} .*time=\([0-9.]*\).*/\1/p" "$@" | \
+	    sort -n | ${_sel} -1
+}
+
+last_update() {
+	local _f
+
+	for _f in "$@"; do
+		sed -n 's/.*event=status .*last=\([0-9.]*\).*/\1/p' $_f | \
+		    tail -1
+	done | sort -n | tail -1
+}
+
+sample_rss() {
+	local _r
+
+	_r=$(ps -o rss= -p $(pgrep -d, -T ${RDOMAIN1} bgpd) | \
+	    awk '{ s += $1 } END { print s + 0 }')
+	[ "$_r" -gt "$RSS" ] && RSS=$_r
+	_r=$(ps -o rss= -p $(pgrep -d, -T ${RDOMAIN1} -f 'route decision') | \
+	    awk '{ s += $1 } END { print s + 0 }')
+	[ "$_r" -gt "$RDE_RSS" ] && RDE_RSS=$_r
+	return 0
+}
+
+# wait until the RDE has no more queued work for 3 samples in a row,
+# IDLE is set to the time of the first idle sample
+wait_idle() {
+	local _idle=0 _busy
+
+	while [ $_idle -lt 3 ]; do
+		sample_rss
+		_busy=$(route -T ${RDOMAIN1} exec bgpctl show rib memory | \
+		    awk '/messages queued|rib entries queued|pending prefix/ \
+		    { s += $1 } END { print s + 0 }')
+		if [ "$_busy" -eq 0 ]; then
+			[ $_idle -eq 0 ] && IDLE=$(now)
+			_idle=$((_idle + 1))
+		else
+			_idle=0
+		fi
+		sleep 0.2
+	done
+}
+
+# wait until all logs contain the event
+wait_event() {
+	local _ev=$1 _f
+	shift
+
+	for _f in "$@"; do
+		while ! grep -q "event=${_ev} " $_f; do
+			sample_rss
+			sleep 0.2
+		done
+	done
+}
+
+if [ "$(id -u)" -ne 0 ]; then
+	echo need root privileges >&2
+	exit 1
+fi
+
+trap 'error_notify $?' EXIT
+
+echo check if rdomains are busy
+if /sbin/ifconfig lo${RDOMAIN1} > /dev/null 2>&1; then
+    echo routing domain ${RDOMAIN1} is already used >&2
+    exit 1
+fi
+
+echo setup
+ifconfig lo${RDOMAIN1} rdomain ${RDOMAIN1}
+ifconfig lo${RDOMAIN1} inet 127.0.0.1/8
+ifconfig lo${RDOMAIN1} inet ${NET}.1/24 alias
+
+{
+	echo "AS ${LOCALAS}"
+	echo "router-id ${NET}.1"
+	echo "listen on ${NET}.1"
+	echo "fib-update no"
+	echo "group injectors {"
+	i=0
+	while [ $i -lt $NPEERS ]; do
+		echo "\tneighbor ${NET}.$((10 + i)) {" \
+		    "remote-as $((65000 + i)) }"
+		i=$((i + 1))
+	done
+	echo "\tpassive\n}"
+	echo "group receivers {"
+	i=0
+	while [ $i -lt $NRECV ]; do
+		echo "\tneighbor ${NET}.$((100 + i)) {" \
+		    "remote-as $((65100 + i)) }"
+		i=$((i + 1))
+	done
+	echo "\tpassive\n}"
+	echo "allow from any"
+	echo "allow to any"
+} > convergence.conf
+
+i=0
+while [ $i -lt $NPEERS ]; do
+	ifconfig lo${RDOMAIN1} inet ${NET}.$((10 + i))/32 alias
+	i=$((i + 1))
+done
+i=0
+while [ $i -lt $NRECV ]; do
+	ifconfig lo${RDOMAIN1} inet ${NET}.$((100 + i))/32 alias
+	i=$((i + 1))
+done
+
+PREFIXES=$(${INJECT} -c -l ${NET}.10 ${MRTFILE} | \
+    sed -n 's/.*prefixes=\([0-9]*\).*/\1/p')
+
+route -T ${RDOMAIN1} exec ${BGPD} -f convergence.conf
+sleep 1
+
+rm -f recv.*.log inject.*.log
+i=0
+while [ $i -lt $NRECV ]; do
+	route -T ${RDOMAIN1} exec ${INJECT} -R -a $((65100 + i)) \
+	    -l ${NET}.$((100 + i)) ${NET}.1 > recv.$i.log &
+	i=$((i + 1))
+done
+wait_event established recv.*.log
+
+i=0
+while [ $i -lt $NPEERS ]; do
+	route -T ${RDOMAIN1} exec ${INJECT} -a $((65000 + i)) -i $i \
+	    -l ${NET}.$((10 + i)) ${MRTFILE} ${NET}.1 > inject.$i.log &
+	[ $i -eq 0 ] && DOWNPID=$!
+	i=$((i + 1))
+done
+wait_event inject-start inject.*.log
+START=$(event_time inject-start head inject.*.log)
+
+wait_event inject-done inject.*.log
+wait_idle
+CONVERGE=${IDLE}
+sleep 2
+FIRST=$(event_time first head recv.*.log)
+DRAIN=$(last_update recv.*.log)
+
+echo peer down
+kill -USR1 ${DOWNPID}
+wait_event down inject.0.log
+DOWN=$(event_time down head inject.0.log)
+wait_idle
+DOWN_CONVERGE=${IDLE}
+sleep 2
+DOWN_DRAIN=$(last_update recv.*.log)
+
+echo "date=$(date +%s) bgpd=$(sha1 -q ${BGPD})" \
+    "mrt=$(basename ${MRTFILE}) prefixes=${PREFIXES}" \
+    "peers=${NPEERS} receivers=${NRECV}" \
+    "first_best=$(elapsed ${FIRST} ${START})" \
+    "converge=$(elapsed ${CONVERGE} ${START})" \
+    "drain=$(elapsed ${DRAIN} ${START})" \
+    "rss_kb=${RSS} rde_rss_kb=${RDE_RSS}" \
+    "down_converge=$(elapsed ${DOWN_CONVERGE} ${DOWN})" \
+    "down_drain=$(elapsed ${DOWN_DRAIN} ${DOWN})" | tee -a ${OUTFILE}
+
+exit 0
@@ -0,0 +1,134 @@
+#!/bin/ksh
+#	$OpenBSD$
+
+# Config parse and reload benchmark for large generated configurations.
+# A config with NPEERS neighbors, a prefix-set with NPREFIX entries and an
+# as-set with NASSET members is generated. One line of key=value pairs is
+# appended to OUTFILE:
+#   parse	time of bgpd -nf
+#   reload	time of bgpctl reload with an unchanged config
+#   reload_set	time of bgpctl reload after the prefix-set changed
+#   rss_kb	peak RSS of all bgpd processes
+# The reload times are only measured when run as root, bgpctl reload
+# returns once all processes finished the reload.
+
+set -e
+
+BGPD=$1
+RDOMAIN1=$2
+NPEERS=${3:-1000}
+NPREFIX=${4:-1000000}
+NASSET=${5:-100000}
+OUTFILE=${6:-reload.out}
+
+NET=10.12.61
+LOCALAS=64500
+SOCK=/var/run/bgpd.sock.${RDOMAIN1}
+RSS=0
+RUNNING=0
+
+error_notify() {
+	if [ ${RUNNING} -ne 0 ]; then
+		pkill -T ${RDOMAIN1} bgpd || true
+		sleep 1
+		ifconfig lo${RDOMAIN1} destroy || true
+	fi
+	if [ $1 -ne 0 ]; then
+		echo FAILED
+		exit 1
+	else
+		echo SUCCESS
+	fi
+}
+
+now() {
+	perl -MTime::HiRes=time -e 'printf "%.6f\n", time'
+}
+
+elapsed() {
+	awk -v a="$1" -v b="$2" 'BEGIN { printf "%.3f\n", a - b }'
+}
+
+sample_rss() {
+	local _r
+
+	_r=$(ps -o rss= -p $(pgrep -d, -T ${RDOMAIN1} bgpd) | \
+	    awk '{ s += $1 } END { print s + 0 }')
+	[ "$_r" -gt "$RSS" ] && RSS=$_r
+	return 0
+}
+
+# $1 is used as seed, the first half of the prefix-set is the same for all
+gen_config() {
+	awk -v peers=${NPEERS} -v nprefix=${NPREFIX} -v nasset=${NASSET} \
+	    -v net=${NET} -v localas=${LOCALAS} -v sock=${SOCK} \
+	    -v seed=$1 'BEGIN {
+		printf "AS %d\nrouter-id %s.1\nfib-update no\n", localas, net
+		printf "socket \"%s\"\n\n", sock
+		printf "prefix-set big {\n"
+		for (i = 0; i < nprefix; i++) {
+			n = i < nprefix / 2 ? i : i + seed * nprefix
+			printf "\t%d.%d.%d.0/24 or-longer\n", \
+			    n / 65536 % 224 + 1, n / 256 % 256, n % 256
+		}
+		printf "}\n\nas-set customers {\n"
+		for (i = 0; i < nasset; i++)
+			printf "\t%d\n", 65536 + i
+		printf "}\n\n"
+		printf "group peers {\n\tpassive\n"
+		for (i = 1; i <= peers; i++)
+			printf "\tneighbor 10.%d.%d.%d { remote-as %d }\n", \
+			    64 + i / 65536, i / 256 % 256, i % 256, 65536 + i
+		printf "}\n\n"
+		printf "allow from any prefix-set big\n"
+		printf "allow from any AS as-set customers\n"
+		printf "allow to any\n"
+	}'
+}
+
+trap 'error_notify $?' EXIT
+
+echo generate config
+gen_config 0 > reload.conf
+gen_config 1 > reload.2.conf
+
+S=$(now)
+${BGPD} -nf reload.conf
+PARSE=$(elapsed $(now) $S)
+
+RELOAD=-
+RELOAD_SET=-
+if [ "$(id -u)" -eq 0 -a -n "${RDOMAIN1}" ]; then
+	if /sbin/ifconfig lo${RDOMAIN1} > /dev/null 2>&1; then
+		echo routing domain ${RDOMAIN1} is already used >&2
+		exit 1
+	fi
+	ifconfig lo${RDOMAIN1} rdomain ${RDOMAIN1}
+	ifconfig lo${RDOMAIN1} inet ${NET}.1/24
+	RUNNING=1
+
+	cp reload.conf reload.run.conf
+	route -T ${RDOMAIN1} exec ${BGPD} -f ${PWD}/reload.run.conf
+	while ! bgpctl -s ${SOCK} show summary > /dev/null 2>&1; do
+		sleep 0.2
+	done
+	sample_rss
+
+	S=$(now)
+	bgpctl -s ${SOCK} reload > /dev/null
+	RELOAD=$(elapsed $(now) $S)
+	sample_rss
+
+	cp reload.2.conf reload.run.conf
+	S=$(now)
+	bgpctl -s ${SOCK} reload > /dev/null
+	RELOAD_SET=$(elapsed $(now) $S)
+	sample_rss
+fi
+
+echo "date=$(date +%s) bgpd=$(sha1 -q ${BGPD})" \
+    "peers=${NPEERS} prefixes=${NPREFIX} asset=${NASSET}" \
+    "parse=${PARSE} reload=${RELOAD} reload_set=${RELOAD_SET}" \
+    "rss_kb=${RSS}" | tee -a ${OUTFILE}
+
+exit 0
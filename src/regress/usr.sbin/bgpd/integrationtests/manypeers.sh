@@ -0,0 +1,163 @@
+#!/bin/ksh
+#	$OpenBSD$
+
+# Stress the session engine with many sessions and a short holdtime.
+# A route server in RDOMAIN1 peers with NPEERS sessions to a bgpd in
+# RDOMAIN2 which announces NPREFIX networks on every session. All sessions
+# must come up and none may drop, e.g. because of an expired hold timer.
+
+set -e
+
+BGPD=$1
+BGPDCONFIGDIR=$2
+RDOMAIN1=$3
+RDOMAIN2=$4
+PAIR1=$5
+PAIR2=$6
+NPEERS=${7:-100}
+NPREFIX=${8:-1000}
+
+RDOMAINS="${RDOMAIN1} ${RDOMAIN2}"
+PAIRS="${PAIR1} ${PAIR2}"
+NET1=198.18.0
+NET2=198.18.1
+
+error_notify() {
+	echo cleanup
+	pkill -T ${RDOMAIN1} bgpd || true
+	pkill -T ${RDOMAIN2} bgpd || true
+	sleep 1
+	ifconfig ${PAIR2} destroy || true
+	ifconfig ${PAIR1} destroy || true
+	route -qn -T ${RDOMAIN1} flush || true
+	route -qn -T ${RDOMAIN2} flush || true
+	ifconfig lo${RDOMAIN1} destroy || true
+	ifconfig lo${RDOMAIN2} destroy || true
+	if [ $1 -ne 0 ]; then
+		echo FAILED
+		exit 1
+	else
+		echo SUCCESS
+	fi
+}
+
+# number of established sessions with at least $2 prefixes received
+established() {
+	route -T $1 exec bgpctl show summary | \
+	    awk -v min=${2:-0} 'NR > 1 && $NF ~ /^[0-9]+$/ && $NF >= min \
+	    { n++ } END { print n + 0 }'
+}
+
+# wait up to 60 seconds until all sessions reached the state
+wait_established() {
+	local _i=0
+
+	while [ "$_i" -lt 120 ]; do
+		[ "$(established $1 $2)" -eq ${NPEERS} ] && return 0
+		sleep 0.5
+		_i="$((_i + 1))"
+	done
+	echo timeout
+	return 1
+}
+
+# no session may have seen an error
+check_errors() {
+	if route -T $1 exec bgpctl show neighbor | grep 'Last error'; then
+		echo session error in rdomain $1
+		return 1
+	fi
+	return 0
+}
+
+if [ "$(id -u)" -ne 0 ]; then
+	echo need root privileges >&2
+	exit 1
+fi
+
+trap 'error_notify $?' EXIT
+
+echo check if rdomains are busy
+for n in ${RDOMAINS}; do
+	if /sbin/ifconfig | grep -v "^lo${n}:" | grep " rdomain ${n} "; then
+		echo routing domain ${n} is already used >&2
+		exit 1
+	fi
+done
+
+echo check if interfaces are busy
+for n in ${PAIRS}; do
+	/sbin/ifconfig "${n}" >/dev/null 2>&1 && \
+	    ( echo interface ${n} is already used >&2; exit 1 )
+done
+
+echo setup
+ifconfig ${PAIR1} rdomain ${RDOMAIN1} ${NET1}.1/16 up
+ifconfig ${PAIR2} rdomain ${RDOMAIN2} ${NET2}.1/16 up
+ifconfig ${PAIR1} patch ${PAIR2}
+ifconfig lo${RDOMAIN1} inet 127.0.0.1/8
+ifconfig lo${RDOMAIN2} inet 127.0.0.1/8
+
+{
+	echo "AS 64500"
+	echo "router-id ${NET1}.1"
+	echo "fib-update no"
+	echo "group clients {"
+	echo "\tremote-as 64501"
+	echo "\tholdtime 3"
+	echo "\tpassive"
+	i=1
+	while [ $i -le $NPEERS ]; do
+		[ $i -gt 1 ] && ifconfig ${PAIR1} alias ${NET1}.$i/32
+		echo "\tneighbor ${NET2}.$i { local-address ${NET1}.$i }"
+		i=$((i + 1))
+	done
+	echo "}"
+	echo "allow from any"
+	echo "allow to any"
+} > manypeers.rdomain1.conf
+
+{
+	echo "AS 64501"
+	echo "router-id ${NET2}.1"
+	echo "fib-update no"
+	i=0
+	while [ $i -lt $NPREFIX ]; do
+		echo "network 10.$((i / 256)).$((i % 256)).0/24"
+		i=$((i + 1))
+	done
+	echo "group rs {"
+	echo "\tremote-as 64500"
+	echo "\tholdtime 3"
+	i=1
+	while [ $i -le $NPEERS ]; do
+		[ $i -gt 1 ] && ifconfig ${PAIR2} alias ${NET2}.$i/32
+		echo "\tneighbor ${NET1}.$i { local-address ${NET2}.$i }"
+		i=$((i + 1))
+	done
+	echo "}"
+	echo "allow from any"
+	echo "allow to any"
+} > manypeers.rdomain2.conf
+
+set -x
+
+echo run bgpds
+route -T ${RDOMAIN1} exec ${BGPD} -v -f ${PWD}/manypeers.rdomain1.conf
+route -T ${RDOMAIN2} exec ${BGPD} -v -f ${PWD}/manypeers.rdomain2.conf
+
+echo wait for all sessions
+wait_established ${RDOMAIN1}
+wait_established ${RDOMAIN2}
+
+echo test1: all prefixes received on every session
+wait_established ${RDOMAIN1} ${NPREFIX}
+
+echo test2: sessions stay up after the table transfer
+sleep 10
+[ "$(established ${RDOMAIN1})" -eq ${NPEERS} ]
+[ "$(established ${RDOMAIN2})" -eq ${NPEERS} ]
+check_errors ${RDOMAIN1}
+check_errors ${RDOMAIN2}
+
+exit 0
@@ -0,0 +1,100 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Tiny helpers shared by the *_bench programs.
+ * Every operation is repeated BENCH_RUNS times and the fastest run is
+ * reported since that is the least disturbed by the rest of the system.
+ * Output is one line of key=value pairs per measurement.
+ */
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS	5
+#endif
+
+struct bench {
+	const char	*name;
+	struct timespec	 start;
+	uint64_t	 best;
+	int		 runs;
+};
+
+static inline void
+bench_init(struct bench *b, const char *name)
+{
+	b->name = name;
+	b->best = 0;
+	b->runs = 0;
+}
+
+static inline void
+bench_start(struct bench *b)
+{
+	clock_gettime(CLOCK_MONOTONIC, &b->start);
+}
+
+static inline void
+bench_stop(struct bench *b)
+{
+	struct timespec end, diff;
+	uint64_t nsec;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	timespecsub(&end, &b->start, &diff);
+	nsec = diff.tv_sec * 1000000000ULL + diff.tv_nsec;
+	if (b->runs == 0 || nsec < b->best)
+		b->best = nsec;
+	b->runs++;
+}
+
+static inline void
+bench_report(struct bench *b, const char *op, uint64_t n, const char *extra)
+{
+	double nsop = 0;
+
+	if (n != 0)
+		nsop = (double)b->best / n;
+	printf("bench=%s op=%s n=%llu runs=%d best_ns=%llu ns_per_op=%.2f",
+	    b->name, op, (unsigned long long)n, b->runs,
+	    (unsigned long long)b->best, nsop);
+	if (extra != NULL)
+		printf(" %s", extra);
+	printf("\n");
+	fflush(stdout);
+	b->best = 0;
+	b->runs = 0;
+}
+
+/* peak resident set size in kilobytes */
+static inline long
+bench_maxrss(void)
+{
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) == -1)
+		return 0;
+	return ru.ru_maxrss;
+}
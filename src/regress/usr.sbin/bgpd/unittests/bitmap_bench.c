@@ -0,0 +1,155 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bgpd.h"
+#include "bench.h"
+
+#define NMAPS	10000		/* e.g. one map per prefix */
+#define NBITS	16		/* bits set per map */
+
+static const uint32_t maxids[] = { 128, 1024, 16384, 262144 };
+
+static void
+bench_maxid(uint32_t maxid)
+{
+	struct bench	 b;
+	struct bitmap	*maps;
+	uint32_t	*ids;
+	long long	 cnt, size;
+	char		 extra[64];
+	size_t		 i, j;
+	int		 r, sum = 0;
+
+	if ((maps = calloc(NMAPS, sizeof(*maps))) == NULL)
+		err(1, NULL);
+	if ((ids = calloc(NMAPS * NBITS, sizeof(*ids))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < NMAPS * NBITS; i++)
+		ids[i] = arc4random_uniform(maxid - 1) + 1;
+
+	snprintf(extra, sizeof(extra), "maxid=%u", maxid);
+	bench_init(&b, "bitmap");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		for (i = 0; i < NMAPS; i++)
+			bitmap_init(&maps[i]);
+		bench_start(&b);
+		for (i = 0; i < NMAPS; i++)
+			for (j = 0; j < NBITS; j++)
+				if (bitmap_set(&maps[i], ids[i * NBITS + j]) ==
+				    -1)
+					err(1, "bitmap_set");
+		bench_stop(&b);
+		if (r == BENCH_RUNS - 1)
+			break;
+		for (i = 0; i < NMAPS; i++)
+			bitmap_reset(&maps[i]);
+	}
+	bitmap_get_stats(&cnt, &size);
+	snprintf(extra, sizeof(extra), "maxid=%u bytes=%lld maps=%lld",
+	    maxid, size, cnt);
+	bench_report(&b, "set", NMAPS * NBITS, extra);
+
+	snprintf(extra, sizeof(extra), "maxid=%u", maxid);
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		/* half of the lookups hit */
+		for (i = 0; i < NMAPS; i++)
+			for (j = 0; j < NBITS; j++)
+				sum += bitmap_test(&maps[i], j & 1 ?
+				    ids[i * NBITS + j] : ids[j]);
+		bench_stop(&b);
+	}
+	bench_report(&b, "test", NMAPS * NBITS, extra);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < NMAPS; i++)
+			sum += bitmap_empty(&maps[i]);
+		bench_stop(&b);
+	}
+	bench_report(&b, "empty", NMAPS, extra);
+
+	bench_start(&b);
+	for (i = 0; i < NMAPS; i++)
+		for (j = 0; j < NBITS; j++)
+			bitmap_clear(&maps[i], ids[i * NBITS + j]);
+	bench_stop(&b);
+	bench_report(&b, "clear", NMAPS * NBITS, extra);
+
+	for (i = 0; i < NMAPS; i++)
+		bitmap_reset(&maps[i]);
+	free(ids);
+	free(maps);
+
+	/* keep the compiler from optimizing the lookups away */
+	if (sum < 0)
+		printf("%d\n", sum);
+}
+
+/* id allocator churn as done for peer ids, with a full map of maxid ids */
+static void
+bench_idalloc(uint32_t maxid)
+{
+	struct bench	 b;
+	struct bitmap	 map;
+	uint32_t	*ids;
+	uint32_t	 i, id;
+	char		 extra[32];
+	int		 r;
+
+	if ((ids = calloc(maxid, sizeof(*ids))) == NULL)
+		err(1, NULL);
+	for (i = 1; i < maxid; i++)
+		ids[i] = arc4random_uniform(maxid - 1) + 1;
+	bitmap_init(&map);
+	for (i = 1; i < maxid; i++)
+		if (bitmap_id_get(&map, &id) == -1)
+			err(1, "bitmap_id_get");
+
+	bench_init(&b, "bitmap");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 1; i < maxid; i++) {
+			bitmap_id_put(&map, ids[i]);
+			if (bitmap_id_get(&map, &id) == -1)
+				err(1, "bitmap_id_get");
+		}
+		bench_stop(&b);
+	}
+	snprintf(extra, sizeof(extra), "maxid=%u", maxid);
+	bench_report(&b, "id_put_get", maxid - 1, extra);
+	bitmap_reset(&map);
+	free(ids);
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t i;
+
+	for (i = 0; i < nitems(maxids); i++)
+		bench_maxid(maxids[i]);
+	for (i = 0; i < nitems(maxids) - 1; i++)
+		bench_idalloc(maxids[i]);
+	printf("bench=bitmap op=maxrss kb=%ld\n", bench_maxrss());
+
+	return 0;
+}
@@ -0,0 +1,185 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "chash.h"
+#include "bench.h"
+
+struct elm {
+	uint64_t	key;
+	uint64_t	pad[3];		/* roughly the size of a small object */
+};
+
+static uint64_t
+hash64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint64_t
+elm_hash(const struct elm *e)
+{
+	return hash64(e->key);
+}
+
+static inline int
+elm_cmp(const struct elm *l, const struct elm *r)
+{
+	return l->key == r->key;
+}
+
+CH_HEAD(elm_tbl, elm);
+CH_PROTOTYPE(elm_tbl, elm, elm_hash);
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: chash_bench [-n max]\n");
+	exit(1);
+}
+
+static void
+bench_size(uint64_t n)
+{
+	struct bench	 b;
+	struct elm_tbl	 head = CH_INITIALIZER(head);
+	struct ch_stats	 cs;
+	struct elm	*elms, key, bkeys[CH_BATCH_MAX], *res[CH_BATCH_MAX];
+	const struct elm *bkeyp[CH_BATCH_MAX];
+	uint32_t	*idx;
+	uint64_t	 i, j, m;
+	char		 extra[64];
+	int		 r;
+
+	if ((elms = calloc(n, sizeof(*elms))) == NULL)
+		err(1, NULL);
+	if ((idx = calloc(n, sizeof(*idx))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < n; i++) {
+		elms[i].key = arc4random() | (uint64_t)i << 32;
+		idx[i] = arc4random_uniform(n);
+	}
+
+	bench_init(&b, "chash");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < n; i++)
+			if (CH_INSERT(elm_tbl, &head, &elms[i], NULL) != 1)
+				errx(1, "insert %llu failed",
+				    (unsigned long long)i);
+		bench_stop(&b);
+
+		if (r == BENCH_RUNS - 1)
+			break;
+		for (i = 0; i < n; i++)
+			CH_REMOVE(elm_tbl, &head, &elms[i]);
+	}
+	CH_STATS(elm_tbl, &head, &cs);
+	snprintf(extra, sizeof(extra), "bytes=%zu bytes_per_elm=%.1f",
+	    cs.cs_size_tables + cs.cs_size_extendible,
+	    (double)(cs.cs_size_tables + cs.cs_size_extendible) / n);
+	bench_report(&b, "insert", n, extra);
+
+	/* lookups in random order to defeat the caches */
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < n; i++) {
+			key.key = elms[idx[i]].key;
+			if (CH_FIND(elm_tbl, &head, &key) == NULL)
+				errx(1, "find failed");
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "find", n, NULL);
+
+	/* same lookups, CH_BATCH_MAX at a time */
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < n; i += m) {
+			m = n - i < CH_BATCH_MAX ? n - i : CH_BATCH_MAX;
+			for (j = 0; j < m; j++) {
+				bkeys[j].key = elms[idx[i + j]].key;
+				bkeyp[j] = &bkeys[j];
+			}
+			CH_FIND_BATCH(elm_tbl, &head, m, bkeyp, res);
+			for (j = 0; j < m; j++)
+				if (res[j] == NULL)
+					errx(1, "find batch failed");
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "find-batch", n, NULL);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < n; i++) {
+			key.key = elms[i].key ^ 0x1;
+			(void)CH_FIND(elm_tbl, &head, &key);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "find-miss", n, NULL);
+
+	bench_start(&b);
+	for (i = 0; i < n; i++)
+		if (CH_REMOVE(elm_tbl, &head, &elms[i]) != &elms[i])
+			errx(1, "remove %llu failed", (unsigned long long)i);
+	bench_stop(&b);
+	bench_report(&b, "remove", n, NULL);
+
+	CH_DESTROY(elm_tbl, &head);
+	free(idx);
+	free(elms);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char	*errstr;
+	uint64_t	 n, max = 1000000;
+	int		 ch;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			max = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "max is %s: %s", errstr, optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	for (n = 10000; n <= max; n *= 10)
+		bench_size(n);
+	printf("bench=chash op=maxrss kb=%ld\n", bench_maxrss());
+
+	return 0;
+}
+
+CH_GENERATE(elm_tbl, elm, elm_cmp, elm_hash);
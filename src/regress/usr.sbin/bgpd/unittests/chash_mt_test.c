@@ -0,0 +1,248 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Stress test for concurrent chash tables. Readers look up a set of stable
+ * keys which must always be found, keys which are never inserted and keys
+ * which writers insert and remove all the time. The churn causes sub table
+ * splits, merges and resizes of the extendible hash while readers run.
+ */
+#include <sys/param.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "chash.h"
+
+#define NSTABLE		20000
+#define NCHURN		40000
+#define NREADER		4
+#define NWRITER		2
+#define RUNTIME		2
+
+struct peer {
+	uint32_t	id;
+	uint32_t	check;
+};
+
+static uint64_t
+hash64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint64_t
+peer_hash(const struct peer *p)
+{
+	return hash64(p->id);
+}
+
+static inline int
+peer_cmp(const struct peer *l, const struct peer *r)
+{
+	return l->id == r->id;
+}
+
+CH_HEAD(test, peer);
+CH_PROTOTYPE(test, peer, peer_hash);
+
+static struct test	head = CH_INITIALIZER(head);
+static struct peer	stable[NSTABLE];
+static volatile int	done;
+
+struct stats {
+	pthread_t	thread;
+	uint64_t	ops;
+	uint32_t	seed;
+};
+
+static struct peer *
+lookup(uint32_t id)
+{
+	struct peer needle = { .id = id };
+
+	return CH_FIND(test, &head, &needle);
+}
+
+static void *
+reader(void *arg)
+{
+	struct stats	*st = arg;
+	struct peer	*p;
+	uint32_t	 r, id, e;
+
+	while (!done) {
+		r = arc4random();
+		/* the element may only be touched inside the read section */
+		e = CH_READ_BEGIN(test, &head);
+		switch (r % 3) {
+		case 0:
+			id = r % NSTABLE;
+			if ((p = lookup(id)) == NULL || p->id != id)
+				errx(1, "stable key %u not found", id);
+			break;
+		case 1:
+			/* churn keys, if found it must be the right one */
+			id = NSTABLE + r % NCHURN;
+			if ((p = lookup(id)) != NULL &&
+			    (p->id != id || p->check != ~id))
+				errx(1, "churn key %u corrupt", id);
+			break;
+		case 2:
+			/* never inserted */
+			id = NSTABLE + NCHURN + r % NSTABLE;
+			if (lookup(id) != NULL)
+				errx(1, "absent key %u found", id);
+			break;
+		}
+		CH_READ_END(test, &head, e);
+		st->ops++;
+	}
+	return NULL;
+}
+
+static void *
+writer(void *arg)
+{
+	struct stats	*st = arg;
+	struct peer	*p, *dead[64], needle;
+	uint32_t	 i, n, id;
+	int		 ndead = 0;
+
+	while (!done) {
+		/* insert a batch to force splits, then remove it again */
+		for (i = 0; i < 512; i++) {
+			id = NSTABLE + (st->seed + i) % NCHURN;
+			if ((p = malloc(sizeof(*p))) == NULL)
+				err(1, NULL);
+			p->id = id;
+			p->check = ~id;
+			if (CH_INSERT(test, &head, p, NULL) != 1)
+				free(p);
+			st->ops++;
+		}
+		for (i = 0; i < 512; i++) {
+			needle.id = NSTABLE + (st->seed + i) % NCHURN;
+			if ((p = CH_REMOVE(test, &head, &needle)) != NULL) {
+				dead[ndead++] = p;
+				if (ndead == nitems(dead)) {
+					CH_SYNCHRONIZE(test, &head);
+					for (n = 0; n < ndead; n++)
+						free(dead[n]);
+					ndead = 0;
+				}
+			}
+			st->ops++;
+		}
+		st->seed += 4099;
+	}
+	CH_SYNCHRONIZE(test, &head);
+	for (n = 0; n < ndead; n++)
+		free(dead[n]);
+	return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct stats	 readers[NREADER], writers[NWRITER];
+	struct peer	*p, **left;
+	struct ch_iter	 iter;
+	uint64_t	 rops = 0, wops = 0;
+	uint32_t	 i, n, e, nleft = 0;
+
+	printf("testing CH_INIT_CONCURRENT: ");
+	if (CH_INIT_CONCURRENT(test, &head) == -1)
+		err(1, "CH_INIT_CONCURRENT");
+	for (i = 0; i < NSTABLE; i++) {
+		stable[i].id = i;
+		stable[i].check = ~i;
+		if (CH_INSERT(test, &head, &stable[i], NULL) != 1)
+			errx(1, "insert %u failed", i);
+	}
+	printf("OK\n");
+
+	printf("testing concurrent lookups: ");
+	fflush(stdout);
+	for (i = 0; i < NREADER; i++) {
+		readers[i].ops = 0;
+		if (pthread_create(&readers[i].thread, NULL, reader,
+		    &readers[i]) != 0)
+			errx(1, "pthread_create");
+	}
+	for (i = 0; i < NWRITER; i++) {
+		writers[i].ops = 0;
+		writers[i].seed = i * NCHURN / NWRITER;
+		if (pthread_create(&writers[i].thread, NULL, writer,
+		    &writers[i]) != 0)
+			errx(1, "pthread_create");
+	}
+	sleep(RUNTIME);
+	done = 1;
+	for (i = 0; i < NREADER; i++) {
+		pthread_join(readers[i].thread, NULL);
+		rops += readers[i].ops;
+	}
+	for (i = 0; i < NWRITER; i++) {
+		pthread_join(writers[i].thread, NULL);
+		wops += writers[i].ops;
+	}
+	printf("OK, %llu lookups/s %llu updates/s\n",
+	    (unsigned long long)rops / RUNTIME,
+	    (unsigned long long)wops / RUNTIME);
+
+	printf("testing table after churn: ");
+	e = CH_READ_BEGIN(test, &head);
+	for (i = 0; i < NSTABLE; i++)
+		if (lookup(i) != &stable[i])
+			errx(1, "stable key %u lost", i);
+	CH_READ_END(test, &head, e);
+	/* collect leftover churn elements, the walk must not see removals */
+	if ((left = calloc(NCHURN, sizeof(*left))) == NULL)
+		err(1, NULL);
+	n = 0;
+	CH_FOREACH(p, test, &head, &iter) {
+		if (p->id >= NSTABLE)
+			left[nleft++] = p;
+		else
+			n++;
+	}
+	if (n != NSTABLE)
+		errx(1, "wrong element count %u", n);
+	for (i = 0; i < nleft; i++) {
+		if (CH_REMOVE(test, &head, left[i]) != left[i])
+			errx(1, "remove of %u failed", left[i]->id);
+		free(left[i]);
+	}
+	free(left);
+	CH_DESTROY(test, &head);
+	printf("OK\n");
+
+	return 0;
+}
+
+CH_GENERATE(test, peer, peer_cmp, peer_hash);
@@ -0,0 +1,254 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Compare the longest prefix match done by kroute_match() before and
+ * after the lpm index. The routes live in an RB tree like the kroute
+ * tree, the old way probes every prefix length from the longest to the
+ * shortest, the new way asks the lpm trie which lengths cover the address.
+ */
+#include <sys/tree.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bgpd.h"
+#include "bench.h"
+
+struct broute {
+	RB_ENTRY(broute)	entry;
+	uint8_t			addr[16];
+	uint8_t			plen;
+};
+
+static inline int
+broute_cmp(struct broute *a, struct broute *b)
+{
+	int r;
+
+	if ((r = memcmp(a->addr, b->addr, sizeof(a->addr))) != 0)
+		return r;
+	return (int)a->plen - (int)b->plen;
+}
+
+RB_HEAD(broute_tree, broute);
+RB_GENERATE_STATIC(broute_tree, broute, entry, broute_cmp);
+
+/* rough prefix length distribution of the IPv4 and IPv6 DFZ in percent */
+static const uint8_t dist4[][2] = {
+	{ 24, 58 }, { 22, 11 }, { 23, 9 }, { 21, 5 }, { 20, 5 }, { 19, 3 },
+	{ 16, 3 }, { 18, 2 }, { 17, 1 }, { 15, 1 }, { 14, 1 }, { 13, 1 }
+};
+static const uint8_t dist6[][2] = {
+	{ 48, 50 }, { 32, 10 }, { 44, 9 }, { 40, 8 }, { 36, 5 }, { 46, 4 },
+	{ 47, 3 }, { 29, 3 }, { 28, 2 }, { 45, 2 }, { 64, 2 }, { 33, 2 }
+};
+
+static void
+usage(void)
+{
+	extern char *__progname;
+	fprintf(stderr, "usage: %s [-n count]\n", __progname);
+	exit(1);
+}
+
+static void
+mask(uint8_t *addr, uint8_t plen)
+{
+	int i = plen / 8;
+
+	if (plen % 8 != 0)
+		addr[i++] &= 0xff << (8 - plen % 8);
+	for (; i < 16; i++)
+		addr[i] = 0;
+}
+
+static uint8_t
+randplen(const uint8_t (*dist)[2], size_t ndist)
+{
+	uint32_t	r = arc4random_uniform(100);
+	size_t		i;
+
+	for (i = 0; i < ndist; i++) {
+		if (r < dist[i][1])
+			return dist[i][0];
+		r -= dist[i][1];
+	}
+	return dist[0][0];
+}
+
+static struct broute *
+probe_match(struct broute_tree *t, const uint8_t *addr, uint8_t maxlen)
+{
+	struct broute	 s, *r;
+	int		 i;
+
+	for (i = maxlen; i >= 0; i--) {
+		memcpy(s.addr, addr, sizeof(s.addr));
+		mask(s.addr, i);
+		s.plen = i;
+		if ((r = RB_FIND(broute_tree, t, &s)) != NULL)
+			return r;
+	}
+	return NULL;
+}
+
+static struct broute *
+lpm_match(struct broute_tree *t, struct lpm_tree *lpm, const uint8_t *addr,
+    uint8_t maxlen)
+{
+	struct broute	 s, *r;
+	uint8_t		 plens[129];
+	int		 i;
+
+	i = lpm_lookup(lpm, addr, maxlen, plens);
+	while (--i >= 0) {
+		memcpy(s.addr, addr, sizeof(s.addr));
+		mask(s.addr, plens[i]);
+		s.plen = plens[i];
+		if ((r = RB_FIND(broute_tree, t, &s)) != NULL)
+			return r;
+	}
+	return NULL;
+}
+
+static void
+bench_family(const char *name, uint8_t maxlen, const uint8_t (*dist)[2],
+    size_t ndist, size_t n)
+{
+	struct bench		 b;
+	struct broute_tree	 tree = RB_INITIALIZER(&tree);
+	struct lpm_tree		 lpm = { 0 };
+	struct broute		*routes, *r, *x, *y;
+	uint8_t			*keys;
+	size_t			 i, nroutes = 0, hits = 0;
+	char			 extra[64];
+	int			 run;
+
+	if ((routes = calloc(n + 1, sizeof(*routes))) == NULL)
+		err(1, NULL);
+	if ((keys = calloc(n, 16)) == NULL)
+		err(1, NULL);
+
+	/* a default route plus n random prefixes, duplicates are skipped */
+	RB_INSERT(broute_tree, &tree, &routes[nroutes++]);
+	for (i = 0; i < n; i++) {
+		r = &routes[nroutes];
+		arc4random_buf(r->addr, maxlen / 8);
+		r->plen = randplen(dist, ndist);
+		mask(r->addr, r->plen);
+		if (RB_INSERT(broute_tree, &tree, r) == NULL)
+			nroutes++;
+	}
+
+	/* half of the keys fall into a known route, the rest is random */
+	for (i = 0; i < n; i++) {
+		arc4random_buf(keys + i * 16, maxlen / 8);
+		if (i % 2)
+			memcpy(keys + i * 16, routes[i % nroutes].addr,
+			    routes[i % nroutes].plen / 8);
+	}
+
+	bench_init(&b, "lpm");
+	for (run = 0; run < BENCH_RUNS; run++) {
+		lpm_flush(&lpm);
+		bench_start(&b);
+		for (i = 0; i < nroutes; i++)
+			if (lpm_insert(&lpm, routes[i].addr,
+			    routes[i].plen) == -1)
+				err(1, "lpm_insert");
+		bench_stop(&b);
+	}
+	snprintf(extra, sizeof(extra), "af=%s", name);
+	bench_report(&b, "insert", nroutes, extra);
+
+	/* verify that both methods agree before timing them */
+	for (i = 0; i < n; i++) {
+		x = probe_match(&tree, keys + i * 16, maxlen);
+		y = lpm_match(&tree, &lpm, keys + i * 16, maxlen);
+		if (x != y)
+			errx(1, "%s: lookup %zu mismatch", name, i);
+		if (x->plen != 0)
+			hits++;
+	}
+
+	snprintf(extra, sizeof(extra), "af=%s routes=%zu hits=%zu",
+	    name, nroutes, hits);
+	for (run = 0; run < BENCH_RUNS; run++) {
+		bench_start(&b);
+		for (i = 0; i < n; i++)
+			if (probe_match(&tree, keys + i * 16, maxlen) == NULL)
+				errx(1, "no default route");
+		bench_stop(&b);
+	}
+	bench_report(&b, "match_probe", n, extra);
+
+	for (run = 0; run < BENCH_RUNS; run++) {
+		bench_start(&b);
+		for (i = 0; i < n; i++)
+			if (lpm_match(&tree, &lpm, keys + i * 16,
+			    maxlen) == NULL)
+				errx(1, "no default route");
+		bench_stop(&b);
+	}
+	bench_report(&b, "match_lpm", n, extra);
+
+	bench_start(&b);
+	for (i = 0; i < nroutes; i++)
+		lpm_remove(&lpm, routes[i].addr, routes[i].plen);
+	bench_stop(&b);
+	if (lpm.root != NULL)
+		errx(1, "%s: lpm not empty", name);
+	bench_report(&b, "remove", nroutes, extra);
+
+	free(keys);
+	free(routes);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char	*errstr;
+	size_t		 n = 1000000;
+	int		 ch;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			n = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "count is %s: %s", errstr, optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 0)
+		usage();
+
+	bench_family("inet", 32, dist4, nitems(dist4), n);
+	bench_family("inet6", 128, dist6, nitems(dist6), n / 4);
+	printf("bench=lpm op=maxrss kb=%ld\n", bench_maxrss());
+
+	return 0;
+}
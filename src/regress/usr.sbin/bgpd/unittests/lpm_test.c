@@ -0,0 +1,174 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bgpd.h"
+
+#define NPREFIX		4000
+#define NLOOKUP		5000
+
+struct pfx {
+	uint8_t		addr[16];
+	uint8_t		plen;
+	int		refcnt;
+};
+
+static struct pfx	pfxs[NPREFIX];
+
+static void
+mask(uint8_t *addr, uint8_t plen, uint8_t maxlen)
+{
+	int i;
+
+	for (i = plen; i < maxlen; i++)
+		addr[i / 8] &= ~(0x80 >> (i % 8));
+}
+
+static int
+covers(const struct pfx *p, const uint8_t *addr, uint8_t maxlen)
+{
+	uint8_t a[16];
+
+	memcpy(a, addr, sizeof(a));
+	mask(a, p->plen, maxlen);
+	return memcmp(a, p->addr, sizeof(a)) == 0;
+}
+
+static struct pfx *
+find(const uint8_t *addr, uint8_t plen, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		if (pfxs[i].plen == plen &&
+		    memcmp(pfxs[i].addr, addr, sizeof(pfxs[i].addr)) == 0)
+			return &pfxs[i];
+	return NULL;
+}
+
+/* random address, the first byte is fixed to get lots of overlap */
+static void
+randaddr(uint8_t *addr, uint8_t maxlen)
+{
+	memset(addr, 0, 16);
+	arc4random_buf(addr, maxlen / 8);
+	addr[0] = 10;
+	/* reduce entropy so prefixes nest */
+	addr[1] &= 0x0f;
+}
+
+static void
+check(struct lpm_tree *t, size_t n, uint8_t maxlen)
+{
+	uint8_t	addr[16], plens[129], expect[129], found[129];
+	size_t	i, j;
+	int	cnt, ecnt, l;
+
+	for (i = 0; i < NLOOKUP; i++) {
+		if (i % 2)
+			randaddr(addr, maxlen);
+		else {
+			/* lookup an address inside a known prefix */
+			memcpy(addr, pfxs[i % n].addr, sizeof(addr));
+			addr[maxlen / 8 - 1] |= arc4random() & 0xff;
+		}
+		memset(found, 0, sizeof(found));
+		for (j = 0; j < n; j++)
+			if (pfxs[j].refcnt > 0 &&
+			    covers(&pfxs[j], addr, maxlen))
+				found[pfxs[j].plen] = 1;
+		ecnt = 0;
+		for (l = 0; l <= maxlen; l++)
+			if (found[l])
+				expect[ecnt++] = l;
+		cnt = lpm_lookup(t, addr, maxlen, plens);
+		if (cnt != ecnt || memcmp(plens, expect, cnt) != 0)
+			errx(1, "lookup mismatch, got %d expected %d prefixes",
+			    cnt, ecnt);
+	}
+}
+
+static void
+run(uint8_t maxlen)
+{
+	struct lpm_tree	 t = { 0 };
+	struct pfx	*p;
+	uint8_t		 addr[16], plen;
+	size_t		 i, n = 0;
+
+	printf("testing lpm_insert/%u: ", maxlen); fflush(stdout);
+	for (i = 0; i < NPREFIX; i++) {
+		randaddr(addr, maxlen);
+		plen = arc4random_uniform(maxlen + 1);
+		mask(addr, plen, maxlen);
+		if ((p = find(addr, plen, n)) == NULL) {
+			p = &pfxs[n++];
+			memcpy(p->addr, addr, sizeof(p->addr));
+			p->plen = plen;
+			p->refcnt = 0;
+		}
+		p->refcnt++;
+		if (lpm_insert(&t, addr, plen) == -1)
+			err(1, "lpm_insert");
+	}
+	check(&t, n, maxlen);
+	printf("OK\n");
+
+	printf("testing lpm_remove/%u: ", maxlen); fflush(stdout);
+	for (i = 0; i < n; i += 2) {
+		pfxs[i].refcnt--;
+		lpm_remove(&t, pfxs[i].addr, pfxs[i].plen);
+	}
+	/* removing a prefix that is not present must not change anything */
+	randaddr(addr, maxlen);
+	if (find(addr, maxlen, n) == NULL)
+		lpm_remove(&t, addr, maxlen);
+	check(&t, n, maxlen);
+	printf("OK\n");
+
+	printf("testing lpm_remove all/%u: ", maxlen); fflush(stdout);
+	for (i = 0; i < n; i++) {
+		while (pfxs[i].refcnt > 0) {
+			pfxs[i].refcnt--;
+			lpm_remove(&t, pfxs[i].addr, pfxs[i].plen);
+		}
+	}
+	if (t.root != NULL)
+		errx(1, "trie not empty");
+	printf("OK\n");
+
+	printf("testing lpm_flush/%u: ", maxlen); fflush(stdout);
+	for (i = 0; i < n; i++)
+		if (lpm_insert(&t, pfxs[i].addr, pfxs[i].plen) == -1)
+			err(1, "lpm_insert");
+	lpm_flush(&t);
+	if (t.root != NULL)
+		errx(1, "trie not empty");
+	printf("OK\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	run(32);
+	run(128);
+	return 0;
+}
@@ -0,0 +1,380 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <limits.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <util.h>
+
+#include "rde_aspa.c"
+#include "bench.h"
+
+#define MAXPATH		64
+#define MAXPROV		16
+#define NTIER1		20
+
+struct rde_memstats rdemem;
+
+struct aset {
+	uint32_t	cas;
+	uint32_t	npas;
+	uint32_t	pas[MAXPROV];
+};
+
+static struct aset	*asets;
+static size_t		 nasets, asetsize;
+static struct aspath	**paths;
+static size_t		 npaths, pathsize;
+
+static void
+usage(void)
+{
+	extern char *__progname;
+	fprintf(stderr, "usage: %s [-n count] [-a aspafile] [-p pathfile]\n",
+	    __progname);
+	exit(1);
+}
+
+static struct aset *
+aset_new(uint32_t cas)
+{
+	if (nasets == asetsize) {
+		asetsize = asetsize == 0 ? 1024 : asetsize * 2;
+		asets = reallocarray(asets, asetsize, sizeof(*asets));
+		if (asets == NULL)
+			err(1, NULL);
+	}
+	memset(&asets[nasets], 0, sizeof(asets[nasets]));
+	asets[nasets].cas = cas;
+	return &asets[nasets++];
+}
+
+static void
+path_push(const uint32_t *asns, uint32_t cnt)
+{
+	struct aspath *a;
+	uint32_t i, as;
+	uint16_t len;
+
+	if (cnt == 0 || cnt >= 255)
+		return;
+	len = 2 + sizeof(uint32_t) * cnt;
+	if ((a = malloc(ASPATH_HEADER_SIZE + len)) == NULL)
+		err(1, NULL);
+	a->len = len;
+	a->ascnt = cnt;
+	a->source_as = asns[cnt - 1];
+	a->data[0] = AS_SEQUENCE;
+	a->data[1] = cnt;
+	for (i = 0; i < cnt; i++) {
+		as = htonl(asns[i]);
+		memcpy(a->data + 2 + sizeof(as) * i, &as, sizeof(as));
+	}
+
+	if (npaths == pathsize) {
+		pathsize = pathsize == 0 ? 1024 : pathsize * 2;
+		paths = reallocarray(paths, pathsize, sizeof(*paths));
+		if (paths == NULL)
+			err(1, NULL);
+	}
+	paths[npaths++] = a;
+}
+
+/*
+ * Parse an aspa-set as written by rpki-client(8) for bgpd:
+ *	customer-as C [expires T] provider-as { P1 P2 ... }
+ */
+static void
+parse_aspa_file(FILE *in)
+{
+	const char *errstr;
+	char *line, *s, *p;
+	struct aset *as;
+	uint32_t asnum;
+	int state;
+
+	while ((line = fparseln(in, NULL, NULL, NULL, FPARSELN_UNESCALL))) {
+		as = NULL;
+		state = 0;
+		for (p = line; (s = strsep(&p, " \t,")) != NULL; ) {
+			if (*s == '\0' || strcmp(s, "{") == 0 ||
+			    strcmp(s, "}") == 0)
+				continue;
+			if (strcmp(s, "customer-as") == 0) {
+				state = 1;
+				continue;
+			}
+			if (strcmp(s, "provider-as") == 0) {
+				state = 2;
+				continue;
+			}
+			if (strcmp(s, "expires") == 0) {
+				state = 3;
+				continue;
+			}
+			if (state != 1 && state != 2)
+				continue;
+			asnum = strtonum(s, 0, UINT_MAX, &errstr);
+			if (errstr != NULL)
+				errx(1, "asnum is %s: %s", errstr, s);
+			if (state == 1)
+				as = aset_new(asnum);
+			else if (as != NULL && as->npas < MAXPROV)
+				as->pas[as->npas++] = asnum;
+		}
+		free(line);
+	}
+}
+
+/* one AS_PATH per line, leftmost AS is the neighbor */
+static void
+parse_path_file(FILE *in)
+{
+	const char *errstr;
+	char *line, *s, *p;
+	uint32_t asns[MAXPATH], cnt;
+
+	while ((line = fparseln(in, NULL, NULL, NULL, FPARSELN_UNESCALL))) {
+		cnt = 0;
+		for (p = line; (s = strsep(&p, " \t")) != NULL; ) {
+			if (*s == '\0' || cnt >= MAXPATH)
+				continue;
+			asns[cnt] = strtonum(s, 1, UINT_MAX, &errstr);
+			if (errstr == NULL)
+				cnt++;
+		}
+		path_push(asns, cnt);
+		free(line);
+	}
+}
+
+/*
+ * Build a provider hierarchy where providers always have a lower AS number
+ * than their customers. AS 1 to NTIER1 are transit free.
+ */
+static void
+generate_aspa(uint32_t count)
+{
+	struct aset *as;
+	uint32_t i, j;
+
+	for (i = 1; i <= count; i++) {
+		as = aset_new(i);
+		if (i <= NTIER1) {
+			as->pas[as->npas++] = 0;
+			continue;
+		}
+		as->npas = 1 + arc4random_uniform(4);
+		for (j = 0; j < as->npas; j++)
+			as->pas[j] = 1 + arc4random_uniform(i - 1);
+	}
+}
+
+static uint32_t
+walk_up(uint32_t as, uint32_t *asns, uint32_t max)
+{
+	uint32_t cnt = 0;
+
+	asns[cnt++] = as;
+	while (as > NTIER1 && cnt < max) {
+		as = asets[as - 1].pas[arc4random_uniform(asets[as - 1].npas)];
+		asns[cnt++] = as;
+	}
+	return cnt;
+}
+
+/*
+ * Valley free paths: up from the neighbor to a tier1 and down to the origin.
+ * Every 10th path is random and will most likely be unknown or invalid.
+ */
+static void
+generate_paths(uint32_t count, uint32_t nas)
+{
+	uint32_t up[MAXPATH / 2], down[MAXPATH / 2], path[MAXPATH];
+	uint32_t i, j, nup, ndown, cnt;
+
+	for (i = 0; i < count; i++) {
+		if (i % 10 == 9) {
+			cnt = 2 + arc4random_uniform(6);
+			for (j = 0; j < cnt; j++)
+				path[j] = 1 + arc4random_uniform(nas);
+			path_push(path, cnt);
+			continue;
+		}
+		nup = walk_up(1 + arc4random_uniform(nas), up, nitems(up));
+		ndown = walk_up(1 + arc4random_uniform(nas), down,
+		    nitems(down));
+		cnt = 0;
+		for (j = 0; j < nup; j++)
+			path[cnt++] = up[j];
+		for (j = ndown; j > 0; j--)
+			if (down[j - 1] != path[cnt - 1])
+				path[cnt++] = down[j - 1];
+		path_push(path, cnt);
+	}
+}
+
+static int
+aset_cmp(const void *a, const void *b)
+{
+	const struct aset *x = a, *y = b;
+
+	/* aspa_add_set() requires descending order */
+	if (x->cas > y->cas)
+		return -1;
+	if (x->cas < y->cas)
+		return 1;
+	return 0;
+}
+
+static struct rde_aspa *
+load_aspa(void)
+{
+	struct rde_aspa *ra;
+	size_t i, n = 0, data_size = 0;
+
+	for (i = 0; i < nasets; i++) {
+		if (i > 0 && asets[i].cas == asets[i - 1].cas)
+			continue;
+		data_size += asets[i].npas * sizeof(uint32_t);
+		n++;
+	}
+
+	ra = aspa_table_prep(n, data_size);
+	for (i = 0; i < nasets; i++) {
+		if (i > 0 && asets[i].cas == asets[i - 1].cas)
+			continue;
+		aspa_add_set(ra, asets[i].cas, asets[i].pas, asets[i].npas);
+	}
+	return ra;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct bench b;
+	struct rde_aspa *ra;
+	struct rde_aspa_state vstate;
+	const char *errstr;
+	FILE *in;
+	char extra[64];
+	size_t i, nvalid;
+	uint32_t count = 20000;
+	int ch, r;
+
+	while ((ch = getopt(argc, argv, "a:n:p:")) != -1) {
+		switch (ch) {
+		case 'a':
+			if ((in = fopen(optarg, "r")) == NULL)
+				err(1, "fopen(%s)", optarg);
+			parse_aspa_file(in);
+			fclose(in);
+			break;
+		case 'n':
+			count = strtonum(optarg, NTIER1 + 1, 10000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "count is %s: %s", errstr, optarg);
+			break;
+		case 'p':
+			if ((in = fopen(optarg, "r")) == NULL)
+				err(1, "fopen(%s)", optarg);
+			parse_path_file(in);
+			fclose(in);
+			break;
+		default:
+			usage();
+			/* NOTREACHED */
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 0)
+		usage();
+
+	if (nasets == 0)
+		generate_aspa(count);
+	else if (npaths == 0)
+		errx(1, "a path file is needed with an aspa file");
+	if (npaths == 0)
+		generate_paths(count * 10, nasets);
+	qsort(asets, nasets, sizeof(*asets), aset_cmp);
+
+	bench_init(&b, "aspa");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		ra = load_aspa();
+		bench_stop(&b);
+		if (r != BENCH_RUNS - 1)
+			aspa_table_free(ra);
+	}
+	snprintf(extra, sizeof(extra), "bytes=%lld", rdemem.aspa_size);
+	bench_report(&b, "load", nasets, extra);
+
+	nvalid = 0;
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < npaths; i++) {
+			aspa_validation(ra, paths[i], &vstate);
+			if (vstate.onlyup == ASPA_VALID)
+				nvalid++;
+		}
+		bench_stop(&b);
+	}
+	snprintf(extra, sizeof(extra), "valid=%zu", nvalid / BENCH_RUNS);
+	bench_report(&b, "validation", npaths, extra);
+
+	aspa_table_free(ra);
+	for (i = 0; i < npaths; i++)
+		free(paths[i]);
+	free(paths);
+	free(asets);
+
+	printf("bench=aspa op=maxrss kb=%ld\n", bench_maxrss());
+	return 0;
+}
+
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
+
+uint32_t
+aspath_extract(const void *seg, int pos)
+{
+	const u_char	*ptr = seg;
+	uint32_t	 as;
+
+	/* minimal pos check, return 0 since that is an invalid ASN */
+	if (pos < 0 || pos >= ptr[1])
+		return (0);
+	ptr += 2 + sizeof(uint32_t) * pos;
+	memcpy(&as, ptr, sizeof(uint32_t));
+	return (ntohl(as));
+}
@@ -0,0 +1,254 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Compare interning the optional attributes of an UPDATE one by one with
+ * attr_optadd() against attr_batch_add() and attr_batch_commit().
+ * The attribute table is filled with a population of attributes first,
+ * the UPDATEs then mostly hit existing attributes like on a busy RDE.
+ */
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rde.h"
+#include "bench.h"
+
+#define NUPDATES	200000
+
+struct rde_memstats rdemem;
+
+/*
+ * Rough share of UPDATEs carrying an attribute and the number of distinct
+ * values seen in a full table. The aggregator has the most distinct
+ * values, route reflection attributes only a few. pool 0 scales with -n.
+ */
+static const struct attrdist {
+	uint8_t		 flags;
+	uint8_t		 type;
+	uint16_t	 len;
+	uint8_t		 percent;
+	uint32_t	 pool;
+} dist[] = {
+	{ ATTR_WELL_KNOWN, ATTR_ATOMIC_AGGREGATE, 0, 10, 1 },
+	{ ATTR_OPTIONAL | ATTR_TRANSITIVE, ATTR_AGGREGATOR, 8, 25, 0 },
+	{ ATTR_OPTIONAL, ATTR_ORIGINATOR_ID, 4, 40, 64 },
+	{ ATTR_OPTIONAL, ATTR_CLUSTER_LIST, 8, 40, 16 },
+	{ ATTR_OPTIONAL | ATTR_TRANSITIVE, ATTR_OTC, 4, 8, 2000 },
+	{ ATTR_OPTIONAL | ATTR_TRANSITIVE, 40, 16, 2, 5000 },
+};
+
+struct upd {
+	const struct attrdist	*d[nitems(dist)];
+	const void		*data[nitems(dist)];
+	size_t			 n;
+};
+
+static void
+usage(void)
+{
+	extern char *__progname;
+	fprintf(stderr, "usage: %s [-n count]\n", __progname);
+	exit(1);
+}
+
+/* the attribute data of value k, the same k always gives the same data */
+static void
+value(uint8_t *buf, size_t len, uint32_t k)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (k >> (8 * (i % 4))) ^ (i / 4) * 0x5a;
+}
+
+/* skewed random value, a few values are much more popular than others */
+static uint32_t
+pick(uint32_t pool)
+{
+	uint32_t r = arc4random_uniform(pool);
+
+	if (arc4random_uniform(2))
+		r = arc4random_uniform(r + 1);
+	return r;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct bench		 b;
+	struct rde_aspath	*hold, asp;
+	struct attr_batch	 batch;
+	struct upd		*upds;
+	uint8_t			*data[nitems(dist)];
+	uint32_t		 pool[nitems(dist)], maxpool = 0, k;
+	const char		*errstr;
+	size_t			 i, j, nattr = 0, n = 1000000;
+	char			 extra[64];
+	int			 ch, r;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			n = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "count is %s: %s", errstr, optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 0)
+		usage();
+
+	attr_init();
+
+	/* build the attribute population and keep a reference on it */
+	for (j = 0; j < nitems(dist); j++) {
+		pool[j] = dist[j].pool != 0 ? dist[j].pool : n;
+		if (pool[j] > maxpool)
+			maxpool = pool[j];
+		if ((data[j] = calloc(pool[j], dist[j].len + 1)) == NULL)
+			err(1, NULL);
+		for (k = 0; k < pool[j]; k++)
+			value(data[j] + k * dist[j].len, dist[j].len, k);
+	}
+	if ((hold = calloc(maxpool, sizeof(*hold))) == NULL)
+		err(1, NULL);
+	for (k = 0; k < maxpool; k++)
+		for (j = 0; j < nitems(dist); j++)
+			if (k < pool[j] && attr_optadd(&hold[k], dist[j].flags,
+			    dist[j].type, data[j] + k * dist[j].len,
+			    dist[j].len) == -1)
+				errx(1, "attr_optadd");
+
+	if ((upds = calloc(NUPDATES, sizeof(*upds))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < NUPDATES; i++) {
+		for (j = 0; j < nitems(dist); j++) {
+			if (arc4random_uniform(100) >= dist[j].percent)
+				continue;
+			k = pick(pool[j]);
+			upds[i].d[upds[i].n] = &dist[j];
+			upds[i].data[upds[i].n] = data[j] + k * dist[j].len;
+			upds[i].n++;
+		}
+		nattr += upds[i].n;
+	}
+	snprintf(extra, sizeof(extra), "attrs=%u attrs_per_update=%.2f",
+	    maxpool, (double)nattr / NUPDATES);
+
+	memset(&asp, 0, sizeof(asp));
+	bench_init(&b, "attr");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < NUPDATES; i++) {
+			for (j = 0; j < upds[i].n; j++)
+				if (attr_optadd(&asp, upds[i].d[j]->flags,
+				    upds[i].d[j]->type, upds[i].data[j],
+				    upds[i].d[j]->len) == -1)
+					errx(1, "attr_optadd");
+			attr_freeall(&asp);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "optadd", nattr, extra);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < NUPDATES; i++) {
+			attr_batch_init(&batch);
+			for (j = 0; j < upds[i].n; j++)
+				if (attr_batch_add(&asp, &batch,
+				    upds[i].d[j]->flags, upds[i].d[j]->type,
+				    upds[i].data[j], upds[i].d[j]->len) == -1)
+					errx(1, "attr_batch_add");
+			attr_batch_commit(&asp, &batch);
+			attr_freeall(&asp);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "batch", nattr, extra);
+
+	if (rdemem.attr_cnt > maxpool * nitems(dist))
+		errx(1, "attributes leaked");
+	for (k = 0; k < maxpool; k++)
+		attr_freeall(&hold[k]);
+	if (rdemem.attr_cnt != 0)
+		errx(1, "attributes not freed");
+	printf("bench=attr op=maxrss kb=%ld\n", bench_maxrss());
+
+	free(upds);
+	free(hold);
+	for (j = 0; j < nitems(dist); j++)
+		free(data[j]);
+	return 0;
+}
+
+/*
+ * Helper functions need to link and run the benchmark.
+ */
+uint32_t
+rde_local_as(void)
+{
+	return 65000;
+}
+
+int
+as_set_match(const struct as_set *aset, uint32_t asnum)
+{
+	errx(1, __func__);
+}
+
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
+
+void
+log_warnx(const char *emsg, ...)
+{
+	va_list  ap;
+	va_start(ap, emsg);
+	vwarnx(emsg, ap);
+	va_end(ap);
+}
+
+void
+log_debug(const char *emsg, ...)
+{
+}
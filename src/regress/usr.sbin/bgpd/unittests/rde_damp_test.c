@@ -0,0 +1,377 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "rde_damp.c"
+
+struct rde_memstats rdemem;
+
+/* the test runs on a fake clock, starting at some random looking time */
+static long long	 clock_sec = 123457;
+
+static struct rde_peer	 peer;
+static struct pt_entry	*pt1, *pt2;
+
+static unsigned int	 reuse_cnt;
+static uint32_t		 reuse_path_id;
+static struct pt_entry	*reuse_pt;
+
+static const struct {
+	uint32_t	penalty;
+	uint32_t	dt;
+	uint32_t	expect;
+} decay_tests[] = {
+	{ 1000, 0, 1000 },
+	{ 1000, DAMP_HALFLIFE, 500 },
+	{ 1000, 2 * DAMP_HALFLIFE, 250 },
+	{ 2000, 3 * DAMP_HALFLIFE, 250 },
+	/* 1000 * 2^(-1/2) = 707.1 */
+	{ 1000, DAMP_HALFLIFE / 2, 707 },
+	/* 1000 * 2^(-3/2) = 353.6 */
+	{ 1000, 3 * DAMP_HALFLIFE / 2, 353 },
+	/* 12000 * 2^(-1/4) = 10090.9 */
+	{ 12000, DAMP_HALFLIFE / 4, 10090 },
+	{ 1000, 10 * DAMP_HALFLIFE, 0 },
+	{ UINT32_MAX / 2, 32 * DAMP_HALFLIFE, 0 },
+};
+
+static struct pt_entry *
+alloc_pt(void)
+{
+	struct pt_entry *pt;
+
+	if ((pt = calloc(1, sizeof(*pt))) == NULL)
+		err(1, NULL);
+	/* hold a reference so the dampening code never frees it */
+	return pt_ref(pt);
+}
+
+static void
+advance(long long sec)
+{
+	clock_sec += sec;
+}
+
+static uint32_t
+penalty(struct pt_entry *pt, uint32_t path_id)
+{
+	struct rde_damp *d;
+
+	if ((d = damp_lookup(&peer, path_id, pt)) == NULL)
+		return 0;
+	return damp_decay(d->penalty, damp_now() - d->lastupdate);
+}
+
+static void
+test_decay(void)
+{
+	size_t i;
+	uint32_t p, t;
+
+	printf("testing decay: ");
+	for (i = 0; i < nitems(decay_tests); i++) {
+		p = damp_decay(decay_tests[i].penalty, decay_tests[i].dt);
+		if (p != decay_tests[i].expect)
+			errx(1, "decay of %u over %us: expected %u got %u",
+			    decay_tests[i].penalty, decay_tests[i].dt,
+			    decay_tests[i].expect, p);
+	}
+
+	/* time_to is the inverse of decay, 900 * log2(2000 / 750) = 1273.6 */
+	t = damp_time_to(2000, DAMP_REUSE);
+	if (t < 1273 || t > 1273 + DAMP_HALFLIFE / 64 + 1)
+		errx(1, "time from 2000 to reuse: got %us", t);
+	if (damp_decay(2000, t) >= DAMP_REUSE ||
+	    damp_decay(2000, t - DAMP_HALFLIFE / 64) < DAMP_REUSE)
+		errx(1, "time from 2000 to reuse %us is off", t);
+	if (damp_time_to(500, DAMP_REUSE) != 0)
+		errx(1, "time to reuse for low penalty not 0");
+	printf("OK\n");
+}
+
+static void
+test_thresholds(void)
+{
+	uint32_t p;
+	int i;
+
+	printf("testing suppress and reuse: ");
+
+	/* 1000 + 500 stays below the suppress limit */
+	if (rde_damp_withdraw(&peer, 0, pt1) != 0)
+		errx(1, "suppressed after one withdraw");
+	if (rde_damp_update(&peer, 0, pt1, 1) != 0)
+		errx(1, "suppressed after withdraw and update");
+	if (penalty(pt1, 0) != DAMP_PENALTY_WITHDRAW + DAMP_PENALTY_CHANGE)
+		errx(1, "bad penalty %u after withdraw and update",
+		    penalty(pt1, 0));
+	/* readvertising the same path is not penalized */
+	if (rde_damp_update(&peer, 0, pt1, 0) != 0 ||
+	    penalty(pt1, 0) != DAMP_PENALTY_WITHDRAW + DAMP_PENALTY_CHANGE)
+		errx(1, "unchanged update was penalized");
+
+	/* 2500 is above the suppress limit */
+	if (rde_damp_withdraw(&peer, 0, pt1) != 1)
+		errx(1, "not suppressed above suppress limit");
+	if (rde_damp_suppressed(&peer, 0, pt1) != 1)
+		errx(1, "rde_damp_suppressed disagrees");
+	/* other path ids and prefixes are not affected */
+	if (rde_damp_suppressed(&peer, 1, pt1) != 0 ||
+	    rde_damp_suppressed(&peer, 0, pt2) != 0)
+		errx(1, "unrelated path suppressed");
+
+	/* one halflife later the penalty is 1250, still suppressed */
+	advance(DAMP_HALFLIFE);
+	if (rde_damp_update(&peer, 0, pt1, 0) != 1)
+		errx(1, "reused above the reuse limit");
+	if (penalty(pt1, 0) != 1250)
+		errx(1, "bad penalty %u after one halflife", penalty(pt1, 0));
+
+	/* 1250 drops below 750 after 900 * log2(1250 / 750) = 663s */
+	advance(650);
+	if (rde_damp_update(&peer, 0, pt1, 0) != 1)
+		errx(1, "reused too early at penalty %u", penalty(pt1, 0));
+	advance(30);
+	if (rde_damp_update(&peer, 0, pt1, 0) != 0)
+		errx(1, "not reused at penalty %u", penalty(pt1, 0));
+	if (rde_damp_suppressed(&peer, 0, pt1) != 0)
+		errx(1, "rde_damp_suppressed disagrees after reuse");
+
+	/* refreshes faster than the decay table resolution still decay */
+	p = penalty(pt1, 0);
+	for (i = 0; i < DAMP_HALFLIFE / 10; i++) {
+		advance(10);
+		rde_damp_update(&peer, 0, pt1, 0);
+	}
+	if (penalty(pt1, 0) < p / 2 - p / 64 ||
+	    penalty(pt1, 0) > p / 2 + p / 64)
+		errx(1, "penalty %u not halved by frequent refreshes",
+		    penalty(pt1, 0));
+
+	/* without the peer flag nothing is suppressed */
+	rde_damp_withdraw(&peer, 0, pt1);
+	rde_damp_withdraw(&peer, 0, pt1);
+	peer.flags &= ~PEERFLAG_DAMPENING;
+	if (rde_damp_suppressed(&peer, 0, pt1) != 0)
+		errx(1, "suppressed without dampening enabled");
+	peer.flags |= PEERFLAG_DAMPENING;
+
+	rde_damp_peer_flush(&peer, 0);
+	if (damp_cnt != 0)
+		errx(1, "entries left after flush");
+	rde_damp_peer_init(&peer);
+	printf("OK\n");
+}
+
+static void
+test_maxsuppress(void)
+{
+	struct rde_damp *d;
+	int i;
+
+	printf("testing max-suppress: ");
+
+	/* reuse * 2^(maxsuppress / halflife) = 750 * 16 */
+	if (damp_ceiling != DAMP_REUSE * 16 - 1)
+		errx(1, "bad ceiling %u", damp_ceiling);
+
+	for (i = 0; i < 100; i++)
+		rde_damp_withdraw(&peer, 0, pt1);
+	if (penalty(pt1, 0) != damp_ceiling)
+		errx(1, "penalty %u above ceiling", penalty(pt1, 0));
+	if ((d = damp_lookup(&peer, 0, pt1)) == NULL)
+		errx(1, "entry missing");
+	if (d->deadline != damp_now() + DAMP_MAXSUPPRESS)
+		errx(1, "reuse scheduled %us after max-suppress",
+		    d->deadline - damp_now() - DAMP_MAXSUPPRESS);
+
+	/* flapping hard suppresses no longer than max-suppress */
+	advance(DAMP_MAXSUPPRESS - 1);
+	if (penalty(pt1, 0) < DAMP_REUSE)
+		errx(1, "reusable before max-suppress");
+	advance(1);
+	if (rde_damp_update(&peer, 0, pt1, 0) != 0)
+		errx(1, "still suppressed after max-suppress");
+
+	/* a shorter max-suppress lowers the ceiling */
+	rde_damp_config(&(struct dampening_config){
+	    .halflife = DAMP_HALFLIFE, .maxsuppress = DAMP_HALFLIFE,
+	    .reuse = DAMP_REUSE, .suppress = DAMP_SUPPRESS });
+	if (damp_ceiling != DAMP_REUSE * 2 - 1)
+		errx(1, "bad ceiling %u for short max-suppress", damp_ceiling);
+	/* 1499 does not reach the suppress limit */
+	for (i = 0; i < 100; i++)
+		if (rde_damp_withdraw(&peer, 1, pt2) != 0)
+			errx(1, "suppressed below suppress limit");
+	rde_damp_config(&(struct dampening_config){
+	    .halflife = DAMP_HALFLIFE, .maxsuppress = DAMP_MAXSUPPRESS,
+	    .reuse = DAMP_REUSE, .suppress = DAMP_SUPPRESS });
+
+	rde_damp_peer_flush(&peer, 0);
+	rde_damp_peer_init(&peer);
+	printf("OK\n");
+}
+
+static void
+test_wheel(void)
+{
+	struct rde_damp *d;
+	uint32_t deadline, due;
+
+	printf("testing timer wheel: ");
+
+	/* empty wheel has no timeout */
+	if (rde_damp_timeout() != -1)
+		errx(1, "timeout on empty wheel");
+
+	rde_damp_withdraw(&peer, 7, pt2);
+	rde_damp_withdraw(&peer, 7, pt2);
+	rde_damp_withdraw(&peer, 7, pt2);
+	if (rde_damp_suppressed(&peer, 7, pt2) != 1)
+		errx(1, "not suppressed");
+	if ((d = damp_lookup(&peer, 7, pt2)) == NULL)
+		errx(1, "entry missing");
+	deadline = d->deadline;
+	if (deadline != damp_now() + damp_time_to(3000, DAMP_REUSE))
+		errx(1, "bad deadline");
+	/* the wheel runs in ticks, entries are handled at the next tick */
+	due = (deadline + DAMP_WHEEL_TICK - 1) / DAMP_WHEEL_TICK *
+	    DAMP_WHEEL_TICK;
+
+	if (rde_damp_timeout() < 0 ||
+	    rde_damp_timeout() > DAMP_WHEEL_TICK * 1000)
+		errx(1, "bad timeout %d", rde_damp_timeout());
+
+	/* run the wheel every few seconds up to just before the deadline */
+	while (damp_now() + 7 < deadline) {
+		advance(7);
+		rde_damp_run();
+	}
+	advance(deadline - 1 - damp_now());
+	rde_damp_run();
+	if (reuse_cnt != 0)
+		errx(1, "reused before the deadline");
+
+	advance(due - damp_now());
+	rde_damp_run();
+	if (reuse_cnt != 1)
+		errx(1, "not reused at the deadline");
+	if (reuse_pt != pt2 || reuse_path_id != 7)
+		errx(1, "wrong path reused");
+	if (rde_damp_suppressed(&peer, 7, pt2) != 0)
+		errx(1, "still suppressed after reuse");
+	if (penalty(pt2, 7) >= DAMP_REUSE)
+		errx(1, "reused with penalty %u", penalty(pt2, 7));
+
+	/* the entry is forgotten once the penalty is below reuse / 2 */
+	if ((d = damp_lookup(&peer, 7, pt2)) == NULL)
+		errx(1, "entry missing after reuse");
+	deadline = d->deadline;
+	if (deadline <= damp_now() || deadline > damp_now() + DAMP_HALFLIFE)
+		errx(1, "bad removal deadline");
+	due = (deadline + DAMP_WHEEL_TICK - 1) / DAMP_WHEEL_TICK *
+	    DAMP_WHEEL_TICK;
+	advance(deadline - 1 - damp_now());
+	rde_damp_run();
+	if (damp_cnt != 1)
+		errx(1, "entry removed too early");
+	advance(due - damp_now());
+	rde_damp_run();
+	if (damp_cnt != 0)
+		errx(1, "entry not removed");
+	if (rde_damp_timeout() != -1)
+		errx(1, "timeout on empty wheel");
+
+	/* a long pause still expires everything */
+	rde_damp_withdraw(&peer, 7, pt2);
+	rde_damp_withdraw(&peer, 7, pt2);
+	rde_damp_withdraw(&peer, 7, pt2);
+	advance(10 * DAMP_HALFLIFE);
+	rde_damp_run();
+	if (reuse_cnt != 2)
+		errx(1, "not reused after long pause");
+	advance(DAMP_WHEEL_TICK);
+	rde_damp_run();
+	if (damp_cnt != 0)
+		errx(1, "entry not removed after long pause");
+	printf("OK\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	pt1 = alloc_pt();
+	pt2 = alloc_pt();
+	peer.flags = PEERFLAG_DAMPENING;
+
+	rde_damp_init();
+	rde_damp_peer_init(&peer);
+
+	test_decay();
+	test_thresholds();
+	test_maxsuppress();
+	test_wheel();
+
+	rde_damp_peer_flush(&peer, 0);
+	printf("OK\n");
+	return 0;
+}
+
+/*
+ * Helper functions need to link and run the tests.
+ */
+monotime_t
+getmonotime(void)
+{
+	return monotime_from_sec(clock_sec);
+}
+
+void
+rde_update_reuse(struct rde_peer *p, uint32_t path_id, struct pt_entry *pt)
+{
+	if (p != &peer)
+		errx(1, "reuse for unknown peer");
+	reuse_cnt++;
+	reuse_path_id = path_id;
+	reuse_pt = pt;
+}
+
+void
+pt_remove(struct pt_entry *pt)
+{
+	errx(1, "pt_remove called");
+}
+
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
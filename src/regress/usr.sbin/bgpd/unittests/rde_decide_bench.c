@@ -0,0 +1,282 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rde.h"
+#include "bench.h"
+
+#define NOPS	200000		/* number of operations per measurement */
+
+struct rde_memstats rdemem;
+
+struct rib dummy_rib = {
+	.name = "regress RIB",
+	.flags = F_RIB_NOFIB,
+};
+
+struct pt_entry dummy_pt;
+struct rib_entry dummy_re = { .prefix = &dummy_pt };
+
+static const size_t npaths[] = { 1, 2, 5, 10, 50, 100, 200 };
+
+int	prefix_cmp(struct prefix *, struct prefix *, int *);
+void	prefix_insert(struct prefix *, struct prefix *, struct rib_entry *);
+void	prefix_remove(struct prefix *, struct rib_entry *);
+
+int	decision_flags = BGPD_FLAG_DECISION_ROUTEAGE;
+
+/*
+ * Create n paths that mostly tie on the first decision steps, like on a
+ * route server, so that prefix_cmp has to go deep into the process.
+ */
+static struct prefix *
+build_paths(size_t n)
+{
+	struct prefix	*p;
+	struct rde_peer	*peers;
+	struct rde_aspath *asp;
+	struct aspath	*a;
+	size_t		 i;
+
+	if ((p = calloc(n, sizeof(*p))) == NULL ||
+	    (peers = calloc(n, sizeof(*peers))) == NULL ||
+	    (asp = calloc(n, sizeof(*asp))) == NULL)
+		err(1, NULL);
+
+	for (i = 0; i < n; i++) {
+		if ((a = calloc(1, ASPATH_HEADER_SIZE + 2 + 4 * 4)) == NULL)
+			err(1, NULL);
+		a->ascnt = 2 + arc4random_uniform(3);
+		a->len = 2 + 4 * a->ascnt;
+		a->data[0] = AS_SEQUENCE;
+		a->data[1] = a->ascnt;
+		a->source_as = 64496 + arc4random_uniform(4);
+		a->data[5] = a->source_as & 0xff;
+
+		peers[i].conf.ebgp = arc4random_uniform(8) != 0;
+		peers[i].remote_bgpid = arc4random();
+		peers[i].remote_addr.aid = AID_INET;
+		peers[i].remote_addr.v4.s_addr = arc4random();
+
+		asp[i].aspath = a;
+		asp[i].lpref = arc4random_uniform(8) == 0 ? 50 : 100;
+		asp[i].med = arc4random_uniform(4) * 10;
+		asp[i].origin = ORIGIN_IGP;
+
+		p[i].re = &dummy_re;
+		p[i].aspath = &asp[i];
+		p[i].peer = &peers[i];
+		p[i].nhflags = NEXTHOP_VALID;
+		p[i].lastchange = monotime_from_sec(1610980000 +
+		    arc4random_uniform(3600));
+	}
+	return p;
+}
+
+static void
+free_paths(struct prefix *p, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		free(p[i].aspath->aspath);
+	free(p[0].aspath);
+	free(p[0].peer);
+	free(p);
+}
+
+static void
+bench_npaths(size_t n)
+{
+	struct bench	 b;
+	struct prefix	*p;
+	size_t		*order, *cmp;
+	size_t		 i, j, k, rounds;
+	char		 extra[32];
+	int		 r, sum = 0, testall;
+
+	p = build_paths(n);
+	if ((order = calloc(n, sizeof(*order))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < n; i++)
+		order[i] = i;
+	/* shuffle the insertion order */
+	for (i = n; i > 1; i--) {
+		j = arc4random_uniform(i);
+		k = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = k;
+	}
+	/* pairs of paths to compare, never compare a path with itself */
+	if ((cmp = calloc(NOPS * 2, sizeof(*cmp))) == NULL)
+		err(1, NULL);
+	for (i = 0; i < NOPS; i++) {
+		cmp[i * 2] = arc4random_uniform(n);
+		cmp[i * 2 + 1] = (cmp[i * 2] + 1 + arc4random_uniform(n)) % n;
+	}
+	rounds = NOPS / n;
+	if (rounds == 0)
+		rounds = 1;
+	snprintf(extra, sizeof(extra), "paths=%zu", n);
+
+	bench_init(&b, "decide");
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < NOPS; i++) {
+			j = cmp[i * 2];
+			k = cmp[i * 2 + 1];
+			sum += prefix_cmp(&p[j], j == k ? NULL : &p[k],
+			    &testall);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "prefix_cmp", NOPS, extra);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (j = 0; j < rounds; j++) {
+			for (i = 0; i < n; i++)
+				prefix_insert(&p[order[i]], NULL, &dummy_re);
+			for (i = 0; i < n; i++)
+				prefix_remove(&p[order[i]], &dummy_re);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "prefix_insert_remove", rounds * n, extra);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (j = 0; j < rounds; j++) {
+			for (i = 0; i < n; i++)
+				prefix_evaluate(&dummy_re, &p[order[i]], NULL);
+			for (i = 0; i < n; i++)
+				prefix_evaluate(&dummy_re, NULL, &p[order[i]]);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "prefix_evaluate", rounds * n * 2, extra);
+
+	if (!TAILQ_EMPTY(&dummy_re.prefix_h))
+		errx(1, "rib entry not empty");
+	if (sum == INT_MAX)
+		printf("%d\n", sum);
+	free(cmp);
+	free(order);
+	free_paths(p, n);
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t i;
+
+	TAILQ_INIT(&dummy_re.prefix_h);
+	for (i = 0; i < nitems(npaths); i++)
+		bench_npaths(npaths[i]);
+	printf("bench=decide op=maxrss kb=%ld\n", bench_maxrss());
+	return 0;
+}
+
+/* this function is called by prefix_cmp to alter the decision process */
+int
+rde_decisionflags(void)
+{
+	return decision_flags;
+}
+
+/*
+ * Helper functions need to link and run the benchmark.
+ */
+uint32_t
+rde_local_as(void)
+{
+	return 65000;
+}
+
+int
+rde_evaluate_all(void)
+{
+	return 0;
+}
+
+int
+as_set_match(const struct as_set *aset, uint32_t asnum)
+{
+	errx(1, __func__);
+}
+
+struct rib *
+rib_byid(uint16_t id)
+{
+	return &dummy_rib;
+}
+
+void
+rde_enqueue_updates(struct rib_entry *re, struct rde_peer *peer,
+    struct prefix *newpath, uint32_t old_pathid_tx, enum eval_mode mode)
+{
+	/* nothing */
+}
+
+void
+rde_send_kroute(struct rib *rib, struct prefix *new, struct prefix *old)
+{
+	/* nothing */
+}
+
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
+
+void
+log_warnx(const char *emsg, ...)
+{
+	va_list  ap;
+	va_start(ap, emsg);
+	vwarnx(emsg, ap);
+	va_end(ap);
+}
+
+void
+log_debug(const char *emsg, ...)
+{
+}
+
+void
+pt_getaddr(struct pt_entry *pte, struct bgpd_addr *addr)
+{
+}
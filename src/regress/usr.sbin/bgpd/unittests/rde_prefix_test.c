@@ -0,0 +1,376 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check the NLRI encoding of pt_writebuf() byte by byte, also when the
+ * prefix does not fit into what is left of the message.
+ */
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <arpa/inet.h>
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rde.h"
+
+struct rde_memstats rdemem;
+
+/* bytes already in the message before the NLRI */
+#define FILL	3
+
+enum {
+	PT_VPN4,
+	PT_VPN6,
+	PT_EVPN2,
+	PT_EVPN2_NOIP,
+	PT_EVPN3,
+	PT_FLOW4,
+	PT_FLOW6_LONG,
+	PT_MAX
+};
+
+static struct pt_entry	*pts[PT_MAX];
+
+#define RD_ASN	0x00, 0x00, 0xfd, 0xe8, 0x00, 0x00, 0x00, 0x64 /* 65000:100 */
+#define RD_IP	0x00, 0x01, 0xc0, 0x00, 0x02, 0x01, 0x00, 0x05 /* 192.0.2.1:5 */
+#define ESI	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99
+#define MAC	0x00, 0x1b, 0x21, 0x3a, 0x4b, 0x5c
+#define PATHID	0x00, 0x00, 0x00, 0x07
+
+/* 10.1.0.0/16 rd 65000:100 label 16 */
+static const uint8_t vpn4[] = {
+	104, 0x00, 0x01, 0x01, RD_ASN, 0x0a, 0x01
+};
+static const uint8_t vpn4_wd[] = {
+	104, 0x80, 0x00, 0x00, RD_ASN, 0x0a, 0x01
+};
+static const uint8_t vpn4_ap[] = {
+	PATHID, 104, 0x00, 0x01, 0x01, RD_ASN, 0x0a, 0x01
+};
+static const uint8_t vpn4_ap_wd[] = {
+	PATHID, 104, 0x80, 0x00, 0x00, RD_ASN, 0x0a, 0x01
+};
+
+/* 2001:db8:1::/48 rd 192.0.2.1:5 labels 16 32 */
+static const uint8_t vpn6[] = {
+	160, 0x00, 0x01, 0x00, 0x00, 0x02, 0x01, RD_IP,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01
+};
+static const uint8_t vpn6_wd[] = {
+	136, 0x80, 0x00, 0x00, RD_IP, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01
+};
+static const uint8_t vpn6_ap[] = {
+	PATHID, 160, 0x00, 0x01, 0x00, 0x00, 0x02, 0x01, RD_IP,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01
+};
+
+/* MAC/IP advertisement with 192.0.2.10 and label 16 */
+static const uint8_t evpn2[] = {
+	EVPN_ROUTE_TYPE_2, 37, RD_ASN, ESI, 0x00, 0x00, 0x00, 0x64,
+	48, MAC, 32, 0xc0, 0x00, 0x02, 0x0a, 0x00, 0x01, 0x01
+};
+static const uint8_t evpn2_ap[] = {
+	PATHID, EVPN_ROUTE_TYPE_2, 37, RD_ASN, ESI, 0x00, 0x00, 0x00, 0x64,
+	48, MAC, 32, 0xc0, 0x00, 0x02, 0x0a, 0x00, 0x01, 0x01
+};
+
+/* MAC only advertisement with label 16 */
+static const uint8_t evpn2_noip[] = {
+	EVPN_ROUTE_TYPE_2, 33, RD_ASN, ESI, 0x00, 0x00, 0x00, 0x64,
+	48, MAC, 0, 0x00, 0x01, 0x01
+};
+
+/* inclusive multicast route for 2001:db8::1 */
+static const uint8_t evpn3[] = {
+	EVPN_ROUTE_TYPE_3, 29, RD_ASN, 0x00, 0x00, 0x00, 0x64, 128,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+};
+
+/* destination 192.0.2.0/24 and protocol tcp */
+static const uint8_t flow4_data[] = {
+	0x01, 24, 0xc0, 0x00, 0x02, 0x03, 0x81, 0x06
+};
+static const uint8_t flow4[] = {
+	8, 0x01, 24, 0xc0, 0x00, 0x02, 0x03, 0x81, 0x06
+};
+static const uint8_t flow4_ap[] = {
+	PATHID, 8, 0x01, 24, 0xc0, 0x00, 0x02, 0x03, 0x81, 0x06
+};
+
+/* flowspec NLRI of 250 bytes needs the two byte length encoding */
+#define FLOW_LONG	250
+static uint8_t flow6_long[2 + FLOW_LONG] = { 0xf0, FLOW_LONG };
+
+struct writebuf_test {
+	const char	*name;
+	int		 pt;
+	int		 withdraw;
+	int		 add_path;
+	const uint8_t	*expect;
+	size_t		 len;
+} writebuf_tests[] = {
+	{ "vpn4", PT_VPN4, 0, 0, vpn4, sizeof(vpn4) },
+	{ "vpn4 withdraw", PT_VPN4, 1, 0, vpn4_wd, sizeof(vpn4_wd) },
+	{ "vpn4 add-path", PT_VPN4, 0, 1, vpn4_ap, sizeof(vpn4_ap) },
+	{ "vpn4 add-path withdraw", PT_VPN4, 1, 1, vpn4_ap_wd,
+	    sizeof(vpn4_ap_wd) },
+	{ "vpn6", PT_VPN6, 0, 0, vpn6, sizeof(vpn6) },
+	{ "vpn6 withdraw", PT_VPN6, 1, 0, vpn6_wd, sizeof(vpn6_wd) },
+	{ "vpn6 add-path", PT_VPN6, 0, 1, vpn6_ap, sizeof(vpn6_ap) },
+	{ "evpn type 2", PT_EVPN2, 0, 0, evpn2, sizeof(evpn2) },
+	{ "evpn type 2 withdraw", PT_EVPN2, 1, 0, evpn2, sizeof(evpn2) },
+	{ "evpn type 2 add-path", PT_EVPN2, 0, 1, evpn2_ap, sizeof(evpn2_ap) },
+	{ "evpn type 2 no ip", PT_EVPN2_NOIP, 0, 0, evpn2_noip,
+	    sizeof(evpn2_noip) },
+	{ "evpn type 3", PT_EVPN3, 0, 0, evpn3, sizeof(evpn3) },
+	{ "flowspec", PT_FLOW4, 0, 0, flow4, sizeof(flow4) },
+	{ "flowspec withdraw", PT_FLOW4, 1, 0, flow4, sizeof(flow4) },
+	{ "flowspec add-path", PT_FLOW4, 0, 1, flow4_ap, sizeof(flow4_ap) },
+	{ "flowspec long", PT_FLOW6_LONG, 0, 0, flow6_long,
+	    sizeof(flow6_long) },
+};
+
+static struct pt_entry *
+add_flow(uint8_t aid, const uint8_t *data, size_t len)
+{
+	struct flowspec *f;
+	struct pt_entry *pte;
+
+	if ((f = calloc(1, FLOWSPEC_SIZE + len)) == NULL)
+		err(1, NULL);
+	f->aid = aid;
+	f->len = len;
+	memcpy(f->data, data, len);
+	pte = pt_add_flow(f);
+	free(f);
+	return pt_ref(pte);
+}
+
+static void
+setup(void)
+{
+	struct bgpd_addr addr;
+	size_t i;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.aid = AID_VPN_IPv4;
+	addr.v4.s_addr = htonl(0x0a010203);
+	addr.rd = htobe64(0x0000fde800000064ULL);
+	addr.labellen = 3;
+	memcpy(addr.labelstack, "\x00\x01\x01", 3);
+	pts[PT_VPN4] = pt_ref(pt_add(&addr, 16));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.aid = AID_VPN_IPv6;
+	inet_pton(AF_INET6, "2001:db8:1:2::1", &addr.v6);
+	addr.rd = htobe64(0x0001c00002010005ULL);
+	addr.labellen = 6;
+	memcpy(addr.labelstack, "\x00\x01\x00\x00\x02\x01", 6);
+	pts[PT_VPN6] = pt_ref(pt_add(&addr, 48));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.aid = AID_EVPN;
+	addr.rd = htobe64(0x0000fde800000064ULL);
+	addr.labellen = 3;
+	memcpy(addr.labelstack, "\x00\x01\x01", 3);
+	addr.evpn.type = EVPN_ROUTE_TYPE_2;
+	addr.evpn.aid = AID_INET;
+	addr.evpn.v4.s_addr = htonl(0xc000020a);
+	addr.evpn.ethtag = htonl(100);
+	memcpy(addr.evpn.mac, "\x00\x1b\x21\x3a\x4b\x5c", ETHER_ADDR_LEN);
+	memcpy(addr.evpn.esi, "\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99",
+	    ESI_ADDR_LEN);
+	pts[PT_EVPN2] = pt_ref(pt_add(&addr, 32));
+
+	addr.evpn.aid = AID_UNSPEC;
+	addr.evpn.v4.s_addr = 0;
+	pts[PT_EVPN2_NOIP] = pt_ref(pt_add(&addr, 0));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.aid = AID_EVPN;
+	addr.rd = htobe64(0x0000fde800000064ULL);
+	addr.evpn.type = EVPN_ROUTE_TYPE_3;
+	addr.evpn.aid = AID_INET6;
+	inet_pton(AF_INET6, "2001:db8::1", &addr.evpn.v6);
+	addr.evpn.ethtag = htonl(100);
+	pts[PT_EVPN3] = pt_ref(pt_add(&addr, 128));
+
+	pts[PT_FLOW4] = add_flow(AID_FLOWSPECv4, flow4_data,
+	    sizeof(flow4_data));
+
+	for (i = 0; i < FLOW_LONG; i++)
+		flow6_long[2 + i] = i;
+	pts[PT_FLOW6_LONG] = add_flow(AID_FLOWSPECv6, flow6_long + 2,
+	    FLOW_LONG);
+}
+
+static void
+hexdump(const char *what, const uint8_t *data, size_t len)
+{
+	size_t i;
+
+	printf("%s:", what);
+	for (i = 0; i < len; i++)
+		printf(" %02x", data[i]);
+	printf("\n");
+}
+
+/*
+ * Write the prefix into a message that already holds FILL bytes and has
+ * room bytes left. Returns the result of pt_writebuf() and checks that
+ * the bytes before the NLRI are untouched.
+ */
+static int
+writebuf(struct writebuf_test *t, size_t room, struct ibuf **bufp)
+{
+	struct ibuf *buf;
+	int rv;
+
+	if ((buf = ibuf_open(FILL + room)) == NULL)
+		err(1, NULL);
+	if (ibuf_add(buf, "\xaa\xbb\xcc", FILL) == -1)
+		err(1, "ibuf_add");
+	rv = pt_writebuf(buf, pts[t->pt], t->withdraw, t->add_path, 7);
+	if (ibuf_size(buf) < FILL ||
+	    memcmp(ibuf_data(buf), "\xaa\xbb\xcc", FILL) != 0)
+		errx(1, "%s: message clobbered", t->name);
+	*bufp = buf;
+	return rv;
+}
+
+static int
+test_writebuf(struct writebuf_test *t)
+{
+	struct ibuf *buf;
+	size_t room, need;
+
+	/* withdraws keep 2 bytes free for the IPv4 path attribute length */
+	need = t->len + (t->withdraw ? 2 : 0);
+
+	/* plenty of room, the NLRI is appended to the message */
+	if (writebuf(t, 4096, &buf) == -1) {
+		printf("%s: failed with room left\n", t->name);
+		ibuf_free(buf);
+		return 1;
+	}
+	if (ibuf_size(buf) != FILL + t->len ||
+	    memcmp((uint8_t *)ibuf_data(buf) + FILL, t->expect, t->len) != 0) {
+		printf("%s: bad encoding\n", t->name);
+		hexdump("expected", t->expect, t->len);
+		hexdump("got", (uint8_t *)ibuf_data(buf) + FILL,
+		    ibuf_size(buf) - FILL);
+		ibuf_free(buf);
+		return 1;
+	}
+	ibuf_free(buf);
+
+	/* exactly enough room */
+	if (writebuf(t, need, &buf) == -1 || ibuf_size(buf) != FILL + t->len ||
+	    memcmp((uint8_t *)ibuf_data(buf) + FILL, t->expect, t->len) != 0) {
+		printf("%s: failed with exactly %zu bytes left\n", t->name,
+		    need);
+		ibuf_free(buf);
+		return 1;
+	}
+	ibuf_free(buf);
+
+	/* every shorter room fails and leaves the message as it was */
+	for (room = 0; room < need; room++) {
+		if (writebuf(t, room, &buf) != -1) {
+			printf("%s: did not fail with %zu bytes left\n",
+			    t->name, room);
+			ibuf_free(buf);
+			return 1;
+		}
+		if (ibuf_size(buf) != FILL) {
+			printf("%s: not truncated with %zu bytes left\n",
+			    t->name, room);
+			ibuf_free(buf);
+			return 1;
+		}
+		ibuf_free(buf);
+	}
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t i;
+	int failed = 0;
+
+	pt_init();
+	setup();
+
+	for (i = 0; i < nitems(writebuf_tests); i++) {
+		if (test_writebuf(&writebuf_tests[i]) != 0)
+			failed = 1;
+	}
+
+	for (i = 0; i < PT_MAX; i++)
+		pt_unref(pts[i]);
+	pt_shutdown();
+
+	if (failed)
+		errx(1, "pt_writebuf tests failed");
+	printf("OK\n");
+	return 0;
+}
+
+/*
+ * Helper functions need to link and run the tests.
+ */
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
+
+void
+log_warnx(const char *emsg, ...)
+{
+	va_list  ap;
+	va_start(ap, emsg);
+	vwarnx(emsg, ap);
+	va_end(ap);
+}
+
+void
+log_debug(const char *emsg, ...)
+{
+	va_list  ap;
+	va_start(ap, emsg);
+	vwarnx(emsg, ap);
+	va_end(ap);
+}
@@ -87,6 +87,33 @@ main(int argc, char **argv)
 	if (as_set_match(empty, 42))
 		errx(1, "as_set_match(empty, %u) matched but should not", 42);
 
+	/* runtime updates keep the set sorted */
+	if (set_insert(c->set, &vb[0]) != 0)
+		errx(1, "set_insert(c, %u) failed", vb[0]);
+	if (set_insert(c->set, &va[0]) != 0)
+		errx(1, "set_insert(c, %u) failed", va[0]);
+	if (set_insert(c->set, &vc[0]) != 1)
+		errx(1, "set_insert(c, %u) inserted a duplicate", vc[0]);
+	if (set_nmemb(c->set) != 3)
+		errx(1, "set_insert(c) bad nmemb %zu", set_nmemb(c->set));
+	if (!as_set_match(c, vb[0]) || !as_set_match(c, va[0]) ||
+	    !as_set_match(c, 42))
+		errx(1, "as_set_match(c) failed after set_insert");
+	if (set_delete(c->set, 42) != 0)
+		errx(1, "set_delete(c, %u) failed", 42);
+	if (set_delete(c->set, 42) != 1)
+		errx(1, "set_delete(c, %u) deleted twice", 42);
+	if (as_set_match(c, 42))
+		errx(1, "as_set_match(c, %u) matched after delete", 42);
+	if (!as_set_match(c, vb[0]) || !as_set_match(c, va[0]))
+		errx(1, "as_set_match(c) failed after set_delete");
+
+	for (i = 0; i < sizeof(va) / sizeof(va[0]); i++)
+		if (set_insert(empty->set, &va[i]) != 0)
+			errx(1, "set_insert(empty, %u) failed", va[i]);
+	if (!set_equal(empty->set, a->set))
+		errx(1, "set_equal(empty, a) non equal after set_insert");
+
 	as_sets_free(&as_sets);
 
 	printf("OK\n");
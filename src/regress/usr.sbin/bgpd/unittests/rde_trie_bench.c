@@ -0,0 +1,313 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include <err.h>
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <util.h>
+
+#include "bgpd.h"
+#include "rde.h"
+#include "bench.h"
+
+struct rde_memstats rdemem;
+
+struct roa	*roas;
+size_t		 nroas, roasize;
+
+static void
+usage(void)
+{
+	extern char *__progname;
+	fprintf(stderr, "usage: %s [-n count] [roafile]\n", __progname);
+	exit(1);
+}
+
+static void
+roa_push(struct roa *roa)
+{
+	struct bgpd_addr addr, masked;
+
+	if (nroas == roasize) {
+		roasize = roasize == 0 ? 1024 : roasize * 2;
+		if ((roas = reallocarray(roas, roasize, sizeof(*roas))) == NULL)
+			err(1, NULL);
+	}
+	/* the trie expects the prefix to be masked */
+	memset(&addr, 0, sizeof(addr));
+	addr.aid = roa->aid;
+	addr.v6 = roa->prefix.inet6;
+	applymask(&masked, &addr, roa->prefixlen);
+	roa->prefix.inet6 = masked.v6;
+	roas[nroas++] = *roa;
+}
+
+/*
+ * Parse a roa-set as written by rpki-client(8) for bgpd or the simplified
+ * format used by the rde_trie_test ROA inputs:
+ *	prefix [maxlen N] source-as AS [expires T]
+ */
+static void
+parse_roa_file(FILE *in)
+{
+	const char *errstr;
+	char *line, *s, *p, *slash;
+	struct roa roa;
+	int state;
+
+	while ((line = fparseln(in, NULL, NULL, NULL, FPARSELN_UNESCALL))) {
+		/* skip everything that is not a ROA, e.g. an aspa-set */
+		if (strchr(line, '/') == NULL) {
+			free(line);
+			continue;
+		}
+		memset(&roa, 0, sizeof(roa));
+		state = 0;
+		for (p = line; (s = strsep(&p, " \t,")) != NULL; ) {
+			if (*s == '\0' || strcmp(s, "{") == 0 ||
+			    strcmp(s, "}") == 0 || strcmp(s, "roa-set") == 0)
+				continue;
+			if (strcmp(s, "maxlen") == 0) {
+				state = 1;
+				continue;
+			}
+			if (strcmp(s, "source-as") == 0) {
+				state = 2;
+				continue;
+			}
+			if (strcmp(s, "expires") == 0) {
+				state = 3;
+				continue;
+			}
+			switch (state) {
+			case 0:
+				if ((slash = strchr(s, '/')) == NULL)
+					errx(1, "bad prefix %s", s);
+				*slash++ = '\0';
+				if (inet_pton(AF_INET, s,
+				    &roa.prefix.inet) == 1) {
+					roa.aid = AID_INET;
+					roa.prefixlen = strtonum(slash, 0,
+					    32, &errstr);
+				} else if (inet_pton(AF_INET6, s,
+				    &roa.prefix.inet6) == 1) {
+					roa.aid = AID_INET6;
+					roa.prefixlen = strtonum(slash, 0,
+					    128, &errstr);
+				} else
+					errx(1, "bad prefix %s", s);
+				if (errstr != NULL)
+					errx(1, "prefixlen is %s: %s", errstr,
+					    slash);
+				roa.maxlen = roa.prefixlen;
+				break;
+			case 1:
+				roa.maxlen = strtonum(s, 0, 128, &errstr);
+				if (errstr != NULL)
+					errx(1, "maxlen is %s: %s", errstr, s);
+				break;
+			case 2:
+				roa.asnum = strtonum(s, 0, UINT_MAX, &errstr);
+				if (errstr != NULL)
+					errx(1, "source-as is %s: %s", errstr,
+					    s);
+				break;
+			default:
+				break;
+			}
+		}
+		if (roa.aid != AID_UNSPEC)
+			roa_push(&roa);
+		free(line);
+	}
+}
+
+/* roughly the shape of the global ROA set: 80% IPv4, lengths /12 to /24 */
+static void
+generate_roas(size_t count)
+{
+	struct roa roa;
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		memset(&roa, 0, sizeof(roa));
+		if (arc4random_uniform(5) != 0) {
+			roa.aid = AID_INET;
+			roa.prefix.inet.s_addr = arc4random();
+			roa.prefixlen = 12 + arc4random_uniform(13);
+			roa.maxlen = roa.prefixlen +
+			    arc4random_uniform(25 - roa.prefixlen);
+		} else {
+			roa.aid = AID_INET6;
+			arc4random_buf(&roa.prefix.inet6,
+			    sizeof(roa.prefix.inet6));
+			roa.prefix.inet6.s6_addr[0] = 0x20;
+			roa.prefixlen = 29 + arc4random_uniform(20);
+			roa.maxlen = roa.prefixlen +
+			    arc4random_uniform(49 - roa.prefixlen);
+		}
+		roa.asnum = arc4random_uniform(400000) + 1;
+		roa_push(&roa);
+	}
+}
+
+static void
+roa2addr(const struct roa *roa, struct bgpd_addr *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->aid = roa->aid;
+	addr->v6 = roa->prefix.inet6;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct trie_head roath = { 0 }, setth = { 0 };
+	struct bench b;
+	struct bgpd_addr addr;
+	const char *errstr;
+	FILE *in;
+	char extra[32];
+	size_t i, count = 500000;
+	long rss;
+	int ch, r, sum = 0;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			count = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "count is %s: %s", errstr, optarg);
+			break;
+		default:
+			usage();
+			/* NOTREACHED */
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (argc > 1)
+		usage();
+	if (argc == 1) {
+		if ((in = fopen(argv[0], "r")) == NULL)
+			err(1, "fopen(%s)", argv[0]);
+		parse_roa_file(in);
+		fclose(in);
+	} else
+		generate_roas(count);
+
+	bench_init(&b, "trie");
+	rss = bench_maxrss();
+	for (r = 0; r < BENCH_RUNS; r++) {
+		if (r != 0)
+			trie_free(&roath);
+		bench_start(&b);
+		for (i = 0; i < nroas; i++)
+			if (trie_roa_add(&roath, &roas[i]) != 0)
+				errx(1, "trie_roa_add failed");
+		bench_stop(&b);
+	}
+	snprintf(extra, sizeof(extra), "rss_kb=%ld", bench_maxrss() - rss);
+	bench_report(&b, "roa_add", nroas, extra);
+
+	/* every ROA once with the right and once with a wrong origin */
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < nroas; i++) {
+			roa2addr(&roas[i], &addr);
+			sum += trie_roa_check(&roath, &addr, roas[i].maxlen,
+			    roas[i].asnum);
+			sum += trie_roa_check(&roath, &addr, roas[i].maxlen,
+			    roas[i].asnum + 1);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "roa_check", nroas * 2, NULL);
+
+	/* random /24 and /48, mostly not found */
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < nroas; i++) {
+			memset(&addr, 0, sizeof(addr));
+			if (i & 1) {
+				addr.aid = AID_INET;
+				addr.v4.s_addr = arc4random() & htonl(0xffffff00);
+				sum += trie_roa_check(&roath, &addr, 24, 1);
+			} else {
+				addr.aid = AID_INET6;
+				addr.v6.s6_addr[0] = 0x20;
+				arc4random_buf(&addr.v6.s6_addr[1], 5);
+				sum += trie_roa_check(&roath, &addr, 48, 1);
+			}
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "roa_check_random", nroas, NULL);
+
+	/* the same data as prefix-set with or-longer style ranges */
+	for (r = 0; r < BENCH_RUNS; r++) {
+		if (r != 0)
+			trie_free(&setth);
+		bench_start(&b);
+		for (i = 0; i < nroas; i++) {
+			roa2addr(&roas[i], &addr);
+			if (trie_add(&setth, &addr, roas[i].prefixlen,
+			    roas[i].prefixlen, roas[i].maxlen) != 0)
+				errx(1, "trie_add failed");
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "add", nroas, NULL);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < nroas; i++) {
+			roa2addr(&roas[i], &addr);
+			sum += trie_match(&setth, &addr, roas[i].maxlen, 0);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "match", nroas, NULL);
+
+	for (r = 0; r < BENCH_RUNS; r++) {
+		bench_start(&b);
+		for (i = 0; i < nroas; i++) {
+			roa2addr(&roas[i], &addr);
+			sum += trie_match(&setth, &addr, roas[i].prefixlen, 1);
+		}
+		bench_stop(&b);
+	}
+	bench_report(&b, "match_orlonger", nroas, NULL);
+
+	trie_free(&setth);
+	trie_free(&roath);
+	free(roas);
+
+	if (sum == 0)
+		printf("bench=trie op=none\n");
+	printf("bench=trie op=maxrss kb=%ld\n", bench_maxrss());
+	return 0;
+}
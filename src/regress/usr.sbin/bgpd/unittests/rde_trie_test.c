@@ -113,12 +113,13 @@ print_prefix(struct bgpd_addr *p)
 }
 
 static void
-parse_file(FILE *in, struct trie_head *th)
+parse_file(FILE *in, struct trie_head *th, int del)
 {
 	const char *errstr;
 	char *line, *s;
 	struct bgpd_addr prefix;
 	uint8_t plen;
+	int r;
 
 	while ((line = fparseln(in, NULL, NULL, NULL, FPARSELN_UNESCALL))) {
 		int state = 0;
@@ -159,7 +160,15 @@ parse_file(FILE *in, struct trie_head *th)
 		if (min == 255)
 			min = plen;
 
-		if (trie_add(th, &prefix, plen, min, max) != 0)
+		if (del) {
+			r = trie_del(th, &prefix, plen, min, max);
+			if (r == -1)
+				errx(1, "trie_del(%s, %u, %u, %u) failed",
+				    print_prefix(&prefix), plen, min, max);
+			if (r == 1)
+				printf("%s/%u %u %u not present\n",
+				    print_prefix(&prefix), plen, min, max);
+		} else if (trie_add(th, &prefix, plen, min, max) != 0)
 			errx(1, "trie_add(%s, %u, %u, %u) failed",
 			    print_prefix(&prefix), plen, min, max);
 
@@ -303,7 +312,8 @@ static void
 usage(void)
 {
 	extern char *__progname;
-	fprintf(stderr, "usage: %s [-or] prefixfile testfile\n", __progname);
+	fprintf(stderr, "usage: %s [-or] [-d delfile] prefixfile testfile\n",
+	    __progname);
 	exit(1);
 }
 
@@ -311,11 +321,16 @@ int
 main(int argc, char **argv)
 {
 	struct trie_head th = { 0 };
-	FILE *in, *tin;
+	FILE *in, *tin, *din = NULL;
 	int ch;
 
-	while ((ch = getopt(argc, argv, "or")) != -1) {
+	while ((ch = getopt(argc, argv, "d:or")) != -1) {
 		switch (ch) {
+		case 'd':
+			din = fopen(optarg, "r");
+			if (din == NULL)
+				err(1, "fopen(%s)", optarg);
+			break;
 		case 'o':
 			orlonger = 1;
 			break;
@@ -343,7 +358,12 @@ main(int argc, char **argv)
 	if (roa)
 		parse_roa_file(in, &th);
 	else
-		parse_file(in, &th);
+		parse_file(in, &th, 0);
+	if (din != NULL) {
+		if (roa)
+			errx(1, "-d can not be used with -r");
+		parse_file(din, &th, 1);
+	}
 	/* trie_dump(&th); */
 	if (trie_equal(&th, &th) == 0)
 		errx(1, "trie_equal failure");
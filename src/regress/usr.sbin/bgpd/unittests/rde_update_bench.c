@@ -0,0 +1,266 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Measure how fast NLRI are packed into UPDATE messages. A table of
+ * prefixes is written with pt_writebuf() into message sized buffers,
+ * a new message is started whenever the current one is full. The old
+ * way of encoding each prefix into a temporary ibuf first is the baseline.
+ */
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <err.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rde.h"
+#include "bench.h"
+
+/* UPDATE space left for NLRI after header, length fields and attributes */
+#define NLRI_SPACE	(MAX_PKTSIZE - 23 - 64)
+
+struct rde_memstats rdemem;
+
+/* rough prefix length distribution of the IPv4 and IPv6 DFZ in percent */
+static const uint8_t dist4[][2] = {
+	{ 24, 58 }, { 22, 11 }, { 23, 9 }, { 21, 5 }, { 20, 5 }, { 19, 3 },
+	{ 16, 3 }, { 18, 2 }, { 17, 1 }, { 15, 1 }, { 14, 1 }, { 13, 1 }
+};
+static const uint8_t dist6[][2] = {
+	{ 48, 50 }, { 32, 10 }, { 44, 9 }, { 40, 8 }, { 36, 5 }, { 46, 4 },
+	{ 47, 3 }, { 29, 3 }, { 28, 2 }, { 45, 2 }, { 64, 2 }, { 33, 2 }
+};
+
+static void
+usage(void)
+{
+	extern char *__progname;
+	fprintf(stderr, "usage: %s [-n count]\n", __progname);
+	exit(1);
+}
+
+static uint8_t
+randplen(const uint8_t (*dist)[2], size_t ndist)
+{
+	uint32_t	r = arc4random_uniform(100);
+	size_t		i;
+
+	for (i = 0; i < ndist; i++) {
+		if (r < dist[i][1])
+			return dist[i][0];
+		r -= dist[i][1];
+	}
+	return dist[0][0];
+}
+
+/* how pt_writebuf() encoded IPv4 and IPv6 prefixes before */
+static int
+writebuf_tmp(struct ibuf *buf, struct pt_entry *pte, int withdraw,
+    int add_path, uint32_t pathid)
+{
+	struct ibuf	*tmp;
+
+	if ((tmp = ibuf_dynamic(32, UINT16_MAX)) == NULL)
+		goto fail;
+	if (add_path)
+		if (ibuf_add_n32(tmp, pathid) == -1)
+			goto fail;
+	if (ibuf_add_n8(tmp, pte->prefixlen) == -1 ||
+	    ibuf_add(tmp, pte->data, PREFIX_SIZE(pte->prefixlen) - 1) == -1)
+		goto fail;
+	if (withdraw && ibuf_left(buf) < ibuf_size(tmp) + 2)
+		goto fail;
+	if (ibuf_add_ibuf(buf, tmp) == -1)
+		goto fail;
+	ibuf_free(tmp);
+	return 0;
+
+ fail:
+	ibuf_free(tmp);
+	return -1;
+}
+
+/* pack all prefixes into messages, returns the number of messages */
+static size_t
+pack(struct ibuf *buf, struct pt_entry **pts, size_t n, int add_path,
+    int (*writebuf)(struct ibuf *, struct pt_entry *, int, int, uint32_t))
+{
+	size_t	i, msgs = 1;
+
+	ibuf_truncate(buf, 0);
+	for (i = 0; i < n; i++) {
+		if (writebuf(buf, pts[i], 0, add_path, i) == 0)
+			continue;
+		/* message full, start the next one */
+		ibuf_truncate(buf, 0);
+		msgs++;
+		if (writebuf(buf, pts[i], 0, add_path, i) == -1)
+			errx(1, "prefix does not fit into empty message");
+	}
+	return msgs;
+}
+
+static void
+bench_family(const char *name, uint8_t aid, const uint8_t (*dist)[2],
+    size_t ndist, size_t n)
+{
+	struct bench		 b;
+	struct bgpd_addr	 addr;
+	struct pt_entry		**pts, *pte;
+	struct ibuf		*buf, *check;
+	size_t			 i, npts = 0, msgs = 0, bytes;
+	uint8_t			 plen;
+	char			 extra[64];
+	int			 run, ap;
+
+	if ((pts = calloc(n, sizeof(*pts))) == NULL)
+		err(1, NULL);
+	if ((buf = ibuf_open(NLRI_SPACE)) == NULL ||
+	    (check = ibuf_dynamic(0, 64 * n)) == NULL)
+		err(1, NULL);
+
+	for (i = 0; i < n; i++) {
+		memset(&addr, 0, sizeof(addr));
+		addr.aid = aid;
+		plen = randplen(dist, ndist);
+		if (aid == AID_INET) {
+			arc4random_buf(&addr.v4, sizeof(addr.v4));
+			inet4applymask(&addr.v4, &addr.v4, plen);
+		} else {
+			arc4random_buf(&addr.v6, sizeof(addr.v6));
+			inet6applymask(&addr.v6, &addr.v6, plen);
+		}
+		if (pt_get(&addr, plen) != NULL)
+			continue;
+		pte = pt_add(&addr, plen);
+		pt_ref(pte);
+		pts[npts++] = pte;
+	}
+
+	/* both encodings need to produce the same bytes */
+	for (ap = 0; ap <= 1; ap++) {
+		ibuf_truncate(check, 0);
+		for (i = 0; i < npts; i++)
+			if (writebuf_tmp(check, pts[i], 0, ap, i) == -1)
+				errx(1, "writebuf_tmp");
+		bytes = ibuf_size(check);
+		for (i = 0; i < npts; i++)
+			if (pt_writebuf(check, pts[i], 0, ap, i) == -1)
+				errx(1, "pt_writebuf");
+		if (ibuf_size(check) != 2 * bytes ||
+		    memcmp(ibuf_data(check), (char *)ibuf_data(check) + bytes,
+		    bytes) != 0)
+			errx(1, "%s: encodings differ", name);
+	}
+
+	bench_init(&b, "update");
+	for (ap = 0; ap <= 1; ap++) {
+		for (run = 0; run < BENCH_RUNS; run++) {
+			bench_start(&b);
+			msgs = pack(buf, pts, npts, ap, writebuf_tmp);
+			bench_stop(&b);
+		}
+		snprintf(extra, sizeof(extra), "af=%s add_path=%d msgs=%zu",
+		    name, ap, msgs);
+		bench_report(&b, "nlri_tmp", npts, extra);
+
+		for (run = 0; run < BENCH_RUNS; run++) {
+			bench_start(&b);
+			msgs = pack(buf, pts, npts, ap, pt_writebuf);
+			bench_stop(&b);
+		}
+		snprintf(extra, sizeof(extra), "af=%s add_path=%d msgs=%zu",
+		    name, ap, msgs);
+		bench_report(&b, "nlri", npts, extra);
+	}
+
+	/* dropping the last reference removes the prefix */
+	for (i = 0; i < npts; i++)
+		pt_unref(pts[i]);
+	ibuf_free(check);
+	ibuf_free(buf);
+	free(pts);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char	*errstr;
+	size_t		 n = 1000000;
+	int		 ch;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			n = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr != NULL)
+				errx(1, "count is %s: %s", errstr, optarg);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 0)
+		usage();
+
+	pt_init();
+	bench_family("inet", AID_INET, dist4, nitems(dist4), n);
+	bench_family("inet6", AID_INET6, dist6, nitems(dist6), n / 4);
+	printf("bench=update op=maxrss kb=%ld\n", bench_maxrss());
+
+	return 0;
+}
+
+/*
+ * Helper functions need to link and run the benchmark.
+ */
+__dead void
+fatalx(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verrx(2, emsg, ap);
+}
+
+__dead void
+fatal(const char *emsg, ...)
+{
+	va_list ap;
+	va_start(ap, emsg);
+	verr(2, emsg, ap);
+}
+
+void
+log_warnx(const char *emsg, ...)
+{
+	va_list  ap;
+	va_start(ap, emsg);
+	vwarnx(emsg, ap);
+	va_end(ap);
+}
+
+void
+log_debug(const char *emsg, ...)
+{
+}
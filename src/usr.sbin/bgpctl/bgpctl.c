@@ -87,6 +87,7 @@ main(int argc, char *argv[])
 	struct network_config	 net;
 	struct parse_result	*res;
 	struct ctl_neighbor	 neighbor = { 0 };
+	struct ctl_set_update	 setupd;
 	struct ctl_show_rib_request	ribreq;
 	struct flowspec		*f;
 	char			*sockname;
@@ -263,10 +264,12 @@ main(int argc, char *argv[])
 		break;
 	case SHOW_METRICS:
 		output = &ometric_output;
-		numdone = 2;
+		numdone = 3;
 		imsg_compose(imsgbuf, IMSG_CTL_SHOW_NEIGHBOR, 0, 0, -1,
 		    NULL, 0);
 		imsg_compose(imsgbuf, IMSG_CTL_SHOW_RIB_MEM, 0, 0, -1, NULL, 0);
+		imsg_compose(imsgbuf, IMSG_CTL_SHOW_FIB_TABLES, 0, 0, -1,
+		    NULL, 0);
 		break;
 	case RELOAD:
 		imsg_compose(imsgbuf, IMSG_CTL_RELOAD, 0, 0, -1,
@@ -408,6 +411,32 @@ main(int argc, char *argv[])
 		imsg_compose(imsgbuf, IMSG_CTL_SHOW_FLOWSPEC, 0, 0, -1,
 		    &ribreq, sizeof(ribreq));
 		break;
+	case PREFIXSET_ADD:
+	case PREFIXSET_REMOVE:
+	case ASSET_ADD:
+	case ASSET_REMOVE:
+		memset(&setupd, 0, sizeof(setupd));
+		strlcpy(setupd.name, res->set_name, sizeof(setupd.name));
+		if (res->action == PREFIXSET_ADD ||
+		    res->action == PREFIXSET_REMOVE) {
+			setupd.type = PREFIX_SET;
+			setupd.prefix = res->addr;
+			setupd.prefixlen = res->prefixlen;
+			setupd.min = setupd.max = res->prefixlen;
+			if (res->flags & F_LONGER)
+				setupd.max = res->addr.aid == AID_INET ?
+				    32 : 128;
+		} else {
+			setupd.type = ASNUM_SET;
+			setupd.as = res->as.as_min;
+		}
+		if (res->action == PREFIXSET_ADD || res->action == ASSET_ADD)
+			imsg_compose(imsgbuf, IMSG_CTL_SET_ADD, 0, 0, -1,
+			    &setupd, sizeof(setupd));
+		else
+			imsg_compose(imsgbuf, IMSG_CTL_SET_DELETE, 0, 0, -1,
+			    &setupd, sizeof(setupd));
+		break;
 	case LOG_VERBOSE:
 		verbose = 1;
 		/* FALLTHROUGH */
@@ -761,6 +790,8 @@ fmt_flags(uint32_t flags, int sum)
 	if (sum) {
 		if (flags & F_PREF_FILTERED)
 			*p++ = 'F';
+		if (flags & F_PREF_DAMPENED)
+			*p++ = 'D';
 		if (flags & F_PREF_INVALID)
 			*p++ = 'E';
 		if (flags & F_PREF_OTC_LEAK)
@@ -789,6 +820,8 @@ fmt_flags(uint32_t flags, int sum)
 
 		if (flags & F_PREF_FILTERED)
 			strlcat(buf, ", filtered", sizeof(buf));
+		if (flags & F_PREF_DAMPENED)
+			strlcat(buf, ", dampened", sizeof(buf));
 		if (flags & F_PREF_INVALID)
 			strlcat(buf, ", invalid", sizeof(buf));
 		if (flags & F_PREF_OTC_LEAK)
@@ -849,6 +882,29 @@ fmt_mem(long long num)
 	return (buf);
 }
 
+/*
+ * Return the upper bound in usec of the histogram bucket holding the
+ * pct percentile of all samples.
+ */
+long long
+latency_percentile(const struct latency_hist *h, int pct)
+{
+	long long sum = 0, limit;
+	int b;
+
+	if (h->count == 0)
+		return 0;
+	limit = (h->count * pct + 99) / 100;
+	for (b = 0; b < LATENCY_BUCKETS - 1; b++) {
+		sum += h->buckets[b];
+		if (sum >= limit)
+			break;
+	}
+	if (b == LATENCY_BUCKETS - 1)
+		return h->max;
+	return 1LL << b;
+}
+
 const char *
 fmt_errstr(uint8_t errcode, uint8_t subcode)
 {
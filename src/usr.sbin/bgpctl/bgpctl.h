@@ -58,5 +58,6 @@ const char	*fmt_community(uint16_t, uint16_t);
 const char	*fmt_large_community(uint32_t, uint32_t, uint32_t);
 const char	*fmt_ext_community(uint64_t);
 const char	*fmt_set_type(struct ctl_show_set *);
+long long	 latency_percentile(const struct latency_hist *, int);
 
 #define MPLS_LABEL_OFFSET 12
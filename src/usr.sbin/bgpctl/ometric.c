@@ -49,6 +49,7 @@ enum ovalue_type {
 struct ovalue {
 	STAILQ_ENTRY(ovalue)	 entry;
 	struct olabels		*labels;
+	const char		*suffix;
 	union {
 		unsigned long long	i;
 		double			f;
@@ -357,7 +358,8 @@ ometric_output_value(FILE *out, const struct ovalue *ov)
 }
 
 static int
-ometric_output_name(FILE *out, const struct ometric *om)
+ometric_output_name(FILE *out, const struct ometric *om,
+    const struct ovalue *ov)
 {
 	const char *suffix;
 
@@ -368,6 +370,9 @@ ometric_output_name(FILE *out, const struct ometric *om)
 	case OMT_INFO:
 		suffix = "_info";
 		break;
+	case OMT_HISTOGRAM:
+		suffix = ov->suffix;
+		break;
 	default:
 		suffix = "";
 		break;
@@ -399,7 +404,7 @@ ometric_output_all(FILE *out)
 			return -1;
 
 		STAILQ_FOREACH(ov, &om->vals, entry) {
-			if (ometric_output_name(out, om) < 0)
+			if (ometric_output_name(out, om, ov) < 0)
 				return -1;
 			if (ometric_output_labels(out, ov->labels) < 0)
 				return -1;
@@ -418,7 +423,7 @@ ometric_output_all(FILE *out)
 /*
  * Value setters
  */
-static void
+static struct ovalue *
 ometric_set_int_value(struct ometric *om, uint64_t val, struct olabels *ol)
 {
 	struct ovalue *ov;
@@ -429,8 +434,10 @@ ometric_set_int_value(struct ometric *om, uint64_t val, struct olabels *ol)
 	ov->value.i = val;
 	ov->valtype = OVT_INTEGER;
 	ov->labels = olabels_ref(ol);
+	ov->suffix = NULL;
 
 	STAILQ_INSERT_TAIL(&om->vals, ov, entry);
+	return ov;
 }
 
 /*
@@ -462,6 +469,7 @@ ometric_set_float(struct ometric *om, double val, struct olabels *ol)
 	ov->value.f = val;
 	ov->valtype = OVT_DOUBLE;
 	ov->labels = olabels_ref(ol);
+	ov->suffix = NULL;
 
 	STAILQ_INSERT_TAIL(&om->vals, ov, entry);
 }
@@ -484,6 +492,7 @@ ometric_set_timespec(struct ometric *om, const struct timespec *ts,
 	ov->value.ts = *ts;
 	ov->valtype = OVT_TIMESPEC;
 	ov->labels = olabels_ref(ol);
+	ov->suffix = NULL;
 
 	STAILQ_INSERT_TAIL(&om->vals, ov, entry);
 }
@@ -569,3 +578,46 @@ ometric_set_timespec_with_labels(struct ometric *om, struct timespec *ts,
 	ometric_set_timespec(om, ts, extra);
 	olabels_free(extra);
 }
+
+/*
+ * Set a histogram. bounds holds the cnt upper bounds and buckets the number
+ * of samples per bucket (not cumulative). buckets has cnt + 1 elements, the
+ * last one holds the samples above the last bound. sum is the sum of all
+ * samples.
+ */
+void
+ometric_set_histogram(struct ometric *om, const double *bounds,
+    const uint64_t *buckets, size_t cnt, double sum, struct olabels *ol)
+{
+	struct olabels *extra;
+	struct ovalue *ov;
+	char le[32];
+	uint64_t total = 0;
+	size_t i;
+
+	if (om->type != OMT_HISTOGRAM)
+		errx(1, "%s incorrect ometric type", __func__);
+
+	for (i = 0; i <= cnt; i++) {
+		total += buckets[i];
+		if (i < cnt)
+			snprintf(le, sizeof(le), "%g", bounds[i]);
+		else
+			strlcpy(le, "+Inf", sizeof(le));
+		extra = olabels_add_extras(ol, OKV("le"), OKV(le));
+		ov = ometric_set_int_value(om, total, extra);
+		ov->suffix = "_bucket";
+		olabels_free(extra);
+	}
+
+	ov = ometric_set_int_value(om, total, ol);
+	ov->suffix = "_count";
+
+	if ((ov = malloc(sizeof(*ov))) == NULL)
+		err(1, NULL);
+	ov->value.f = sum;
+	ov->valtype = OVT_DOUBLE;
+	ov->labels = olabels_ref(ol);
+	ov->suffix = "_sum";
+	STAILQ_INSERT_TAIL(&om->vals, ov, entry);
+}
@@ -52,4 +52,6 @@ void	ometric_set_float_with_labels(struct ometric *, double, const char **,
 	    const char **, struct olabels *);
 void	ometric_set_timespec_with_labels(struct ometric *, struct timespec *,
 	    const char **, const char **, struct olabels *);
+void	ometric_set_histogram(struct ometric *, const double *,
+	    const uint64_t *, size_t, double, struct olabels *);
 #define OKV(...)		(const char *[]){ __VA_ARGS__, NULL }
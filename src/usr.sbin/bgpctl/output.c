@@ -68,7 +68,8 @@ show_head(struct parse_result *res)
 			break;
 		printf("flags: "
 		    "* = Valid, > = Selected, I = via IBGP, A = Announced,\n"
-		    "       S = Stale, E = Error, F = Filtered, L = Leaked\n");
+		    "       S = Stale, E = Error, F = Filtered, L = Leaked,"
+		    " D = Dampened\n");
 		printf("origin validation state: "
 		    "N = not-found, V = valid, ! = invalid\n");
 		printf("aspa validation state: "
@@ -207,6 +208,11 @@ show_neighbor_capa_restart(struct capabilities *capa)
 static void
 show_neighbor_msgstats(struct ctl_peer *p)
 {
+	static const char *qdelay_names[QDELAY_BUCKETS] = {
+	    "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"
+	};
+	int i;
+
 	printf("  Message statistics:\n");
 	printf("  %-15s %-10s %-10s\n", "", "Sent", "Received");
 	printf("  %-15s %10llu %10llu\n", "Opens",
@@ -255,6 +261,14 @@ show_neighbor_msgstats(struct ctl_peer *p)
 	    p->rde_stats.ibufq_msg_count, p->rde_stats.ibufq_payload_size);
 	printf("  %-15s %10llu %10s\n", "rib queue",
 	    p->rde_stats.rib_entry_count, "-");
+
+	printf("  Output queue delay:\n  ");
+	for (i = 0; i < QDELAY_BUCKETS; i++)
+		printf(" %10s", qdelay_names[i]);
+	printf("\n  ");
+	for (i = 0; i < QDELAY_BUCKETS; i++)
+		printf(" %10llu", p->stats.qdelay[i]);
+	printf("\n");
 }
 
 static void
@@ -1089,6 +1103,8 @@ show_rib_mem(struct rde_memstats *stats)
 	    sizeof(struct adjout_attr)));
 	printf("\t   and holding %lld references\n",
 	    stats->adjout_attr_refs);
+	printf("%10lld adjout attribute encodings using %s of memory\n",
+	    stats->adjout_attr_enc_cnt, fmt_mem(stats->adjout_attr_enc_size));
 	printf("%10lld BGP path attribute entries using %s of memory\n",
 	    stats->path_cnt, fmt_mem(stats->path_cnt *
 	    sizeof(struct rde_aspath)));
@@ -1140,6 +1156,7 @@ show_rib_mem(struct rde_memstats *stats)
 	    stats->prefix_cnt * sizeof(struct prefix) +
 	    stats->adjout_prefix_cnt * sizeof(struct adjout_prefix) +
 	    stats->adjout_attr_cnt * sizeof(struct adjout_attr) +
+	    stats->adjout_attr_enc_size +
 	    stats->pend_prefix_cnt * sizeof(struct pend_prefix) +
 	    stats->pend_attr_cnt * sizeof(struct pend_attr) +
 	    stats->rib_cnt * sizeof(struct rib_entry) +
@@ -1166,6 +1183,23 @@ show_rib_mem(struct rde_memstats *stats)
 	printf("%10lld usec spent on nexthops\n",
 	    stats->rde_event_nexthop_usec);
 	printf("%10lld usec spent on updates\n", stats->rde_event_update_usec);
+
+	printf("\nRDE softreconfig statistics\n");
+	printf("%10lld paths filtered\n", stats->rde_reconf_in_filtered);
+	printf("%10lld paths skipped\n", stats->rde_reconf_in_skipped);
+
+	printf("\nRDE latency statistics (usec)\n");
+	printf("%-12s %10s %8s %8s %8s %8s\n", "stage", "count", "avg",
+	    "p50", "p99", "max");
+	for (i = 0; i < RDE_LAT_MAX; i++) {
+		const struct latency_hist *h = &stats->rde_latency[i];
+
+		printf("%-12s %10lld %8lld %8lld %8lld %8lld\n",
+		    rde_latency_names[i], h->count,
+		    h->count ? h->sum / h->count : 0,
+		    latency_percentile(h, 50), latency_percentile(h, 99),
+		    h->max);
+	}
 }
 
 static void
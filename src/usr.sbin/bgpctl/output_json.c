@@ -141,6 +141,11 @@ json_neighbor_capabilities(struct capabilities *capa)
 static void
 json_neighbor_stats(struct ctl_peer *p)
 {
+	static const char *qdelay_names[QDELAY_BUCKETS] = {
+	    "lt_1ms", "lt_10ms", "lt_100ms", "lt_1s", "lt_10s", "ge_10s"
+	};
+	int i;
+
 	json_do_object("stats", 0);
 	json_do_string("last_read", fmt_monotime(p->stats.last_read));
 	json_do_int("last_read_sec", get_rel_monotime(p->stats.last_read));
@@ -226,6 +231,10 @@ json_neighbor_stats(struct ctl_peer *p)
 	json_do_object("size", 1);
 	json_do_uint("ibuf_queue", p->rde_stats.ibufq_payload_size);
 	json_do_end();
+	json_do_object("delay", 1);
+	for (i = 0; i < QDELAY_BUCKETS; i++)
+		json_do_uint(qdelay_names[i], p->stats.qdelay[i]);
+	json_do_end();
 
 	json_do_end();
 
@@ -426,6 +435,14 @@ json_fib_table(struct ktable *kt)
 	json_do_string("description", kt->descr);
 	json_do_bool("coupled", kt->fib_sync);
 	json_do_bool("admin_change", kt->fib_sync != kt->fib_conf);
+
+	json_do_object("latency", 0);
+	json_do_uint("count", kt->fib_latency.count);
+	json_do_uint("sum_usec", kt->fib_latency.sum);
+	json_do_uint("max_usec", kt->fib_latency.max);
+	json_do_uint("p50_usec", latency_percentile(&kt->fib_latency, 50));
+	json_do_uint("p99_usec", latency_percentile(&kt->fib_latency, 99));
+	json_do_end();
 	json_do_end();
 }
 
@@ -854,6 +871,8 @@ json_rib(struct ctl_show_rib *r, struct ibuf *asbuf, struct parse_result *res)
 	json_do_bool("valid", r->flags & F_PREF_ELIGIBLE);
 	if (r->flags & F_PREF_FILTERED)
 		json_do_bool("filtered", 1);
+	if (r->flags & F_PREF_DAMPENED)
+		json_do_bool("dampened", 1);
 	if (r->flags & F_PREF_BEST)
 		json_do_bool("best", 1);
 	if (r->flags & F_PREF_ECMP)
@@ -920,6 +939,8 @@ json_rib_mem(struct rde_memstats *stats)
 	json_rib_mem_element("adjout_attr", stats->adjout_attr_cnt,
 	    stats->adjout_attr_cnt * sizeof(struct adjout_attr),
 	    stats->adjout_attr_refs);
+	json_rib_mem_element("adjout_attr_enc", stats->adjout_attr_enc_cnt,
+	    stats->adjout_attr_enc_size, UINT64_MAX);
 	json_rib_mem_element("pend_attr", stats->pend_attr_cnt,
 	    stats->pend_attr_cnt * sizeof(struct pend_attr), UINT64_MAX);
 	json_rib_mem_element("pend_prefix", stats->pend_prefix_cnt,
@@ -945,6 +966,7 @@ json_rib_mem(struct rde_memstats *stats)
 	    pts + stats->prefix_cnt * sizeof(struct prefix) +
 	    stats->adjout_prefix_cnt * sizeof(struct adjout_prefix) +
 	    stats->adjout_attr_cnt * sizeof(struct adjout_attr) +
+	    stats->adjout_attr_enc_size +
 	    stats->pend_prefix_cnt * sizeof(struct pend_prefix) +
 	    stats->pend_attr_cnt * sizeof(struct pend_attr) +
 	    stats->rib_cnt * sizeof(struct rib_entry) +
@@ -993,6 +1015,25 @@ json_rib_mem(struct rde_memstats *stats)
 	json_do_uint("nexthop_usec", stats->rde_event_nexthop_usec);
 	json_do_uint("update_usec", stats->rde_event_update_usec);
 	json_do_end();
+
+	json_do_object("softreconfig", 0);
+	json_do_uint("paths_filtered", stats->rde_reconf_in_filtered);
+	json_do_uint("paths_skipped", stats->rde_reconf_in_skipped);
+	json_do_end();
+
+	json_do_object("latency", 0);
+	for (i = 0; i < RDE_LAT_MAX; i++) {
+		const struct latency_hist *h = &stats->rde_latency[i];
+
+		json_do_object(rde_latency_names[i], 0);
+		json_do_uint("count", h->count);
+		json_do_uint("sum_usec", h->sum);
+		json_do_uint("max_usec", h->max);
+		json_do_uint("p50_usec", latency_percentile(h, 50));
+		json_do_uint("p99_usec", latency_percentile(h, 99));
+		json_do_end();
+	}
+	json_do_end();
 }
 
 static void
@@ -51,6 +51,7 @@ struct ometric *rde_mem_size, *rde_mem_count, *rde_mem_ref_count;
 struct ometric *rde_set_size, *rde_set_count, *rde_table_count;
 struct ometric *rde_queue_size, *rde_queue_count;
 struct ometric *rde_evloop_count, *rde_evloop_time;
+struct ometric *rde_latency, *fib_latency;
 
 struct timespec start_time, end_time;
 
@@ -183,6 +184,10 @@ ometric_head(struct parse_result *arg)
 	    "bgpd_rde_evloop", "number of times the evloop ran");
 	rde_evloop_time = ometric_new(OMT_COUNTER,
 	    "bgpd_rde_evloop_seconds", "RDE evloop time usage");
+	rde_latency = ometric_new(OMT_HISTOGRAM,
+	    "bgpd_rde_latency_seconds", "RDE processing latency");
+	fib_latency = ometric_new(OMT_HISTOGRAM,
+	    "bgpd_fib_latency_seconds", "FIB route message latency");
 }
 
 static void
@@ -303,8 +308,10 @@ ometric_rib_mem_element(const char *v, uint64_t count, uint64_t size,
 static void
 ometric_rib_mem(struct rde_memstats *stats)
 {
+	double bounds[LATENCY_BUCKETS - 1];
+	uint64_t buckets[LATENCY_BUCKETS];
 	size_t pts = 0;
-	int i;
+	int i, j;
 
 	for (i = 0; i < AID_MAX; i++) {
 		if (stats->pt_cnt[i] == 0)
@@ -326,6 +333,8 @@ ometric_rib_mem(struct rde_memstats *stats)
 	ometric_rib_mem_element("adjout_attr", stats->adjout_attr_cnt,
 	    stats->adjout_attr_cnt * sizeof(struct adjout_attr),
 	    stats->adjout_attr_refs);
+	ometric_rib_mem_element("adjout_attr_enc", stats->adjout_attr_enc_cnt,
+	    stats->adjout_attr_enc_size, UINT64_MAX);
 	ometric_rib_mem_element("rde_aspath", stats->path_cnt,
 	    stats->path_cnt * sizeof(struct rde_aspath),
 	    stats->path_refs);
@@ -348,6 +357,7 @@ ometric_rib_mem(struct rde_memstats *stats)
 	    pts + stats->prefix_cnt * sizeof(struct prefix) +
 	    stats->adjout_prefix_cnt * sizeof(struct adjout_prefix) +
 	    stats->adjout_attr_cnt * sizeof(struct adjout_attr) +
+	    stats->adjout_attr_enc_size +
 	    stats->pend_prefix_cnt * sizeof(struct pend_prefix) +
 	    stats->pend_attr_cnt * sizeof(struct pend_attr) +
 	    stats->rib_cnt * sizeof(struct rib_entry) +
@@ -410,6 +420,43 @@ ometric_rib_mem(struct rde_memstats *stats)
 	ometric_set_float_with_labels(rde_evloop_time,
 	    (double)stats->rde_event_update_usec / (1000.0 * 1000.0) ,
 	    OKV("stage"), OKV("update"), NULL);
+
+	for (i = 0; i < LATENCY_BUCKETS - 1; i++)
+		bounds[i] = (double)(1LL << i) / (1000.0 * 1000.0);
+	for (i = 0; i < RDE_LAT_MAX; i++) {
+		const struct latency_hist *h = &stats->rde_latency[i];
+		struct olabels *ol;
+
+		for (j = 0; j < LATENCY_BUCKETS; j++)
+			buckets[j] = h->buckets[j];
+		ol = olabels_new(OKV("stage"), OKV(rde_latency_names[i]));
+		ometric_set_histogram(rde_latency, bounds, buckets,
+		    LATENCY_BUCKETS - 1, (double)h->sum / (1000.0 * 1000.0),
+		    ol);
+		olabels_free(ol);
+	}
+}
+
+static void
+ometric_fib_table(struct ktable *kt)
+{
+	struct olabels *ol;
+	double bounds[LATENCY_BUCKETS - 1];
+	uint64_t buckets[LATENCY_BUCKETS];
+	char id[16];
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS - 1; i++)
+		bounds[i] = (double)(1LL << i) / (1000.0 * 1000.0);
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		buckets[i] = kt->fib_latency.buckets[i];
+
+	snprintf(id, sizeof(id), "%u", kt->rtableid);
+	ol = olabels_new(OKV("rtable"), OKV(id));
+	ometric_set_histogram(fib_latency, bounds, buckets,
+	    LATENCY_BUCKETS - 1,
+	    (double)kt->fib_latency.sum / (1000.0 * 1000.0), ol);
+	olabels_free(ol);
 }
 
 static void
@@ -430,5 +477,6 @@ const struct output ometric_output = {
 	.head = ometric_head,
 	.neighbor = ometric_neighbor_stats,
 	.rib_mem = ometric_rib_mem,
+	.fib_table = ometric_fib_table,
 	.tail = ometric_tail,
 };
@@ -49,6 +49,7 @@ enum token_type {
 	PEERDESC,
 	GROUPDESC,
 	RIBNAME,
+	SETNAME,
 	COMMUNICATION,
 	COMMUNITY,
 	EXTCOMMUNITY,
@@ -125,13 +126,22 @@ static const struct token t_nexthop[];
 static const struct token t_pftable[];
 static const struct token t_log[];
 static const struct token t_communication[];
+static const struct token t_prefixset[];
+static const struct token t_prefixset_op[];
+static const struct token t_prefixset_prefix[];
+static const struct token t_prefixset_flags[];
+static const struct token t_asset[];
+static const struct token t_asset_op[];
+static const struct token t_asset_asnum[];
 
 static const struct token t_main[] = {
+	{ KEYWORD,	"as-set",	NONE,		t_asset},
 	{ KEYWORD,	"fib",		FIB,		t_fib},
 	{ KEYWORD,	"flowspec",	NONE,		t_flowspec},
 	{ KEYWORD,	"log",		NONE,		t_log},
 	{ KEYWORD,	"neighbor",	NEIGHBOR,	t_neighbor},
 	{ KEYWORD,	"network",	NONE,		t_network},
+	{ KEYWORD,	"prefix-set",	NONE,		t_prefixset},
 	{ KEYWORD,	"reload",	RELOAD,		t_communication},
 	{ KEYWORD,	"show",		SHOW,		t_show},
 	{ ENDTOKEN,	"",		NONE,		NULL}
@@ -180,6 +190,7 @@ static const struct token t_show_rib[] = {
 	{ KEYWORD,	"avs",		NONE,		t_show_avs},
 	{ FLAG,		"best",		F_CTL_BEST,	t_show_rib},
 	{ COMMUNITY,	"community",	NONE,		t_show_rib},
+	{ FLAG,		"dampened",	F_CTL_DAMPENED,	t_show_rib},
 	{ FLAG,		"detail",	F_CTL_DETAIL,	t_show_rib},
 	{ FLAG,		"disqualified",	F_CTL_INELIGIBLE, t_show_rib},
 	{ ASTYPE,	"empty-as",	AS_EMPTY,	t_show_rib},
@@ -416,6 +427,44 @@ static const struct token t_bulk[] = {
 	{ ENDTOKEN,	"",		NONE,			NULL}
 };
 
+static const struct token t_prefixset[] = {
+	{ SETNAME,	"",		NONE,		t_prefixset_op},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_prefixset_op[] = {
+	{ KEYWORD,	"add",		PREFIXSET_ADD,	t_prefixset_prefix},
+	{ KEYWORD,	"delete",	PREFIXSET_REMOVE, t_prefixset_prefix},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_prefixset_prefix[] = {
+	{ PREFIX,	"",		NONE,		t_prefixset_flags},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_prefixset_flags[] = {
+	{ NOTOKEN,	"",		NONE,		NULL},
+	{ FLAG,		"or-longer",	F_LONGER,	NULL},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_asset[] = {
+	{ SETNAME,	"",		NONE,		t_asset_op},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_asset_op[] = {
+	{ KEYWORD,	"add",		ASSET_ADD,	t_asset_asnum},
+	{ KEYWORD,	"delete",	ASSET_REMOVE,	t_asset_asnum},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
+static const struct token t_asset_asnum[] = {
+	{ ASNUM,	"",		NONE,		NULL},
+	{ ENDTOKEN,	"",		NONE,		NULL}
+};
+
 static const struct token t_prefix[] = {
 	{ PREFIX,	"",		NONE,		t_set},
 	{ ENDTOKEN,	"",		NONE,		NULL}
@@ -669,6 +718,16 @@ match_token(int argc, char *argv[], const struct token table[], int *argsused)
 				t = &table[i];
 			}
 			break;
+		case SETNAME:
+			if (!match && word != NULL && wordlen > 0) {
+				if (strlcpy(res.set_name, word,
+				    sizeof(res.set_name)) >=
+				    sizeof(res.set_name))
+					errx(1, "set name too long");
+				match++;
+				t = &table[i];
+			}
+			break;
 		case COMMUNICATION:
 			if (!match && word != NULL && wordlen > 0) {
 				if (strlcpy(res.reason, word,
@@ -903,6 +962,9 @@ show_valid_args(const struct token table[])
 		case RIBNAME:
 			fprintf(stderr, "  <rib name>\n");
 			break;
+		case SETNAME:
+			fprintf(stderr, "  <set name>\n");
+			break;
 		case COMMUNICATION:
 			fprintf(stderr, "  <reason>\n");
 			break;
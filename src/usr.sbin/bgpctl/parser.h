@@ -61,6 +61,10 @@ enum actions {
 	FLOWSPEC_REMOVE,
 	FLOWSPEC_FLUSH,
 	FLOWSPEC_SHOW,
+	PREFIXSET_ADD,
+	PREFIXSET_REMOVE,
+	ASSET_ADD,
+	ASSET_REMOVE,
 };
 
 struct parse_result {
@@ -72,6 +76,7 @@ struct parse_result {
 	char			 peerdesc[PEER_DESCR_LEN];
 	char			 rib[PEER_DESCR_LEN];
 	char			 reason[REASON_LEN];
+	char			 set_name[SET_NAME_LEN];
 	const char		*ext_comm_subtype;
 	uint64_t		 rd;
 	int			 flags;
@@ -597,11 +597,12 @@ send_config(struct bgpd_config *conf)
 	struct l3vpn		*vpn;
 	struct as_set		*aset;
 	struct prefixset	*ps;
-	struct prefixset_item	*psi, *npsi;
+	struct prefixset_item	*psi;
 	struct roa		*roa;
 	struct aspa_set		*aspa;
 	struct rtr_config	*rtr;
 	struct flowspec_config	*f, *nf;
+	struct ibuf		*batch = NULL;
 
 	reconfpending = 3;	/* one per child */
 
@@ -681,19 +682,35 @@ send_config(struct bgpd_config *conf)
 		}
 	}
 
-	/* prefixsets for filters in the RDE */
+	/*
+	 * prefixsets for filters in the RDE
+	 * Sets can have millions of entries, the items are sent in batches
+	 * using a compact encoding.
+	 */
 	while ((ps = SIMPLEQ_FIRST(&conf->prefixsets)) != NULL) {
+		struct prefixset_item_msg psim;
+
 		SIMPLEQ_REMOVE_HEAD(&conf->prefixsets, entry);
 		if (imsg_compose(ibuf_rde, IMSG_RECONF_PREFIX_SET, 0, 0, -1,
 		    ps->name, sizeof(ps->name)) == -1)
 			return (-1);
-		RB_FOREACH_SAFE(psi, prefixset_tree, &ps->psitems, npsi) {
-			RB_REMOVE(prefixset_tree, &ps->psitems, psi);
-			if (imsg_compose(ibuf_rde, IMSG_RECONF_PREFIX_SET_ITEM,
-			    0, 0, -1, psi, sizeof(*psi)) == -1)
+		RB_FOREACH(psi, prefixset_tree, &ps->psitems) {
+			memset(&psim, 0, sizeof(psim));
+			psim.aid = psi->p.addr.aid;
+			if (psim.aid == AID_INET6)
+				psim.addr.v6 = psi->p.addr.v6;
+			else
+				psim.addr.v4 = psi->p.addr.v4;
+			psim.len = psi->p.len;
+			psim.len_min = psi->p.len_min;
+			psim.len_max = psi->p.len_max;
+			if (imsg_batch_add(ibuf_rde, &batch,
+			    IMSG_RECONF_PREFIX_SET_ITEM, &psim,
+			    sizeof(psim)) == -1)
 				return (-1);
-			free(psi);
 		}
+		imsg_batch_close(ibuf_rde, &batch);
+		free_prefixtree(&ps->psitems);
 		free(ps);
 	}
 
@@ -704,20 +721,22 @@ send_config(struct bgpd_config *conf)
 		    ps->name, sizeof(ps->name)) == -1)
 			return (-1);
 		RB_FOREACH(roa, roa_tree, &ps->roaitems) {
-			if (imsg_compose(ibuf_rde, IMSG_RECONF_ROA_ITEM, 0, 0,
-			    -1, roa, sizeof(*roa)) == -1)
+			if (imsg_batch_add(ibuf_rde, &batch,
+			    IMSG_RECONF_ROA_ITEM, roa, sizeof(*roa)) == -1)
 				return (-1);
 		}
+		imsg_batch_close(ibuf_rde, &batch);
 		free_roatree(&ps->roaitems);
 		free(ps);
 	}
 
 	/* roa table, aspa table and rtr config are sent to the RTR engine */
 	RB_FOREACH(roa, roa_tree, &conf->roa) {
-		if (imsg_compose(ibuf_rtr, IMSG_RECONF_ROA_ITEM, 0, 0,
-		    -1, roa, sizeof(*roa)) == -1)
+		if (imsg_batch_add(ibuf_rtr, &batch, IMSG_RECONF_ROA_ITEM,
+		    roa, sizeof(*roa)) == -1)
 			return (-1);
 	}
+	imsg_batch_close(ibuf_rtr, &batch);
 	free_roatree(&conf->roa);
 	RB_FOREACH(aspa, aspa_tree, &conf->aspa) {
 		if (imsg_compose(ibuf_rtr, IMSG_RECONF_ASPA, 0, 0,
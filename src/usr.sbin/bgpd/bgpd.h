@@ -51,6 +51,7 @@
 #define	MAX_EXT_PKTSIZE			65535
 #define	MAX_ASPATH_COUNT		750	/* max # of asn in a path */
 #define	MAX_BGPD_IMSGSIZE		(128 * 1024)
+#define	IMSG_BATCH_SIZE			(16 * 1024)
 #define	MAX_SOCK_BUF			(4 * IBUF_READ_SIZE)
 #define	RT_BUF_SIZE			16384
 #define	MAX_RTSOCK_BUF			(2 * 1024 * 1024)
@@ -58,6 +59,7 @@
 #define	MAX_ASPA_SPAS_COUNT		10000
 #define	MAX_ADDPATH_COUNT		100
 #define	MIN_HOLDTIME			3
+#define	MAX_MRAI			600
 
 #define	BGPD_OPT_VERBOSE		0x0001
 #define	BGPD_OPT_VERBOSE2		0x0002
@@ -73,6 +75,7 @@
 #define	BGPD_FLAG_DECISION_MED_ALWAYS	0x0400
 #define	BGPD_FLAG_DECISION_ALL_PATHS	0x0800
 #define	BGPD_FLAG_PERMIT_AS_SET		0x1000
+#define	BGPD_FLAG_DAMPENING		0x2000
 
 #define	BGPD_LOG_UPDATES		0x0001
 
@@ -104,6 +107,7 @@
 #define	F_CTL_AVS_INVALID	0x2000000
 #define	F_CTL_AVS_UNKNOWN	0x4000000
 #define	F_CTL_FILTERED		0x8000000	/* only set on requests */
+#define	F_CTL_DAMPENED		0x10000000	/* only set on requests */
 #define	F_CTL_SSV		0x80000000	/* only used by bgpctl */
 
 #define CTASSERT(x)	extern char  _ctassert[(x) ? 1 : -1 ] \
@@ -139,6 +143,9 @@
 #define RDE_REAPER_ROUNDS	5000
 #define SESS_MSG_HIGH_MARK	2000
 #define SESS_MSG_LOW_MARK	500
+#define SESS_WBUF_BATCH		64	/* bulk messages in the write buffer */
+#define SESS_WRITE_ROUNDS	4	/* max write calls per POLLOUT */
+#define SESS_NOTSENT_LOWAT	(16 * 1024)
 #define CTL_MSG_HIGH_MARK	500
 #define CTL_MSG_LOW_MARK	100
 
@@ -325,6 +332,22 @@ TAILQ_HEAD(filter_head, filter_rule);
 struct rtr_config;
 SIMPLEQ_HEAD(rtr_config_head, rtr_config);
 
+/* route flap dampening, RFC 2439 */
+#define	DAMP_HALFLIFE			(15 * 60)
+#define	DAMP_MAXSUPPRESS		(60 * 60)
+#define	DAMP_REUSE			750
+#define	DAMP_SUPPRESS			2000
+#define	DAMP_PENALTY_MAX		20000
+#define	DAMP_PENALTY_WITHDRAW		1000
+#define	DAMP_PENALTY_CHANGE		500
+
+struct dampening_config {
+	uint32_t	halflife;	/* in seconds */
+	uint32_t	maxsuppress;	/* in seconds */
+	uint32_t	reuse;
+	uint32_t	suppress;
+};
+
 struct bgpd_config {
 	struct peer_head			 peers;
 	struct l3vpn_head			 l3vpns;
@@ -354,6 +377,7 @@ struct bgpd_config {
 	uint16_t				 min_holdtime;
 	uint16_t				 connectretry;
 	uint16_t				 staletime;
+	struct dampening_config			 damp;
 	uint8_t					 fib_priority;
 	uint8_t					 filtered_in_locrib;
 };
@@ -519,6 +543,7 @@ struct peer_config {
 	uint16_t		 min_holdtime;
 	uint16_t		 connectretry;
 	uint16_t		 staletime;
+	uint16_t		 mrai;
 	uint16_t		 local_short_as;
 	uint16_t		 remote_port;
 	uint8_t			 template;
@@ -542,6 +567,7 @@ struct peer_config {
 #define PEERFLAG_LOG_UPDATES	0x02
 #define PEERFLAG_EVALUATE_ALL	0x04
 #define PEERFLAG_PERMIT_AS_SET	0x08
+#define PEERFLAG_DAMPENING	0x10
 
 enum session_state {
 	STATE_NONE,
@@ -578,7 +604,10 @@ struct timer {
 	monotime_t		val;
 };
 
+#define QDELAY_BUCKETS		6	/* <1ms, <10ms, ..., <10s, more */
+
 struct peer_stats {
+	unsigned long long	 qdelay[QDELAY_BUCKETS];
 	unsigned long long	 msg_rcvd_open;
 	unsigned long long	 msg_rcvd_update;
 	unsigned long long	 msg_rcvd_notification;
@@ -775,6 +804,8 @@ enum imsg_type {
 	IMSG_CTL_LOG_VERBOSE,
 	IMSG_CTL_SHOW_FIB_TABLES,
 	IMSG_CTL_SHOW_SET,
+	IMSG_CTL_SET_ADD,
+	IMSG_CTL_SET_DELETE,
 	IMSG_CTL_SHOW_RTR,
 	IMSG_CTL_TERMINATE,
 	IMSG_NETWORK_ADD,
@@ -866,6 +897,7 @@ enum ctl_results {
 	CTL_RES_BADSTATE,
 	CTL_RES_NOSUCHRIB,
 	CTL_RES_OPNOTSUPP,
+	CTL_RES_NOSUCHSET,
 };
 
 /* needed for session.h parse prototype */
@@ -922,13 +954,52 @@ struct kredist_node;
 RB_HEAD(kroute_tree, kroute);
 RB_HEAD(kroute6_tree, kroute6);
 RB_HEAD(knexthop_tree, knexthop);
+RB_HEAD(knexthop_if_tree, knexthop);
 RB_HEAD(kredist_tree, kredist_node);
 
+struct lpm_node;
+struct lpm_tree {
+	struct lpm_node		*root;
+};
+
+/*
+ * Latency histograms use power of 2 buckets in usec. Bucket i holds all
+ * samples up to 2^i usec, the last bucket also holds all larger samples.
+ */
+#define LATENCY_BUCKETS		24
+
+struct latency_hist {
+	long long	count;
+	long long	sum;
+	long long	max;
+	long long	buckets[LATENCY_BUCKETS];
+};
+
+static inline void
+latency_add(struct latency_hist *h, monotime_t start)
+{
+	long long usec;
+	int b;
+
+	usec = monotime_to_usec(monotime_sub(getmonotime(), start));
+	for (b = 0; b < LATENCY_BUCKETS - 1; b++)
+		if (usec <= 1LL << b)
+			break;
+	h->buckets[b]++;
+	h->count++;
+	h->sum += usec;
+	if (usec > h->max)
+		h->max = usec;
+}
+
 struct ktable {
 	char			 descr[PEER_DESCR_LEN];
 	struct kroute_tree	 krt;
 	struct kroute6_tree	 krt6;
+	struct lpm_tree		 lpm;	/* prefix index of krt */
+	struct lpm_tree		 lpm6;	/* prefix index of krt6 */
 	struct knexthop_tree	 knt;
+	struct knexthop_if_tree	 kni;	/* knt sorted by ifindex */
 	struct kredist_tree	 kredist;
 	struct network_head	 krn;
 	u_int			 rtableid;
@@ -937,6 +1008,7 @@ struct ktable {
 	enum reconf_action	 state;
 	uint8_t			 fib_conf;  /* configured FIB sync flag */
 	uint8_t			 fib_sync;  /* is FIB synced with kernel? */
+	struct latency_hist	 fib_latency; /* route message write time */
 };
 
 struct kroute_full {
@@ -1021,6 +1093,16 @@ struct ctl_show_set {
 	}			type;
 };
 
+struct ctl_set_update {
+	char			name[SET_NAME_LEN];
+	struct bgpd_addr	prefix;
+	uint32_t		as;
+	int			type;	/* ASNUM_SET or PREFIX_SET */
+	uint8_t			prefixlen;
+	uint8_t			min;
+	uint8_t			max;
+};
+
 struct ctl_neighbor {
 	struct bgpd_addr	addr;
 	char			descr[PEER_DESCR_LEN];
@@ -1040,6 +1122,7 @@ struct ctl_neighbor {
 #define	F_PREF_ECMP	0x100
 #define	F_PREF_AS_WIDE	0x200
 #define	F_PREF_FILTERED	0x400
+#define	F_PREF_DAMPENED	0x800
 
 struct ctl_show_rib {
 	struct bgpd_addr	true_nexthop;
@@ -1426,6 +1509,18 @@ struct prefixset_item {
 	RB_ENTRY(prefixset_item)	entry;
 };
 
+/* compact form of a prefixset_item used in IMSG_RECONF_PREFIX_SET_ITEM */
+struct prefixset_item_msg {
+	union {
+		struct in_addr		v4;
+		struct in6_addr		v6;
+	}				addr;
+	uint8_t				aid;
+	uint8_t				len;
+	uint8_t				len_min;
+	uint8_t				len_max;
+};
+
 struct prefixset {
 	int				 sflags;
 	char				 name[SET_NAME_LEN];
@@ -1491,6 +1586,15 @@ extern struct rib_names ribnames;
 /* AS_NONE for origin validation */
 #define AS_NONE		0
 
+enum rde_latency {
+	RDE_LAT_UPDATE,
+	RDE_LAT_ADJOUT,
+	RDE_LAT_DECISION,
+	RDE_LAT_FILTER,
+	RDE_LAT_CONTROL,
+	RDE_LAT_MAX
+};
+
 struct rde_memstats {
 	long long	path_cnt;
 	long long	path_refs;
@@ -1515,6 +1619,8 @@ struct rde_memstats {
 	long long	attr_dcnt;
 	long long	adjout_attr_cnt;
 	long long	adjout_attr_refs;
+	long long	adjout_attr_enc_cnt;
+	long long	adjout_attr_enc_size;
 	long long	aset_cnt;
 	long long	aset_size;
 	long long	aset_nmemb;
@@ -1544,6 +1650,9 @@ struct rde_memstats {
 	long long	rde_event_ribdump_usec;
 	long long	rde_event_nexthop_usec;
 	long long	rde_event_update_usec;
+	long long	rde_reconf_in_filtered;
+	long long	rde_reconf_in_skipped;
+	struct latency_hist	rde_latency[RDE_LAT_MAX];
 };
 
 #define	MRT_FILE_LEN	512
@@ -1720,6 +1829,13 @@ void		 bitmap_reset(struct bitmap *);
 
 void		 bitmap_get_stats(long long *, long long *);
 
+/* lpm.c */
+int		 lpm_insert(struct lpm_tree *, const void *, uint8_t);
+void		 lpm_remove(struct lpm_tree *, const void *, uint8_t);
+int		 lpm_lookup(const struct lpm_tree *, const void *, uint8_t,
+		    uint8_t *);
+void		 lpm_flush(struct lpm_tree *);
+
 /* rde_sets.c */
 struct as_set	*as_sets_lookup(struct as_set_head *, const char *);
 struct as_set	*as_sets_new(struct as_set_head *, const char *, size_t,
@@ -1734,6 +1850,8 @@ int			 set_add(struct set_table *, void *, size_t);
 void			*set_get(struct set_table *, size_t *);
 void			 set_prep(struct set_table *);
 void			*set_match(const struct set_table *, uint32_t);
+int			 set_insert(struct set_table *, void *);
+int			 set_delete(struct set_table *, uint32_t);
 int			 set_equal(const struct set_table *,
 			    const struct set_table *);
 size_t			 set_nmemb(const struct set_table *);
@@ -1741,6 +1859,8 @@ size_t			 set_nmemb(const struct set_table *);
 /* rde_trie.c */
 int	trie_add(struct trie_head *, struct bgpd_addr *, uint8_t, uint8_t,
 	    uint8_t);
+int	trie_del(struct trie_head *, struct bgpd_addr *, uint8_t, uint8_t,
+	    uint8_t);
 int	trie_roa_add(struct trie_head *, struct roa *);
 void	trie_free(struct trie_head *);
 int	trie_match(struct trie_head *, struct bgpd_addr *, uint8_t, int);
@@ -1809,6 +1929,9 @@ int	imsg_send_filterset(struct imsgbuf *, struct filter_set_head *);
 int	ibuf_recv_filterset_count(struct ibuf *, uint16_t *);
 int	ibuf_recv_one_filterset(struct ibuf *, struct filter_set *);
 int	imsg_check_filterset(struct imsg *);
+int	imsg_batch_add(struct imsgbuf *, struct ibuf **, uint32_t,
+	    const void *, size_t);
+void	imsg_batch_close(struct imsgbuf *, struct ibuf **);
 
 /* flowspec.c */
 int	flowspec_valid(const uint8_t *, int, int);
@@ -1839,6 +1962,15 @@ static const char * const statenames[] = {
 	"Established"
 };
 
+/* rde latency histogram names, needed by bgpctl */
+static const char * const rde_latency_names[] = {
+	"update",
+	"adj-rib-out",
+	"decision",
+	"filter",
+	"control"
+};
+
 static const char * const msgtypenames[] = {
 	"NONE",
 	"OPEN",
@@ -1953,6 +2085,7 @@ static const char * const ctl_res_strerror[] = {
 	"peer still active, down peer first",
 	"no such RIB",
 	"operation not supported",
+	"no such set",
 };
 
 static const char * const timernames[] = {
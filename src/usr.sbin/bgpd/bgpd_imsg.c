@@ -47,7 +47,8 @@ imsg_send_ctl_peer(struct imsgbuf *imsgbuf, struct peer *p,
 	peer.holdtime = p->holdtime;
 	peer.template = p->template != NULL;
 
-	peer.stats.msg_queue_len = msgbuf_queuelen(p->wbuf);
+	peer.stats.msg_queue_len = msgbuf_queuelen(p->wbuf) +
+	    ibufq_queuelen(p->bulkq);
 
 	return imsg_compose(imsgbuf, IMSG_CTL_SHOW_NEIGHBOR, 0, 0, -1,
 	    &peer, sizeof(peer));
@@ -237,3 +238,37 @@ imsg_check_filterset(struct imsg *imsg)
 	}
 	return 0;
 }
+
+/*
+ * Add a fixed size item to a batch of items sent in one imsg of the given
+ * type. The imsg is queued once it would grow beyond IMSG_BATCH_SIZE and
+ * a new one is started. imsg_batch_close() must be called after the last
+ * item. The receiver has to handle imsgs with multiple items.
+ */
+int
+imsg_batch_add(struct imsgbuf *imsgbuf, struct ibuf **batch, uint32_t type,
+    const void *data, size_t len)
+{
+	if (*batch != NULL && ibuf_size(*batch) + len > IMSG_BATCH_SIZE)
+		imsg_batch_close(imsgbuf, batch);
+	if (*batch == NULL) {
+		*batch = imsg_create(imsgbuf, type, 0, 0, IMSG_BATCH_SIZE);
+		if (*batch == NULL)
+			return -1;
+	}
+	if (imsg_add(*batch, data, len) == -1) {
+		/* imsg_add() freed the buffer */
+		*batch = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+void
+imsg_batch_close(struct imsgbuf *imsgbuf, struct ibuf **batch)
+{
+	if (*batch == NULL)
+		return;
+	imsg_close(imsgbuf, *batch);
+	*batch = NULL;
+}
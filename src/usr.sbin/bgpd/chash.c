@@ -16,6 +16,7 @@
  */
 
 #include <errno.h>
+#include <sched.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,6 +42,16 @@
  *
  * Unlike other unordered sets this hash table does not allow a key to
  * be inserted more than once.
+ *
+ * Tables set up with _ch_init_concurrent() can be used by multiple threads.
+ * Lookups are lock-free, writers are serialized by a spinlock per table.
+ * Each sub table and the extendible hash are protected by a sequence
+ * counter, readers retry if a writer modified the data under them.
+ * Sub tables and extendible hash arrays replaced by a split, merge or
+ * resize are only freed once all readers that may still use them are
+ * done (epoch based reclamation). Iterating a concurrent table is only
+ * safe if no writer is active. The global per type counters are not
+ * exact if multiple concurrent tables of a type are modified at once.
  */
 
 #define CH_MAX_LOAD	875	/* in per-mille */
@@ -73,11 +84,14 @@ struct ch_group {
 #define CH_SLOT_MASK	0x7f
 #define CH_FLAGS_SHIFT	56
 
+#define CH_PREFETCH(x)	__builtin_prefetch(x)
+
 struct ch_meta {
 	uint32_t	cs_num_elm;
 	uint32_t	cs_num_tomb;
 	uint32_t	cs_num_ever_full;
 	uint32_t	cs_local_level;
+	uint32_t	cs_seq;		/* only used by concurrent tables */
 };
 
 struct ch_ext {
@@ -85,6 +99,27 @@ struct ch_ext {
 	struct ch_meta		*ce_meta;
 };
 
+/*
+ * Reader epochs of concurrent tables. Threads are spread over CH_SYNC_SLOTS
+ * cache line sized slots to keep readers from fighting over one counter.
+ * Each slot counts the active readers per epoch parity.
+ */
+#define CH_SYNC_SLOTS	64
+
+struct ch_sync_slot {
+	uint32_t	css_active[2];
+	uint8_t		css_pad[64 - 2 * sizeof(uint32_t)];
+};
+
+struct ch_sync {
+	struct ch_sync_slot	cs_slots[CH_SYNC_SLOTS];
+	uint32_t		cs_lock;
+	uint32_t		cs_epoch;
+	uint32_t		cs_seq;		/* protects ch_exts */
+};
+
+static uint32_t ch_sync_nthreads;
+
 /*
  * API to work with the cg_meta field of a ch_group:
  *   cg_meta_set_flags: Set bits in flags section, return true if not yet set.
@@ -99,7 +134,8 @@ cg_meta_set_flags(struct ch_group *g, uint8_t flag)
 {
 	uint64_t f = flag, oldf;
 	oldf = g->cg_meta & (f << CH_FLAGS_SHIFT);
-	g->cg_meta |= f << CH_FLAGS_SHIFT;
+	__atomic_store_n(&g->cg_meta, g->cg_meta | f << CH_FLAGS_SHIFT,
+	    __ATOMIC_RELEASE);
 	return oldf != 0;
 }
 
@@ -108,7 +144,8 @@ cg_meta_clear_flags(struct ch_group *g, uint8_t flag)
 {
 	uint64_t f = flag, oldf;
 	oldf = g->cg_meta & (f << CH_FLAGS_SHIFT);
-	g->cg_meta &= ~(f << CH_FLAGS_SHIFT);
+	__atomic_store_n(&g->cg_meta, g->cg_meta & ~(f << CH_FLAGS_SHIFT),
+	    __ATOMIC_RELEASE);
 	return oldf != 0;
 }
 
@@ -132,7 +169,134 @@ cg_meta_set_hash(struct ch_group *g, int slot, uint64_t hash)
 
 	newval = g->cg_meta & ~(0xffULL << (slot * 8));
 	newval |= hash << (slot * 8);
-	g->cg_meta = newval;
+	__atomic_store_n(&g->cg_meta, newval, __ATOMIC_RELEASE);
+}
+
+/*
+ * API for concurrent tables:
+ *   ch_sync_slot: return the reader slot of the current thread.
+ *   ch_sync_enter: enter the current epoch as reader.
+ *   ch_sync_leave: leave the epoch again.
+ *   ch_sync_lock, ch_sync_unlock: writer spinlock.
+ *   ch_sync_wait: advance the epoch and wait for the readers of the old one.
+ *   ch_seq_begin, ch_seq_end: mark start and end of a modification.
+ *   ch_ext_begin, ch_ext_end: same for the extendible hash.
+ *   ch_seq_read, ch_seq_retry: read side of the sequence counter.
+ * Writer side functions are no-ops for tables without ch_sync.
+ */
+static inline struct ch_sync_slot *
+ch_sync_slot(struct ch_sync *cs)
+{
+	static __thread uint32_t id;
+
+	if (id == 0)
+		id = __atomic_add_fetch(&ch_sync_nthreads, 1,
+		    __ATOMIC_RELAXED);
+	return &cs->cs_slots[id % CH_SYNC_SLOTS];
+}
+
+static inline uint32_t
+ch_sync_enter(struct ch_sync *cs, struct ch_sync_slot *slot)
+{
+	uint32_t e;
+
+	for (;;) {
+		e = __atomic_load_n(&cs->cs_epoch, __ATOMIC_ACQUIRE);
+		__atomic_add_fetch(&slot->css_active[e & 1], 1,
+		    __ATOMIC_SEQ_CST);
+		/* recheck, a writer may have advanced the epoch meanwhile */
+		if (__atomic_load_n(&cs->cs_epoch, __ATOMIC_SEQ_CST) == e)
+			return e;
+		__atomic_sub_fetch(&slot->css_active[e & 1], 1,
+		    __ATOMIC_RELEASE);
+	}
+}
+
+static inline void
+ch_sync_leave(struct ch_sync_slot *slot, uint32_t e)
+{
+	__atomic_sub_fetch(&slot->css_active[e & 1], 1, __ATOMIC_RELEASE);
+}
+
+static void
+ch_sync_lock(struct ch_sync *cs)
+{
+	while (__atomic_exchange_n(&cs->cs_lock, 1, __ATOMIC_ACQUIRE) != 0)
+		sched_yield();
+}
+
+static void
+ch_sync_unlock(struct ch_sync *cs)
+{
+	__atomic_store_n(&cs->cs_lock, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Wait until no reader can hold a reference to memory unlinked before
+ * the call. Must be called with the writer lock held.
+ */
+static void
+ch_sync_wait(struct ch_table *t)
+{
+	struct ch_sync *cs = t->ch_sync;
+	uint32_t e, i;
+
+	if (cs == NULL)
+		return;
+
+	e = __atomic_fetch_add(&cs->cs_epoch, 1, __ATOMIC_SEQ_CST);
+	for (i = 0; i < CH_SYNC_SLOTS; i++)
+		while (__atomic_load_n(&cs->cs_slots[i].css_active[e & 1],
+		    __ATOMIC_ACQUIRE) != 0)
+			sched_yield();
+}
+
+static inline void
+ch_seq_begin(const struct ch_table *t, uint32_t *seq)
+{
+	if (t->ch_sync == NULL)
+		return;
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+ch_seq_end(const struct ch_table *t, uint32_t *seq)
+{
+	if (t->ch_sync == NULL)
+		return;
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline void
+ch_ext_begin(const struct ch_table *t)
+{
+	if (t->ch_sync != NULL)
+		ch_seq_begin(t, &t->ch_sync->cs_seq);
+}
+
+static inline void
+ch_ext_end(const struct ch_table *t)
+{
+	if (t->ch_sync != NULL)
+		ch_seq_end(t, &t->ch_sync->cs_seq);
+}
+
+static inline uint32_t
+ch_seq_read(const uint32_t *seq)
+{
+	uint32_t s;
+
+	while ((s = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+	return s;
+}
+
+static inline int
+ch_seq_retry(const uint32_t *seq, uint32_t s)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(seq, __ATOMIC_RELAXED) != s;
 }
 
 /*
@@ -261,7 +425,7 @@ ch_sub_insert(const struct ch_type *type, struct ch_group *table,
 	 * insert new object and adjust accounting.
 	 * If CH_EVER_FULL is set then it was a tombstone and not an empty slot.
 	 */
-	ins_g->cg_data[ins_i] = elm;
+	__atomic_store_n(&ins_g->cg_data[ins_i], elm, __ATOMIC_RELEASE);
 	cg_meta_set_hash(ins_g, ins_i, h & CH_H3_MASK);
 	cg_meta_set_flags(ins_g, 1 << ins_i);
 	if (cg_meta_check_flags(ins_g, CH_EVER_FULL))
@@ -294,7 +458,8 @@ ch_sub_remove(const struct ch_type *type, struct ch_group *table,
 			/* most probably a hit */
 			if (type->t_equal(g->cg_data[i], needle)) {
 				void *elm = g->cg_data[i];
-				g->cg_data[i] = NULL;
+				__atomic_store_n(&g->cg_data[i], NULL,
+				    __ATOMIC_RELEASE);
 				cg_meta_set_hash(g, i, 0);
 				cg_meta_clear_flags(g, 1 << i);
 				if (hits & CH_EVER_FULL)
@@ -369,6 +534,73 @@ ch_sub_locate(const struct ch_type *type, struct ch_group *table, uint64_t h,
 	}
 }
 
+/*
+ * Lookup for concurrent tables, like ch_sub_locate() but the group data
+ * may change underneath. Slots may be empty and the probe sequence is
+ * bounded, the caller rechecks the sequence counter and retries.
+ */
+static void *
+ch_sub_locate_sync(struct ch_group *table, uint64_t h,
+    int (*eq)(const void *, const void *), const void *arg)
+{
+	uint64_t mask, meta;
+	uint32_t bucket = CH_H2(h), n;
+	int i;
+	uint8_t hits, slots;
+	struct ch_group *g;
+	void *v;
+
+	mask = CH_H3(h) * 0x0101010101010101ULL;
+	for (n = 0; n < CH_H2_SIZE; n++) {
+		g = &table[bucket++ & CH_H2_MASK];
+		meta = __atomic_load_n(&g->cg_meta, __ATOMIC_ACQUIRE);
+		hits = (meta >> CH_FLAGS_SHIFT) &
+		    (CH_EVER_FULL | ch_haszero(meta ^ mask));
+		for (slots = hits & CH_SLOT_MASK; slots != 0;
+		    slots &= slots - 1) {
+			i = ffs(slots) - 1;
+			v = __atomic_load_n(&g->cg_data[i], __ATOMIC_ACQUIRE);
+			if (v != NULL && eq(v, arg))
+				return v;
+		}
+		if ((hits & CH_EVER_FULL) == 0)
+			return NULL;
+	}
+	return NULL;
+}
+
+/*
+ * Batched lookup of up to CH_BATCH_MAX keys. A single lookup first misses
+ * on the group and then on the element pointed to by the group. Doing the
+ * lookups in three passes, first prefetching all groups then the first
+ * candidate element of each key and only then comparing, lets the cache
+ * misses of the different keys overlap.
+ */
+static void
+ch_sub_locate_batch(const struct ch_type *type, struct ch_table *t, size_t n,
+    const uint64_t *hashes, int (*eq)(const void *, const void *),
+    const void * const *args, void **res)
+{
+	struct ch_group *tables[CH_BATCH_MAX], *g;
+	uint64_t mask;
+	size_t i;
+	uint8_t hits;
+
+	for (i = 0; i < n; i++) {
+		tables[i] = t->ch_exts[CH_H1(hashes[i], t->ch_level)].ce_table;
+		CH_PREFETCH(&tables[i][CH_H2(hashes[i])]);
+	}
+	for (i = 0; i < n; i++) {
+		g = &tables[i][CH_H2(hashes[i])];
+		mask = CH_H3(hashes[i]) * 0x0101010101010101ULL;
+		hits = ch_meta_locate(g, mask) & CH_SLOT_MASK;
+		if (hits != 0)
+			CH_PREFETCH(g->cg_data[ffs(hits) - 1]);
+	}
+	for (i = 0; i < n; i++)
+		res[i] = ch_sub_locate(type, tables[i], hashes[i], eq, args[i]);
+}
+
 /*
  * Start of sub table iterator, reset the set and grp indices and locate
  * first element in sub table. Return element or NULL if table is empty.
@@ -549,7 +781,7 @@ ch_sub_free(const struct ch_type *type, struct ch_table *t,
 static int
 ch_table_resize(const struct ch_type *type, struct ch_table *t)
 {
-	struct ch_ext *new;
+	struct ch_ext *new, *old = NULL;
 	uint64_t oldsize = 1ULL << t->ch_level;
 	uint64_t newsize = oldsize * 2;
 	int64_t idx;
@@ -564,22 +796,36 @@ ch_table_resize(const struct ch_type *type, struct ch_table *t)
 		newsize = 2;
 	}
 
-	new = reallocarray(t->ch_exts, newsize, sizeof(*t->ch_exts));
-	if (new == NULL)
-		return -1;
+	if (t->ch_sync != NULL && oldsize != 0) {
+		/* readers may still use the old array, can't realloc */
+		new = reallocarray(NULL, newsize, sizeof(*t->ch_exts));
+		if (new == NULL)
+			return -1;
+		memcpy(new, t->ch_exts, oldsize * sizeof(*t->ch_exts));
+		old = t->ch_exts;
+	} else {
+		new = reallocarray(t->ch_exts, newsize, sizeof(*t->ch_exts));
+		if (new == NULL)
+			return -1;
+	}
+
+	for (idx = oldsize - 1; idx >= 0; idx--) {
+		new[idx * 2] = new[idx];
+		new[idx * 2 + 1] = new[idx];
+	}
 
-	t->ch_level++;
-	t->ch_exts = new;
+	/* readers load ch_level before ch_exts, so publish ch_exts first */
+	ch_ext_begin(t);
+	__atomic_store_n(&t->ch_exts, new, __ATOMIC_RELEASE);
+	__atomic_store_n(&t->ch_level, t->ch_level + 1, __ATOMIC_RELEASE);
+	ch_ext_end(t);
 
 	t->ch_counts.cc_num_extendible += newsize - oldsize;
 	type->t_counts->cc_num_extendible += newsize - oldsize;
 
-	if (oldsize == 0)
-		return 0;
-
-	for (idx = oldsize - 1; idx >= 0; idx--) {
-		t->ch_exts[idx * 2] = t->ch_exts[idx];
-		t->ch_exts[idx * 2 + 1] = t->ch_exts[idx];
+	if (old != NULL) {
+		ch_sync_wait(t);
+		free(old);
 	}
 
 	return 0;
@@ -599,10 +845,14 @@ ch_table_fill(struct ch_table *t, uint64_t idx, struct ch_group *table,
 	idx <<= (t->ch_level - meta->cs_local_level);
 	cnt = 1ULL << (t->ch_level - meta->cs_local_level);
 
+	ch_ext_begin(t);
 	for (i = 0; i < cnt; i++) {
-		t->ch_exts[idx + i].ce_table = table;
-		t->ch_exts[idx + i].ce_meta = meta;
+		__atomic_store_n(&t->ch_exts[idx + i].ce_table, table,
+		    __ATOMIC_RELEASE);
+		__atomic_store_n(&t->ch_exts[idx + i].ce_meta, meta,
+		    __ATOMIC_RELEASE);
 	}
+	ch_ext_end(t);
 }
 
 /*
@@ -666,6 +916,7 @@ ch_table_grow(const struct ch_type *type, struct ch_table *t, uint64_t h,
 	idx = CH_H1(h, meta->cs_local_level) << 1;
 	ch_table_fill(t, idx, left, leftmeta);
 	ch_table_fill(t, idx | 1, right, rightmeta);
+	ch_sync_wait(t);
 	ch_sub_free(type, t, table, meta);
 
 	return 0;
@@ -688,8 +939,8 @@ ch_table_compact(const struct ch_type *type, struct ch_table *t, uint64_t h,
     struct ch_group *table, struct ch_meta *meta)
 {
 	struct ch_ext *buddy;
-	struct ch_group *to = NULL;
-	struct ch_meta *tometa = NULL;
+	struct ch_group *to = NULL, *btable;
+	struct ch_meta *tometa = NULL, *bmeta;
 	uint64_t idx;
 
 	idx = CH_H1(h, t->ch_level);
@@ -710,12 +961,15 @@ ch_table_compact(const struct ch_type *type, struct ch_table *t, uint64_t h,
 	/*
 	 * Update table in the extendible hash table, which overwrites
 	 * all entries of the table and buddy with new values.
-	 * Therefore free them first.
+	 * Therefore remember the buddy first.
 	 */
+	btable = buddy->ce_table;
+	bmeta = buddy->ce_meta;
 	idx = CH_H1(h, tometa->cs_local_level);
-	ch_sub_free(type, t, buddy->ce_table, buddy->ce_meta);
-	ch_sub_free(type, t, table, meta);
 	ch_table_fill(t, idx, to, tometa);
+	ch_sync_wait(t);
+	ch_sub_free(type, t, btable, bmeta);
+	ch_sub_free(type, t, table, meta);
 
 	return 0;
 
@@ -750,6 +1004,33 @@ _ch_init(const struct ch_type *type, struct ch_table *t)
 	return -1;
 }
 
+int
+_ch_init_concurrent(const struct ch_type *type, struct ch_table *t)
+{
+	if ((t->ch_sync = calloc(1, sizeof(*t->ch_sync))) == NULL)
+		return -1;
+	if (_ch_init(type, t) == -1) {
+		free(t->ch_sync);
+		t->ch_sync = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Wait until no reader can still see an element removed before the call.
+ * After that the element can be freed.
+ */
+void
+_ch_synchronize(struct ch_table *t)
+{
+	if (t->ch_sync == NULL)
+		return;
+	ch_sync_lock(t->ch_sync);
+	ch_sync_wait(t);
+	ch_sync_unlock(t->ch_sync);
+}
+
 void
 _ch_destroy(const struct ch_type *type, struct ch_table *t)
 {
@@ -765,12 +1046,13 @@ _ch_destroy(const struct ch_type *type, struct ch_table *t)
 		    t->ch_exts[idx].ce_meta);
 	}
 	free(t->ch_exts);
+	free(t->ch_sync);
 	type->t_counts->cc_num_extendible -= max;
 	memset(t, 0, sizeof(*t));
 }
 
-void *
-_ch_insert(const struct ch_type *type, struct ch_table *t, uint64_t h,
+static void *
+ch_insert(const struct ch_type *type, struct ch_table *t, uint64_t h,
     void *elm)
 {
 	struct ch_group *table;
@@ -795,7 +1077,9 @@ _ch_insert(const struct ch_type *type, struct ch_table *t, uint64_t h,
 		meta = t->ch_exts[idx].ce_meta;
 	}
 
+	ch_seq_begin(t, &meta->cs_seq);
 	v = ch_sub_insert(type, table, meta, h, elm);
+	ch_seq_end(t, &meta->cs_seq);
 	if (v == NULL) {
 		t->ch_counts.cc_num_elm++;
 		type->t_counts->cc_num_elm++;
@@ -804,7 +1088,22 @@ _ch_insert(const struct ch_type *type, struct ch_table *t, uint64_t h,
 }
 
 void *
-_ch_remove(const struct ch_type *type, struct ch_table *t, uint64_t h,
+_ch_insert(const struct ch_type *type, struct ch_table *t, uint64_t h,
+    void *elm)
+{
+	void *v;
+
+	if (t->ch_sync == NULL)
+		return ch_insert(type, t, h, elm);
+
+	ch_sync_lock(t->ch_sync);
+	v = ch_insert(type, t, h, elm);
+	ch_sync_unlock(t->ch_sync);
+	return v;
+}
+
+static void *
+ch_remove(const struct ch_type *type, struct ch_table *t, uint64_t h,
     const void *needle)
 {
 	struct ch_group *table;
@@ -819,7 +1118,9 @@ _ch_remove(const struct ch_type *type, struct ch_table *t, uint64_t h,
 	table = t->ch_exts[idx].ce_table;
 	meta = t->ch_exts[idx].ce_meta;
 
+	ch_seq_begin(t, &meta->cs_seq);
 	v = ch_sub_remove(type, table, meta, h, needle);
+	ch_seq_end(t, &meta->cs_seq);
 	if (v != NULL) {
 		t->ch_counts.cc_num_elm--;
 		type->t_counts->cc_num_elm--;
@@ -836,6 +1137,79 @@ _ch_remove(const struct ch_type *type, struct ch_table *t, uint64_t h,
 	return v;
 }
 
+void *
+_ch_remove(const struct ch_type *type, struct ch_table *t, uint64_t h,
+    const void *needle)
+{
+	void *v;
+
+	if (t->ch_sync == NULL)
+		return ch_remove(type, t, h, needle);
+
+	ch_sync_lock(t->ch_sync);
+	v = ch_remove(type, t, h, needle);
+	ch_sync_unlock(t->ch_sync);
+	return v;
+}
+
+/*
+ * Enter and leave a read section of a concurrent table. Lookups must be
+ * done inside a read section and the returned elements may only be used
+ * until the section is left. Elements removed meanwhile are not freed
+ * before that since CH_SYNCHRONIZE() waits for the section to end.
+ * Return the epoch which needs to be passed to _ch_read_end().
+ */
+uint32_t
+_ch_read_begin(struct ch_table *t)
+{
+	if (t->ch_sync == NULL)
+		return 0;
+	return ch_sync_enter(t->ch_sync, ch_sync_slot(t->ch_sync));
+}
+
+void
+_ch_read_end(struct ch_table *t, uint32_t e)
+{
+	if (t->ch_sync == NULL)
+		return;
+	ch_sync_leave(ch_sync_slot(t->ch_sync), e);
+}
+
+/*
+ * Lock-free lookup in a concurrent table, the caller is in a read section.
+ * First get a consistent view of the extendible hash entry, then search
+ * the sub table and retry if it was modified during the search.
+ */
+static void *
+ch_locate_sync(struct ch_table *t, uint64_t h,
+    int (*eq)(const void *, const void *), const void *arg)
+{
+	struct ch_sync *cs = t->ch_sync;
+	struct ch_ext *exts;
+	struct ch_group *table;
+	struct ch_meta *meta;
+	uint32_t s, m, level;
+	uint64_t idx;
+	void *v;
+
+	do {
+		do {
+			s = ch_seq_read(&cs->cs_seq);
+			level = __atomic_load_n(&t->ch_level, __ATOMIC_ACQUIRE);
+			exts = __atomic_load_n(&t->ch_exts, __ATOMIC_ACQUIRE);
+			idx = CH_H1(h, level);
+			table = __atomic_load_n(&exts[idx].ce_table,
+			    __ATOMIC_ACQUIRE);
+			meta = __atomic_load_n(&exts[idx].ce_meta,
+			    __ATOMIC_ACQUIRE);
+		} while (ch_seq_retry(&cs->cs_seq, s));
+		m = ch_seq_read(&meta->cs_seq);
+		v = ch_sub_locate_sync(table, h, eq, arg);
+	} while (ch_seq_retry(&meta->cs_seq, m));
+
+	return v;
+}
+
 void *
 _ch_find(const struct ch_type *type, struct ch_table *t, uint64_t h,
     const void *needle)
@@ -845,6 +1219,8 @@ _ch_find(const struct ch_type *type, struct ch_table *t, uint64_t h,
 
 	if (t->ch_exts == NULL)
 		return NULL;
+	if (t->ch_sync != NULL)
+		return ch_locate_sync(t, h, type->t_equal, needle);
 
 	idx = CH_H1(h, t->ch_level);
 	table = t->ch_exts[idx].ce_table;
@@ -861,6 +1237,8 @@ _ch_locate(const struct ch_type *type, struct ch_table *t, uint64_t h,
 
 	if (t->ch_exts == NULL)
 		return NULL;
+	if (t->ch_sync != NULL)
+		return ch_locate_sync(t, h, eq, arg);
 
 	idx = CH_H1(h, t->ch_level);
 	table = t->ch_exts[idx].ce_table;
@@ -868,6 +1246,38 @@ _ch_locate(const struct ch_type *type, struct ch_table *t, uint64_t h,
 	return ch_sub_locate(type, table, h, eq, arg);
 }
 
+void
+_ch_locate_batch(const struct ch_type *type, struct ch_table *t, size_t n,
+    const uint64_t *hashes, int (*eq)(const void *, const void *),
+    const void * const *args, void **res)
+{
+	size_t i, m;
+
+	if (t->ch_exts == NULL) {
+		for (i = 0; i < n; i++)
+			res[i] = NULL;
+		return;
+	}
+	if (t->ch_sync != NULL) {
+		for (i = 0; i < n; i++)
+			res[i] = ch_locate_sync(t, hashes[i], eq, args[i]);
+		return;
+	}
+
+	for (i = 0; i < n; i += m) {
+		m = n - i < CH_BATCH_MAX ? n - i : CH_BATCH_MAX;
+		ch_sub_locate_batch(type, t, m, hashes + i, eq, args + i,
+		    res + i);
+	}
+}
+
+void
+_ch_find_batch(const struct ch_type *type, struct ch_table *t, size_t n,
+    const uint64_t *hashes, const void * const *needles, void **res)
+{
+	_ch_locate_batch(type, t, n, hashes, type->t_equal, needles, res);
+}
+
 void *
 _ch_first(const struct ch_type *type, struct ch_table *t, struct ch_iter *it)
 {
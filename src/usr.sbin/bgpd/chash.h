@@ -49,9 +49,11 @@ struct ch_type {
 };
 
 struct ch_ext;
+struct ch_sync;
 
 struct ch_table {
 	struct ch_ext		*ch_exts;
+	struct ch_sync		*ch_sync;
 	uint32_t		 ch_level;
 	struct ch_counts	 ch_counts;
 };
@@ -69,6 +71,10 @@ struct ch_iter {
 };
 
 int   _ch_init(const struct ch_type *, struct ch_table *);
+int   _ch_init_concurrent(const struct ch_type *, struct ch_table *);
+void  _ch_synchronize(struct ch_table *);
+uint32_t _ch_read_begin(struct ch_table *);
+void  _ch_read_end(struct ch_table *, uint32_t);
 void  _ch_destroy(const struct ch_type *, struct ch_table *);
 void *_ch_insert(const struct ch_type *, struct ch_table *, uint64_t, void *);
 void *_ch_remove(const struct ch_type *, struct ch_table *, uint64_t,
@@ -77,12 +83,20 @@ void *_ch_find(const struct ch_type *, struct ch_table *, uint64_t,
 	    const void *);
 void *_ch_locate(const struct ch_type *, struct ch_table *, uint64_t,
 	    int (*)(const void *, const void *), const void *);
+void  _ch_find_batch(const struct ch_type *, struct ch_table *, size_t,
+	    const uint64_t *, const void * const *, void **);
+void  _ch_locate_batch(const struct ch_type *, struct ch_table *, size_t,
+	    const uint64_t *, int (*)(const void *, const void *),
+	    const void * const *, void **);
 void *_ch_first(const struct ch_type *, struct ch_table *, struct ch_iter *);
 void *_ch_next(const struct ch_type *, struct ch_table *, struct ch_iter *);
 void  _ch_get_stats(struct ch_stats *, const struct ch_counts *);
 
 #define CH_INS_FAILED	((void *)-1)
 
+/* number of lookups overlapped by CH_FIND_BATCH and CH_LOCATE_BATCH */
+#define CH_BATCH_MAX	16
+
 #define CH_INITIALIZER(_head)  { 0 }
 
 #define CH_PROTOTYPE(_name, _type, _hash)				\
@@ -94,6 +108,30 @@ _name##_CH_INIT(struct _name *head)					\
 	return _ch_init(_name##_CH_TYPE, &head->ch_table);		\
 }									\
 									\
+__unused static inline int						\
+_name##_CH_INIT_CONCURRENT(struct _name *head)				\
+{									\
+	return _ch_init_concurrent(_name##_CH_TYPE, &head->ch_table);	\
+}									\
+									\
+__unused static inline void						\
+_name##_CH_SYNCHRONIZE(struct _name *head)				\
+{									\
+	_ch_synchronize(&head->ch_table);				\
+}									\
+									\
+__unused static inline uint32_t					\
+_name##_CH_READ_BEGIN(struct _name *head)				\
+{									\
+	return _ch_read_begin(&head->ch_table);				\
+}									\
+									\
+__unused static inline void						\
+_name##_CH_READ_END(struct _name *head, uint32_t e)			\
+{									\
+	_ch_read_end(&head->ch_table, e);				\
+}									\
+									\
 __unused static inline void						\
 _name##_CH_DESTROY(struct _name *head)					\
 {									\
@@ -138,6 +176,30 @@ _name##_CH_LOCATE(struct _name *head, uint64_t hash, 			\
 	    eq, arg);							\
 }									\
 									\
+__unused static inline void						\
+_name##_CH_FIND_BATCH(struct _name *head, size_t n,			\
+    const struct _type * const *keys, struct _type **res)		\
+{									\
+	uint64_t h[CH_BATCH_MAX];					\
+	size_t i, j, m;							\
+	for (i = 0; i < n; i += m) {					\
+		m = n - i < CH_BATCH_MAX ? n - i : CH_BATCH_MAX;	\
+		for (j = 0; j < m; j++)					\
+			h[j] = _hash(keys[i + j]);			\
+		_ch_find_batch(_name##_CH_TYPE, &head->ch_table, m, h,	\
+		    (const void * const *)(keys + i), (void **)(res + i)); \
+	}								\
+}									\
+									\
+__unused static inline void						\
+_name##_CH_LOCATE_BATCH(struct _name *head, size_t n,			\
+    const uint64_t *hashes, int (*eq)(const void *, const void *),	\
+    const void * const *args, struct _type **res)			\
+{									\
+	_ch_locate_batch(_name##_CH_TYPE, &head->ch_table, n, hashes,	\
+	    eq, args, (void **)res);					\
+}									\
+									\
 __unused static inline struct _type *					\
 _name##_CH_FIRST(struct _name *head, struct ch_iter *iter)		\
 {									\
@@ -188,6 +250,11 @@ static const struct ch_type _name##_CH_INFO = {				\
 const struct ch_type *const _name##_CH_TYPE = &_name##_CH_INFO
 
 #define CH_INIT(_name, _head)		_name##_CH_INIT(_head)
+#define CH_INIT_CONCURRENT(_name, _head)				\
+					_name##_CH_INIT_CONCURRENT(_head)
+#define CH_SYNCHRONIZE(_name, _head)	_name##_CH_SYNCHRONIZE(_head)
+#define CH_READ_BEGIN(_name, _head)	_name##_CH_READ_BEGIN(_head)
+#define CH_READ_END(_name, _head, _e)	_name##_CH_READ_END(_head, _e)
 #define CH_DESTROY(_name, _head)	_name##_CH_DESTROY(_head)
 #define CH_INSERT(_name, _head, _elm, _prev)				\
 					_name##_CH_INSERT(_head, _elm, _prev)
@@ -195,6 +262,10 @@ const struct ch_type *const _name##_CH_TYPE = &_name##_CH_INFO
 #define CH_FIND(_name, _head, _key)	_name##_CH_FIND(_head, _key)
 #define CH_LOCATE(_name, _head, _h, _eq, _a)			\
 					_name##_CH_LOCATE(_head, _h, _eq, _a)
+#define CH_FIND_BATCH(_name, _head, _n, _keys, _res)			\
+			_name##_CH_FIND_BATCH(_head, _n, _keys, _res)
+#define CH_LOCATE_BATCH(_name, _head, _n, _h, _eq, _a, _res)		\
+			_name##_CH_LOCATE_BATCH(_head, _n, _h, _eq, _a, _res)
 #define CH_FIRST(_name, _head, _iter)	_name##_CH_FIRST(_head, _iter)
 #define CH_NEXT(_name, _head, _iter)	_name##_CH_NEXT(_head, _iter)
 #define CH_STATS(_name, _head, _stats)	_name##_CH_STATS(_head, _stats)
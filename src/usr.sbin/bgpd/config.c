@@ -87,6 +87,7 @@ copy_config(struct bgpd_config *to, const struct bgpd_config *from)
 	to->min_holdtime = from->min_holdtime;
 	to->staletime = from->staletime;
 	to->connectretry = from->connectretry;
+	to->damp = from->damp;
 	to->fib_priority = from->fib_priority;
 	to->filtered_in_locrib = from->filtered_in_locrib;
 }
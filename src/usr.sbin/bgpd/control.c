@@ -505,6 +505,8 @@ control_dispatch_msg(struct pollfd *pfd, struct peer_head *peers)
 		case IMSG_FLOWSPEC_REMOVE:
 		case IMSG_FLOWSPEC_DONE:
 		case IMSG_FLOWSPEC_FLUSH:
+		case IMSG_CTL_SET_ADD:
+		case IMSG_CTL_SET_DELETE:
 			imsg_ctl_rde(&imsg);
 			break;
 		case IMSG_FILTER_SET:
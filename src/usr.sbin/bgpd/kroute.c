@@ -56,9 +56,12 @@ struct {
 	uint8_t			fib_prio;
 } kr_state;
 
+LIST_HEAD(knexthop_head, knexthop);
+
 struct kroute {
 	RB_ENTRY(kroute)	 entry;
 	struct kroute		*next;
+	struct knexthop_head	 nexthops;	/* nexthops using this route */
 	struct in_addr		 prefix;
 	struct in_addr		 nexthop;
 	uint32_t		 mplslabel;
@@ -72,6 +75,7 @@ struct kroute {
 struct kroute6 {
 	RB_ENTRY(kroute6)	 entry;
 	struct kroute6		*next;
+	struct knexthop_head	 nexthops;	/* nexthops using this route */
 	struct in6_addr		 prefix;
 	struct in6_addr		 nexthop;
 	uint32_t		 prefix_scope_id;	/* because ... */
@@ -86,6 +90,8 @@ struct kroute6 {
 
 struct knexthop {
 	RB_ENTRY(knexthop)	 entry;
+	RB_ENTRY(knexthop)	 if_entry;
+	LIST_ENTRY(knexthop)	 kr_entry;
 	struct bgpd_addr	 nexthop;
 	void			*kroute;
 	u_short			 ifindex;
@@ -131,6 +137,7 @@ struct kroute_full *kr6_tofull(struct kroute6 *);
 int	kroute_compare(struct kroute *, struct kroute *);
 int	kroute6_compare(struct kroute6 *, struct kroute6 *);
 int	knexthop_compare(struct knexthop *, struct knexthop *);
+int	knexthop_if_compare(struct knexthop *, struct knexthop *);
 int	kredist_compare(struct kredist_node *, struct kredist_node *);
 int	kif_compare(struct kif *, struct kif *);
 
@@ -160,8 +167,9 @@ int		 kroute_validate(struct kroute *);
 int		 kroute6_validate(struct kroute6 *);
 int		 knexthop_true_nexthop(struct ktable *, struct kroute_full *);
 void		 knexthop_validate(struct ktable *, struct knexthop *);
+void		 knexthop_revalidate(struct ktable *, struct kroute_full *);
 void		 knexthop_track(struct ktable *, u_short);
-void		 knexthop_update(struct ktable *, struct kroute_full *);
+void		 knexthop_update(struct knexthop_head *);
 void		 knexthop_send_update(struct knexthop *);
 struct kroute	*kroute_match(struct ktable *, struct bgpd_addr *, int);
 struct kroute6	*kroute6_match(struct ktable *, struct bgpd_addr *, int);
@@ -177,6 +185,7 @@ void		if_announce(void *);
 
 int		send_rtmsg(int, struct ktable *, struct kroute_full *);
 int		dispatch_rtmsg(void);
+int		fetchrtdump(u_int, int, char **, size_t *, size_t *);
 int		fetchtable(struct ktable *);
 int		fetchifs(int);
 int		dispatch_rtmsg_addr(struct rt_msghdr *, struct kroute_full *);
@@ -192,6 +201,9 @@ RB_GENERATE(kroute6_tree, kroute6, entry, kroute6_compare)
 RB_PROTOTYPE(knexthop_tree, knexthop, entry, knexthop_compare)
 RB_GENERATE(knexthop_tree, knexthop, entry, knexthop_compare)
 
+RB_PROTOTYPE(knexthop_if_tree, knexthop, if_entry, knexthop_if_compare)
+RB_GENERATE(knexthop_if_tree, knexthop, if_entry, knexthop_if_compare)
+
 RB_PROTOTYPE(kredist_tree, kredist_node, entry, kredist_compare)
 RB_GENERATE(kredist_tree, kredist_node, entry, kredist_compare)
 
@@ -200,6 +212,7 @@ RB_PROTOTYPE(kif_tree, kif, entry, kif_compare)
 RB_GENERATE(kif_tree, kif, entry, kif_compare)
 
 #define KT2KNT(x)	(&(ktable_get((x)->nhtableid)->knt))
+#define KT2KNI(x)	(&(ktable_get((x)->nhtableid)->kni))
 
 /*
  * exported functions
@@ -305,6 +318,7 @@ ktable_new(u_int rtableid, u_int rdomid, char *name, int fs)
 	RB_INIT(&kt->krt);
 	RB_INIT(&kt->krt6);
 	RB_INIT(&kt->knt);
+	RB_INIT(&kt->kni);
 	TAILQ_INIT(&kt->krn);
 	kt->fib_conf = kt->fib_sync = fs;
 	kt->rtableid = rtableid;
@@ -364,6 +378,8 @@ ktable_destroy(struct ktable *kt)
 		knexthop_clear(kt);
 	kroute_clear(kt);
 	kroute6_clear(kt);
+	lpm_flush(&kt->lpm);
+	lpm_flush(&kt->lpm6);
 	kr_net_clear(kt);
 
 	krt[kt->rtableid] = NULL;
@@ -515,7 +531,7 @@ kr4_change(struct ktable *kt, struct kroute_full *kf)
 			kr->flags &= ~F_REJECT;
 
 		if (kr->flags & F_NEXTHOP)
-			knexthop_update(kt, kf);
+			knexthop_update(&kr->nexthops);
 
 		if (send_rtmsg(RTM_CHANGE, kt, kf))
 			kr->flags |= F_BGPD_INSERTED;
@@ -556,7 +572,7 @@ kr6_change(struct ktable *kt, struct kroute_full *kf)
 			kr6->flags &= ~F_REJECT;
 
 		if (kr6->flags & F_NEXTHOP)
-			knexthop_update(kt, kf);
+			knexthop_update(&kr6->nexthops);
 
 		if (send_rtmsg(RTM_CHANGE, kt, kf))
 			kr6->flags |= F_BGPD_INSERTED;
@@ -1537,6 +1553,16 @@ knexthop_compare(struct knexthop *a, struct knexthop *b)
 	return (0);
 }
 
+int
+knexthop_if_compare(struct knexthop *a, struct knexthop *b)
+{
+	if (a->ifindex > b->ifindex)
+		return (1);
+	if (a->ifindex < b->ifindex)
+		return (-1);
+	return (knexthop_compare(a, b));
+}
+
 int
 kredist_compare(struct kredist_node *a, struct kredist_node *b)
 {
@@ -1642,7 +1668,6 @@ kroute_insert(struct ktable *kt, struct kroute_full *kf)
 {
 	struct kroute	*kr, *krm;
 	struct kroute6	*kr6, *kr6m;
-	struct knexthop	*n;
 	uint32_t	 mplslabel = 0;
 	int		 multipath = 0;
 
@@ -1687,6 +1712,13 @@ kroute_insert(struct ktable *kt, struct kroute_full *kf)
 				krm = krm->next;
 			krm->next = kr;
 			multipath = 1;
+		} else if (lpm_insert(&kt->lpm, &kr->prefix,
+		    kr->prefixlen) == -1) {
+			log_warn("%s", __func__);
+			RB_REMOVE(kroute_tree, &kt->krt, kr);
+			rtlabel_unref(kr->labelid);
+			free(kr);
+			return (-1);
 		}
 
 		if (kf->flags & F_BGPD)
@@ -1724,6 +1756,13 @@ kroute_insert(struct ktable *kt, struct kroute_full *kf)
 				kr6m = kr6m->next;
 			kr6m->next = kr6;
 			multipath = 1;
+		} else if (lpm_insert(&kt->lpm6, &kr6->prefix,
+		    kr6->prefixlen) == -1) {
+			log_warn("%s", __func__);
+			RB_REMOVE(kroute6_tree, &kt->krt6, kr6);
+			rtlabel_unref(kr6->labelid);
+			free(kr6);
+			return (-1);
 		}
 
 		if (kf->flags & F_BGPD)
@@ -1732,12 +1771,8 @@ kroute_insert(struct ktable *kt, struct kroute_full *kf)
 		break;
 	}
 
-	if (bgpd_has_bgpnh() || !(kf->flags & F_BGPD)) {
-		RB_FOREACH(n, knexthop_tree, KT2KNT(kt))
-			if (prefix_compare(&kf->prefix, &n->nexthop,
-			    kf->prefixlen) == 0)
-				knexthop_validate(kt, n);
-	}
+	if (bgpd_has_bgpnh() || !(kf->flags & F_BGPD))
+		knexthop_revalidate(kt, kf);
 
 	if (!(kf->flags & F_BGPD)) {
 		/* redistribute multipath routes only once */
@@ -1790,6 +1825,7 @@ kroute4_remove(struct ktable *kt, struct kroute_full *kf, int any)
 				return (-2);
 			}
 		} else {
+			lpm_remove(&kt->lpm, &krm->prefix, krm->prefixlen);
 			multipath = 0;
 		}
 	} else {
@@ -1804,13 +1840,9 @@ kroute4_remove(struct ktable *kt, struct kroute_full *kf, int any)
 		kr->next = krm->next;
 	}
 
-	/* check whether a nexthop depends on this kroute */
-	if (krm->flags & F_NEXTHOP) {
-		RB_FOREACH(n, knexthop_tree, KT2KNT(kt)) {
-			if (n->kroute == krm)
-				knexthop_validate(kt, n);
-		}
-	}
+	/* revalidate all nexthops depending on this kroute */
+	while ((n = LIST_FIRST(&krm->nexthops)) != NULL)
+		knexthop_validate(kt, n);
 
 	*kf = *kr_tofull(krm);
 
@@ -1859,6 +1891,7 @@ kroute6_remove(struct ktable *kt, struct kroute_full *kf, int any)
 				return (-2);
 			}
 		} else {
+			lpm_remove(&kt->lpm6, &krm->prefix, krm->prefixlen);
 			multipath = 0;
 		}
 	} else {
@@ -1873,13 +1906,9 @@ kroute6_remove(struct ktable *kt, struct kroute_full *kf, int any)
 		kr->next = krm->next;
 	}
 
-	/* check whether a nexthop depends on this kroute */
-	if (krm->flags & F_NEXTHOP) {
-		RB_FOREACH(n, knexthop_tree, KT2KNT(kt)) {
-			if (n->kroute == krm)
-				knexthop_validate(kt, n);
-		}
-	}
+	/* revalidate all nexthops depending on this kroute */
+	while ((n = LIST_FIRST(&krm->nexthops)) != NULL)
+		knexthop_validate(kt, n);
 
 	*kf = *kr6_tofull(krm);
 
@@ -2004,6 +2033,42 @@ knexthop_find(struct ktable *kt, struct bgpd_addr *addr)
 	return (RB_FIND(knexthop_tree, KT2KNT(kt), &s));
 }
 
+static void
+knexthop_set_ifindex(struct ktable *kt, struct knexthop *kn, u_short ifindex)
+{
+	if (kn->ifindex == ifindex)
+		return;
+	RB_REMOVE(knexthop_if_tree, KT2KNI(kt), kn);
+	kn->ifindex = ifindex;
+	RB_INSERT(knexthop_if_tree, KT2KNI(kt), kn);
+}
+
+/*
+ * Revalidate all nexthops using ifindex, if prefix is not NULL only those
+ * covered by prefix/prefixlen.
+ */
+static void
+knexthop_foreach_if(struct ktable *kt, u_short ifindex,
+    const struct bgpd_addr *prefix, uint8_t prefixlen)
+{
+	struct knexthop	 s, *kn, *nkn;
+
+	memset(&s, 0, sizeof(s));
+	s.ifindex = ifindex;
+
+	/*
+	 * knexthop_validate() moves kn to the new ifindex position in the
+	 * tree, the next element needs to be fetched before.
+	 */
+	for (kn = RB_NFIND(knexthop_if_tree, KT2KNI(kt), &s);
+	    kn != NULL && kn->ifindex == ifindex; kn = nkn) {
+		nkn = RB_NEXT(knexthop_if_tree, KT2KNI(kt), kn);
+		if (prefix == NULL ||
+		    prefix_compare(prefix, &kn->nexthop, prefixlen) == 0)
+			knexthop_validate(kt, kn);
+	}
+}
+
 int
 knexthop_insert(struct ktable *kt, struct knexthop *kn)
 {
@@ -2013,6 +2078,7 @@ knexthop_insert(struct ktable *kt, struct knexthop *kn)
 		free(kn);
 		return (-1);
 	}
+	RB_INSERT(knexthop_if_tree, KT2KNI(kt), kn);
 
 	knexthop_validate(kt, kn);
 
@@ -2023,6 +2089,7 @@ void
 knexthop_remove(struct ktable *kt, struct knexthop *kn)
 {
 	kroute_detach_nexthop(kt, kn);
+	RB_REMOVE(knexthop_if_tree, KT2KNI(kt), kn);
 	RB_REMOVE(knexthop_tree, KT2KNT(kt), kn);
 	free(kn);
 }
@@ -2237,7 +2304,8 @@ knexthop_validate(struct ktable *kt, struct knexthop *kn)
 
 		if (kr != NULL) {
 			kn->kroute = kr;
-			kn->ifindex = kr->ifindex;
+			LIST_INSERT_HEAD(&kr->nexthops, kn, kr_entry);
+			knexthop_set_ifindex(kt, kn, kr->ifindex);
 			kr->flags |= F_NEXTHOP;
 		}
 
@@ -2254,7 +2322,8 @@ knexthop_validate(struct ktable *kt, struct knexthop *kn)
 
 		if (kr6 != NULL) {
 			kn->kroute = kr6;
-			kn->ifindex = kr6->ifindex;
+			LIST_INSERT_HEAD(&kr6->nexthops, kn, kr_entry);
+			knexthop_set_ifindex(kt, kn, kr6->ifindex);
 			kr6->flags |= F_NEXTHOP;
 		}
 
@@ -2264,31 +2333,83 @@ knexthop_validate(struct ktable *kt, struct knexthop *kn)
 	}
 }
 
+/*
+ * Called when a route is added. Only nexthops covered by the new route
+ * which currently resolve via a less specific route or not at all can
+ * change, revalidate those.
+ */
+void
+knexthop_revalidate(struct ktable *kt, struct kroute_full *kf)
+{
+	struct bgpd_addr	 masked;
+	struct kroute		*kr;
+	struct kroute6		*kr6;
+	struct knexthop		*kn, *nkn;
+	int			 i;
+	uint8_t			 plens[128 + 1];
+
+	switch (kf->prefix.aid) {
+	case AID_INET:
+	case AID_VPN_IPv4:
+		i = lpm_lookup(&kt->lpm, &kf->prefix.v4, kf->prefixlen, plens);
+		while (--i >= 0) {
+			applymask(&masked, &kf->prefix, plens[i]);
+			/* all priorities of that prefix */
+			for (kr = kroute_find(kt, &masked, plens[i], RTP_ANY);
+			    kr != NULL && kr->prefixlen == plens[i] &&
+			    kr->prefix.s_addr == masked.v4.s_addr;
+			    kr = RB_NEXT(kroute_tree, &kt->krt, kr))
+				LIST_FOREACH_SAFE(kn, &kr->nexthops, kr_entry,
+				    nkn)
+					if (prefix_compare(&kf->prefix,
+					    &kn->nexthop, kf->prefixlen) == 0)
+						knexthop_validate(kt, kn);
+		}
+		break;
+	case AID_INET6:
+	case AID_VPN_IPv6:
+		i = lpm_lookup(&kt->lpm6, &kf->prefix.v6, kf->prefixlen,
+		    plens);
+		while (--i >= 0) {
+			applymask(&masked, &kf->prefix, plens[i]);
+			for (kr6 = kroute6_find(kt, &masked, plens[i], RTP_ANY);
+			    kr6 != NULL && kr6->prefixlen == plens[i] &&
+			    IN6_ARE_ADDR_EQUAL(&kr6->prefix, &masked.v6);
+			    kr6 = RB_NEXT(kroute6_tree, &kt->krt6, kr6))
+				LIST_FOREACH_SAFE(kn, &kr6->nexthops, kr_entry,
+				    nkn)
+					if (prefix_compare(&kf->prefix,
+					    &kn->nexthop, kf->prefixlen) == 0)
+						knexthop_validate(kt, kn);
+		}
+		break;
+	default:
+		return;
+	}
+
+	/* unresolved nexthops are indexed with ifindex 0 */
+	knexthop_foreach_if(kt, 0, &kf->prefix, kf->prefixlen);
+}
+
 /*
  * Called on interface state change.
  */
 void
 knexthop_track(struct ktable *kt, u_short ifindex)
 {
-	struct knexthop	*kn;
-
-	RB_FOREACH(kn, knexthop_tree, KT2KNT(kt))
-		if (kn->ifindex == ifindex)
-			knexthop_validate(kt, kn);
+	knexthop_foreach_if(kt, ifindex, NULL, 0);
 }
 
 /*
  * Called on route change.
  */
 void
-knexthop_update(struct ktable *kt, struct kroute_full *kf)
+knexthop_update(struct knexthop_head *head)
 {
 	struct knexthop	*kn;
 
-	RB_FOREACH(kn, knexthop_tree, KT2KNT(kt))
-		if (prefix_compare(&kf->prefix, &kn->nexthop,
-		    kf->prefixlen) == 0)
-			knexthop_send_update(kn);
+	LIST_FOREACH(kn, head, kr_entry)
+		knexthop_send_update(kn);
 }
 
 void
@@ -2348,10 +2469,13 @@ kroute_match(struct ktable *kt, struct bgpd_addr *key, int matchany)
 	int			 i;
 	struct kroute		*kr;
 	struct bgpd_addr	 masked;
+	uint8_t			 plens[32 + 1];
 
-	for (i = 32; i >= 0; i--) {
-		applymask(&masked, key, i);
-		if ((kr = kroute_find(kt, &masked, i, RTP_ANY)) != NULL)
+	/* only probe the prefix lengths that actually cover key */
+	i = lpm_lookup(&kt->lpm, &key->v4, 32, plens);
+	while (--i >= 0) {
+		applymask(&masked, key, plens[i]);
+		if ((kr = kroute_find(kt, &masked, plens[i], RTP_ANY)) != NULL)
 			if (matchany || bgpd_oknexthop(kr_tofull(kr)))
 				return (kr);
 	}
@@ -2365,10 +2489,13 @@ kroute6_match(struct ktable *kt, struct bgpd_addr *key, int matchany)
 	int			 i;
 	struct kroute6		*kr6;
 	struct bgpd_addr	 masked;
+	uint8_t			 plens[128 + 1];
 
-	for (i = 128; i >= 0; i--) {
-		applymask(&masked, key, i);
-		if ((kr6 = kroute6_find(kt, &masked, i, RTP_ANY)) != NULL)
+	i = lpm_lookup(&kt->lpm6, &key->v6, 128, plens);
+	while (--i >= 0) {
+		applymask(&masked, key, plens[i]);
+		if ((kr6 = kroute6_find(kt, &masked, plens[i],
+		    RTP_ANY)) != NULL)
 			if (matchany || bgpd_oknexthop(kr6_tofull(kr6)))
 				return (kr6);
 	}
@@ -2379,36 +2506,29 @@ kroute6_match(struct ktable *kt, struct bgpd_addr *key, int matchany)
 void
 kroute_detach_nexthop(struct ktable *kt, struct knexthop *kn)
 {
-	struct knexthop	*s;
 	struct kroute	*k;
 	struct kroute6	*k6;
 
 	if (kn->kroute == NULL)
 		return;
 
-	/*
-	 * check whether there's another nexthop depending on this kroute
-	 * if not remove the flag
-	 */
-	RB_FOREACH(s, knexthop_tree, KT2KNT(kt))
-		if (s->kroute == kn->kroute && s != kn)
-			break;
-
-	if (s == NULL) {
-		switch (kn->nexthop.aid) {
-		case AID_INET:
-			k = kn->kroute;
+	/* if no other nexthop depends on this kroute remove the flag */
+	LIST_REMOVE(kn, kr_entry);
+	switch (kn->nexthop.aid) {
+	case AID_INET:
+		k = kn->kroute;
+		if (LIST_EMPTY(&k->nexthops))
 			k->flags &= ~F_NEXTHOP;
-			break;
-		case AID_INET6:
-			k6 = kn->kroute;
+		break;
+	case AID_INET6:
+		k6 = kn->kroute;
+		if (LIST_EMPTY(&k6->nexthops))
 			k6->flags &= ~F_NEXTHOP;
-			break;
-		}
+		break;
 	}
 
 	kn->kroute = NULL;
-	kn->ifindex = 0;
+	knexthop_set_ifindex(kt, kn, 0);
 }
 
 /*
@@ -2698,6 +2818,7 @@ send_rtmsg(int action, struct ktable *kt, struct kroute_full *kf)
 	struct sockaddr_mpls	*mp;
 	struct sockaddr_rtlabel	*la;
 	socklen_t		 salen;
+	monotime_t		 start;
 	int			 iovcnt = 0;
 
 	if (!kt->fib_sync)
@@ -2831,6 +2952,7 @@ send_rtmsg(int action, struct ktable *kt, struct kroute_full *kf)
 		iov[iovcnt++].iov_len = ROUNDUP(salen);
 	}
 
+	start = getmonotime();
 retry:
 	if (writev(kr_state.fd, iov, iovcnt) == -1) {
 		if (errno == ESRCH) {
@@ -2847,59 +2969,96 @@ retry:
 		    log_addr(&kf->prefix), kf->prefixlen);
 		return (0);
 	}
+	latency_add(&kt->fib_latency, start);
 
 	return (1);
 }
 
+/*
+ * Dump the routes of address family af in table rtableid into buf.
+ * buf is grown as needed and can be reused for the next call.
+ */
 int
-fetchtable(struct ktable *kt)
+fetchrtdump(u_int rtableid, int af, char **buf, size_t *bufsz, size_t *len)
 {
-	size_t			 len;
-	int			 mib[7];
-	char			*buf = NULL, *next, *lim;
-	struct rt_msghdr	*rtm;
-	struct kroute_full	 kf;
+	int	 mib[7];
+	size_t	 need;
+	char	*nbuf;
 
 	mib[0] = CTL_NET;
 	mib[1] = PF_ROUTE;
 	mib[2] = 0;
-	mib[3] = 0;
+	mib[3] = af;
 	mib[4] = NET_RT_DUMP;
 	mib[5] = 0;
-	mib[6] = kt->rtableid;
+	mib[6] = rtableid;
 
-	if (sysctl(mib, 7, NULL, &len, NULL, 0) == -1) {
-		if (kt->rtableid != 0 && errno == EINVAL)
-			/* table nonexistent */
+	for (;;) {
+		if (sysctl(mib, 7, NULL, &need, NULL, 0) == -1)
+			return (-1);
+		if (need == 0) {
+			*len = 0;
 			return (0);
-		log_warn("%s: sysctl", __func__);
-		return (-1);
-	}
-	if (len > 0) {
-		if ((buf = malloc(len)) == NULL) {
-			log_warn("%s", __func__);
+		}
+		/* some slack since the table may grow until the next call */
+		need += need / 16;
+		if (need > *bufsz) {
+			if ((nbuf = realloc(*buf, need)) == NULL)
+				return (-1);
+			*buf = nbuf;
+			*bufsz = need;
+		}
+		*len = *bufsz;
+		if (sysctl(mib, 7, *buf, len, NULL, 0) == -1) {
+			if (errno == ENOMEM)
+				continue;
 			return (-1);
 		}
-		if (sysctl(mib, 7, buf, &len, NULL, 0) == -1) {
-			log_warn("%s: sysctl2", __func__);
+		return (0);
+	}
+}
+
+/*
+ * Load the kernel routing table. Each address family is fetched on its
+ * own so the temporary buffer only needs to hold the larger of the two.
+ */
+int
+fetchtable(struct ktable *kt)
+{
+	static const int	 afs[] = { AF_INET, AF_INET6 };
+	size_t			 len, bufsz = 0;
+	char			*buf = NULL, *next, *lim;
+	struct rt_msghdr	*rtm;
+	struct kroute_full	 kf;
+	u_int			 i;
+
+	for (i = 0; i < nitems(afs); i++) {
+		if (fetchrtdump(kt->rtableid, afs[i], &buf, &bufsz,
+		    &len) == -1) {
+			if (kt->rtableid != 0 && errno == EINVAL) {
+				/* table nonexistent */
+				free(buf);
+				return (0);
+			}
+			log_warn("%s: sysctl", __func__);
 			free(buf);
 			return (-1);
 		}
-	}
 
-	lim = buf + len;
-	for (next = buf; next < lim; next += rtm->rtm_msglen) {
-		rtm = (struct rt_msghdr *)next;
-		if (rtm->rtm_version != RTM_VERSION)
-			continue;
+		lim = buf + len;
+		for (next = buf; next < lim; next += rtm->rtm_msglen) {
+			rtm = (struct rt_msghdr *)next;
+			if (rtm->rtm_version != RTM_VERSION)
+				continue;
 
-		if (dispatch_rtmsg_addr(rtm, &kf) == -1)
-			continue;
+			if (dispatch_rtmsg_addr(rtm, &kf) == -1)
+				continue;
 
-		if (kf.priority == RTP_MINE)
-			send_rtmsg(RTM_DELETE, kt, &kf);
-		else
-			kroute_insert(kt, &kf);
+			if (kf.priority == RTP_MINE)
+				send_rtmsg(RTM_DELETE, kt, &kf);
+			else
+				kroute_insert(kt, &kf);
+		}
 	}
 	free(buf);
 	return (0);
@@ -3225,7 +3384,7 @@ kr_fib_change(struct ktable *kt, struct kroute_full *kf, int type, int mpath)
 					    kt, kr_tofull(kr));
 
 				if (kr->flags & F_NEXTHOP && changed)
-					knexthop_update(kt, kf);
+					knexthop_update(&kr->nexthops);
 			} else {
 				kr->flags &= ~F_BGPD_INSERTED;
 			}
@@ -3297,7 +3456,7 @@ add4:
 					    kt, kr6_tofull(kr6));
 
 				if (kr6->flags & F_NEXTHOP && changed)
-					knexthop_update(kt, kf);
+					knexthop_update(&kr6->nexthops);
 			} else {
 				kr6->flags &= ~F_BGPD_INSERTED;
 			}
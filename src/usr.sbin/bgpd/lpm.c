@@ -0,0 +1,213 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bgpd.h"
+
+/*
+ * Path compressed binary trie used as longest prefix match index.
+ * The trie only knows which prefixes exist, the routes themselves stay
+ * in the kroute RB trees. A lookup returns all prefix lengths covering
+ * an address so the caller only needs to probe those lengths instead
+ * of every possible one.
+ * Nodes with a refcnt of 0 are glue nodes which always have two children.
+ * Addresses are in network byte order, up to 128 bits long.
+ */
+struct lpm_node {
+	struct lpm_node	*child[2];
+	uint8_t		 addr[16];
+	uint32_t	 refcnt;
+	uint8_t		 plen;
+};
+
+static inline int
+lpm_bit(const uint8_t *addr, uint8_t bit)
+{
+	return (addr[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+/* number of leading bits a and b have in common, at most max */
+static uint8_t
+lpm_common(const uint8_t *a, const uint8_t *b, uint8_t max)
+{
+	uint8_t	i, x;
+
+	for (i = 0; i < max; i += 8) {
+		if ((x = a[i / 8] ^ b[i / 8]) == 0)
+			continue;
+		while ((x & 0x80) == 0) {
+			x <<= 1;
+			i++;
+		}
+		break;
+	}
+	return (i < max ? i : max);
+}
+
+static struct lpm_node *
+lpm_node_new(const uint8_t *addr, uint8_t plen, uint32_t refcnt)
+{
+	struct lpm_node	*n;
+	uint8_t		 i;
+
+	if ((n = calloc(1, sizeof(*n))) == NULL)
+		return (NULL);
+	memcpy(n->addr, addr, (plen + 7) / 8);
+	if ((i = plen % 8) != 0)
+		n->addr[plen / 8] &= 0xff << (8 - i);
+	n->plen = plen;
+	n->refcnt = refcnt;
+	return (n);
+}
+
+/*
+ * Add a reference for prefix addr/plen. Returns 0 on success and -1 if
+ * memory allocation failed, in that case the trie is not modified.
+ */
+int
+lpm_insert(struct lpm_tree *t, const void *key, uint8_t plen)
+{
+	const uint8_t	*addr = key;
+	struct lpm_node	**np, *n, *new, *glue;
+	uint8_t		 cl;
+
+	np = &t->root;
+	while ((n = *np) != NULL) {
+		cl = lpm_common(n->addr, addr,
+		    n->plen < plen ? n->plen : plen);
+		if (cl < n->plen)
+			break;
+		if (n->plen == plen) {
+			n->refcnt++;
+			return (0);
+		}
+		np = &n->child[lpm_bit(addr, n->plen)];
+	}
+
+	if ((new = lpm_node_new(addr, plen, 1)) == NULL)
+		return (-1);
+	if (n == NULL) {
+		*np = new;
+		return (0);
+	}
+
+	if (cl == plen) {
+		/* new prefix covers n */
+		new->child[lpm_bit(n->addr, plen)] = n;
+		*np = new;
+		return (0);
+	}
+
+	/* the prefixes diverge at bit cl, join them with a glue node */
+	if ((glue = lpm_node_new(addr, cl, 0)) == NULL) {
+		free(new);
+		return (-1);
+	}
+	glue->child[lpm_bit(addr, cl)] = new;
+	glue->child[lpm_bit(n->addr, cl)] = n;
+	*np = glue;
+	return (0);
+}
+
+/*
+ * Drop a reference for prefix addr/plen, the node is removed once the
+ * last reference is gone.
+ */
+void
+lpm_remove(struct lpm_tree *t, const void *key, uint8_t plen)
+{
+	const uint8_t	*addr = key;
+	struct lpm_node	**np, **pp = NULL, *n, *p;
+
+	np = &t->root;
+	while ((n = *np) != NULL) {
+		if (n->plen > plen ||
+		    lpm_common(n->addr, addr, n->plen) < n->plen)
+			return;
+		if (n->plen == plen)
+			break;
+		pp = np;
+		np = &n->child[lpm_bit(addr, n->plen)];
+	}
+	if (n == NULL || n->refcnt == 0)
+		return;
+
+	if (--n->refcnt > 0)
+		return;
+	/* keep node as glue if both children are present */
+	if (n->child[0] != NULL && n->child[1] != NULL)
+		return;
+
+	*np = n->child[0] != NULL ? n->child[0] : n->child[1];
+	free(n);
+
+	/* a glue node left with only one child is no longer needed */
+	if (pp != NULL) {
+		p = *pp;
+		if (p->refcnt == 0 &&
+		    (p->child[0] == NULL || p->child[1] == NULL)) {
+			*pp = p->child[0] != NULL ? p->child[0] : p->child[1];
+			free(p);
+		}
+	}
+}
+
+/*
+ * Store the length of all prefixes covering addr in plens, shortest first.
+ * maxlen is the address length in bits and plens needs room for maxlen + 1
+ * entries. Returns the number of prefix lengths found.
+ */
+int
+lpm_lookup(const struct lpm_tree *t, const void *key, uint8_t maxlen,
+    uint8_t *plens)
+{
+	const uint8_t		*addr = key;
+	const struct lpm_node	*n;
+	int			 cnt = 0;
+
+	for (n = t->root; n != NULL; n = n->child[lpm_bit(addr, n->plen)]) {
+		if (n->plen > maxlen ||
+		    lpm_common(n->addr, addr, n->plen) < n->plen)
+			break;
+		if (n->refcnt != 0)
+			plens[cnt++] = n->plen;
+		if (n->plen == maxlen)
+			break;
+	}
+	return (cnt);
+}
+
+static void
+lpm_free(struct lpm_node *n)
+{
+	if (n == NULL)
+		return;
+	lpm_free(n->child[0]);
+	lpm_free(n->child[1]);
+	free(n);
+}
+
+void
+lpm_flush(struct lpm_tree *t)
+{
+	lpm_free(t->root);
+	t->root = NULL;
+}
@@ -219,9 +219,10 @@ static int
 mrt_attr_dump(struct ibuf *buf, struct rde_aspath *a, struct rde_community *c,
     struct bgpd_addr *nexthop, int v2)
 {
-	struct attr	*oa;
+	struct attr	*oa, opq;
 	u_char		*pdata;
 	uint32_t	 tmp;
+	size_t		 off;
 	unsigned int	 l;
 	int		 neednewpath = 0;
 	uint16_t	 plen, afi;
@@ -276,6 +277,14 @@ mrt_attr_dump(struct ibuf *buf, struct rde_aspath *a, struct rde_community *c,
 	for (l = 0; l < a->others_len; l++) {
 		if ((oa = a->others[l]) == NULL)
 			break;
+		if (oa->type == ATTR_OPAQUE) {
+			off = 0;
+			while (attr_opaque_next(oa, &off, &opq))
+				if (attr_writebuf(buf, opq.flags, opq.type,
+				    opq.data, opq.len) == -1)
+					return (-1);
+			continue;
+		}
 		if (attr_writebuf(buf, oa->flags, oa->type,
 		    oa->data, oa->len) == -1)
 			return (-1);
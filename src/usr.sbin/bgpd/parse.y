@@ -248,6 +248,7 @@ typedef struct {
 %token	SEND RECV PLUS POLICY ROLE GRACEFUL NOTIFICATION MESSAGE
 %token	DEMOTE ENFORCE NEIGHBORAS ASOVERRIDE REFLECTOR DEPEND DOWN
 %token	DUMP IN OUT SOCKET RESTRICTED
+%token	DAMPENING HALFLIFE REUSE SUPPRESS MAXSUPPRESS ADVINTERVAL
 %token	LOG TRANSPARENT FILTERED
 %token	TCP MD5SIG PASSWORD KEY TTLSECURITY
 %token	ALLOW DENY MATCH
@@ -839,6 +840,45 @@ conf_main	: AS as4number		{
 			else
 				conf->flags |= BGPD_FLAG_PERMIT_AS_SET;
 		}
+		| DAMPENING yesno	{
+			if ($2 == 1)
+				conf->flags |= BGPD_FLAG_DAMPENING;
+			else
+				conf->flags &= ~BGPD_FLAG_DAMPENING;
+		}
+		| DAMPENING HALFLIFE NUMBER REUSE NUMBER SUPPRESS NUMBER
+		    MAXSUPPRESS NUMBER {
+			if ($3 < 1 || $3 > 45) {
+				yyerror("half-life must be between 1 and 45 "
+				    "minutes");
+				YYERROR;
+			}
+			if ($5 < 1 || $5 > DAMP_PENALTY_MAX) {
+				yyerror("reuse must be between 1 and %u",
+				    DAMP_PENALTY_MAX);
+				YYERROR;
+			}
+			if ($7 <= $5 || $7 > DAMP_PENALTY_MAX) {
+				yyerror("suppress must be between reuse and %u",
+				    DAMP_PENALTY_MAX);
+				YYERROR;
+			}
+			if ($9 < $3 || $9 > 255) {
+				yyerror("max-suppress-time must be between "
+				    "half-life and 255 minutes");
+				YYERROR;
+			}
+			/* the maximum penalty must be above suppress */
+			if ($9 / $3 < 16 && ($5 << ($9 / $3 + 1)) <= $7) {
+				yyerror("max-suppress-time too short for "
+				    "penalty to reach suppress");
+				YYERROR;
+			}
+			conf->damp.halflife = $3 * 60;
+			conf->damp.reuse = $5;
+			conf->damp.suppress = $7;
+			conf->damp.maxsuppress = $9 * 60;
+		}
 		| LOG STRING		{
 			if (!strcmp($2, "updates"))
 				conf->log |= BGPD_LOG_UPDATES;
@@ -1952,6 +1992,14 @@ peeropts	: REMOTEAS as4number	{
 			}
 			curpeer->conf.staletime = $2;
 		}
+		| ADVINTERVAL NUMBER	{
+			if ($2 < 0 || $2 > MAX_MRAI) {
+				yyerror("advertisement-interval must be "
+				    "between 0 and %u", MAX_MRAI);
+				YYERROR;
+			}
+			curpeer->conf.mrai = $2;
+		}
 		| ANNOUNCE af safi enforce {
 			if ($3 == SAFI_NONE) {
 				u_int		aid;
@@ -2264,6 +2312,12 @@ peeropts	: REMOTEAS as4number	{
 			else
 				curpeer->conf.flags |= PEERFLAG_PERMIT_AS_SET;
 		}
+		| DAMPENING yesno	{
+			if ($2 == 1)
+				curpeer->conf.flags |= PEERFLAG_DAMPENING;
+			else
+				curpeer->conf.flags &= ~PEERFLAG_DAMPENING;
+		}
 		| PORT port {
 			curpeer->conf.remote_port = $2;
 		}
@@ -3583,6 +3637,7 @@ lookup(char *s)
 		{ "IPv4",		IPV4 },
 		{ "IPv6",		IPV6 },
 		{ "add-path",		ADDPATH },
+		{ "advertisement-interval", ADVINTERVAL },
 		{ "ah",			AH },
 		{ "allow",		ALLOW },
 		{ "announce",		ANNOUNCE },
@@ -3598,6 +3653,7 @@ lookup(char *s)
 		{ "connect-retry",	CONNECTRETRY },
 		{ "connected",		CONNECTED },
 		{ "customer-as",	CUSTOMERAS },
+		{ "dampening",		DAMPENING },
 		{ "default-route",	DEFAULTROUTE },
 		{ "delete",		DELETE },
 		{ "demote",		DEMOTE },
@@ -3625,6 +3681,7 @@ lookup(char *s)
 		{ "from",		FROM },
 		{ "graceful",		GRACEFUL },
 		{ "group",		GROUP },
+		{ "half-life",		HALFLIFE },
 		{ "holdtime",		HOLDTIME },
 		{ "ibgp",		IBGP },
 		{ "ignore",		IGNORE },
@@ -3650,6 +3707,7 @@ lookup(char *s)
 		{ "max-ext-communities",	MAXEXTCOMMUNITIES },
 		{ "max-large-communities",	MAXLARGECOMMUNITIES },
 		{ "max-prefix",		MAXPREFIX },
+		{ "max-suppress-time",	MAXSUPPRESS },
 		{ "maxlen",		MAXLEN },
 		{ "md5sig",		MD5SIG },
 		{ "med",		MED },
@@ -3696,6 +3754,7 @@ lookup(char *s)
 		{ "remote-as",		REMOTEAS },
 		{ "restart",		RESTART },
 		{ "restricted",		RESTRICTED },
+		{ "reuse",		REUSE },
 		{ "rib",		RIB },
 		{ "roa-set",		ROASET },
 		{ "role",		ROLE },
@@ -3712,6 +3771,7 @@ lookup(char *s)
 		{ "spi",		SPI },
 		{ "staletime",		STALETIME },
 		{ "static",		STATIC },
+		{ "suppress",		SUPPRESS },
 		{ "tcp",		TCP },
 		{ "to",			TO },
 		{ "tos",		TOS },
@@ -4111,6 +4171,10 @@ init_config(struct bgpd_config *c)
 	c->holdtime = INTERVAL_HOLD;
 	c->staletime = INTERVAL_STALE;
 	c->connectretry = INTERVAL_CONNECTRETRY;
+	c->damp.halflife = DAMP_HALFLIFE;
+	c->damp.maxsuppress = DAMP_MAXSUPPRESS;
+	c->damp.reuse = DAMP_REUSE;
+	c->damp.suppress = DAMP_SUPPRESS;
 	c->bgpid = get_bgpid();
 	c->fib_priority = kr_default_prio();
 	c->default_tableid = getrtable();
@@ -4728,6 +4792,8 @@ alloc_peer(void)
 		p->conf.flags |= PEERFLAG_EVALUATE_ALL;
 	if (conf->flags & BGPD_FLAG_PERMIT_AS_SET)
 		p->conf.flags |= PEERFLAG_PERMIT_AS_SET;
+	if (conf->flags & BGPD_FLAG_DAMPENING)
+		p->conf.flags |= PEERFLAG_DAMPENING;
 
 	return (p);
 }
@@ -404,6 +404,17 @@ print_mainconf(struct bgpd_config *conf)
 	if (conf->flags & BGPD_FLAG_PERMIT_AS_SET)
 		printf("reject as-set no\n");
 
+	if (conf->flags & BGPD_FLAG_DAMPENING)
+		printf("dampening yes\n");
+	if (conf->damp.halflife != DAMP_HALFLIFE ||
+	    conf->damp.reuse != DAMP_REUSE ||
+	    conf->damp.suppress != DAMP_SUPPRESS ||
+	    conf->damp.maxsuppress != DAMP_MAXSUPPRESS)
+		printf("dampening half-life %u reuse %u suppress %u "
+		    "max-suppress-time %u\n", conf->damp.halflife / 60,
+		    conf->damp.reuse, conf->damp.suppress,
+		    conf->damp.maxsuppress / 60);
+
 	if (conf->log & BGPD_LOG_UPDATES)
 		printf("log updates\n");
 
@@ -811,6 +822,8 @@ print_peer(struct peer *peer, struct bgpd_config *conf, const char *c)
 		printf("%s\tholdtime min %u\n", c, p->min_holdtime);
 	if (p->staletime)
 		printf("%s\tstaletime %u\n", c, p->staletime);
+	if (p->mrai)
+		printf("%s\tadvertisement-interval %u\n", c, p->mrai);
 	if (p->export_type == EXPORT_NONE)
 		printf("%s\texport none\n", c);
 	else if (p->export_type == EXPORT_DEFAULT_ROUTE)
@@ -855,6 +868,14 @@ print_peer(struct peer *peer, struct bgpd_config *conf, const char *c)
 			printf("%s\treject as-set no\n", c);
 	}
 
+	if (conf->flags & BGPD_FLAG_DAMPENING) {
+		if (!(p->flags & PEERFLAG_DAMPENING))
+			printf("%s\tdampening no\n", c);
+	} else {
+		if (p->flags & PEERFLAG_DAMPENING)
+			printf("%s\tdampening yes\n", c);
+	}
+
 	if (p->flags & PEERFLAG_LOG_UPDATES)
 		printf("%s\tlog updates\n", c);
 
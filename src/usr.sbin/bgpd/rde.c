@@ -49,13 +49,15 @@ void		 rde_dispatch_imsg_session(struct imsgbuf *);
 void		 rde_dispatch_imsg_parent(struct imsgbuf *);
 void		 rde_dispatch_imsg_rtr(struct imsgbuf *);
 void		 rde_dispatch_imsg_peer(struct rde_peer *, void *);
+static int	 rde_dispatch_imsg_peer_one(struct rde_peer *);
 void		 rde_update_dispatch(struct rde_peer *, struct ibuf *);
 int		 rde_update_update(struct rde_peer *, uint32_t,
 		    struct filterstate *, struct bgpd_addr *, uint8_t);
 void		 rde_update_withdraw(struct rde_peer *, uint32_t,
 		    struct bgpd_addr *, uint8_t);
 int		 rde_attr_parse(struct ibuf *, struct rde_peer *,
-		    struct filterstate *, struct ibuf *, struct ibuf *);
+		    struct filterstate *, struct attr_batch *, struct ibuf *,
+		    struct ibuf *);
 int		 rde_attr_add(struct filterstate *, struct ibuf *);
 uint8_t		 rde_attr_missing(struct rde_aspath *, int, size_t);
 int		 rde_get_mp_nexthop(struct ibuf *, uint8_t,
@@ -81,11 +83,24 @@ static void	 rde_softreconfig_done(void);
 static void	 rde_softreconfig_sync_reeval(struct rib_entry *, void *);
 static void	 rde_softreconfig_sync_fib(struct rib_entry *, void *);
 static void	 rde_softreconfig_sync_done(void *, uint8_t);
+static void	 rde_softreconfig_in_path(struct rib *, struct prefix *,
+		    struct bgpd_addr *, uint8_t);
+
+struct rde_set_update;
+static void	 rde_set_update(struct ctl_set_update *, int, pid_t);
+static void	 rde_set_update_start(struct rde_set_update *);
+static void	 rde_set_update_in(struct rib_entry *, void *);
+static void	 rde_set_update_in_done(void *, uint8_t);
+static void	 rde_set_update_out_done(void *, uint8_t);
+static void	 rde_set_update_done(struct rde_set_update *);
+static void	 rde_set_update_flush(void);
+
 static void	 rde_rpki_reload(void);
 static int	 rde_roa_reload(void);
 static int	 rde_aspa_reload(void);
 int		 rde_update_queue_pending(void);
-void		 rde_update_queue_runner(uint8_t);
+int		 rde_update_queue_timeout(void);
+void		 rde_update_queue_runner(uint8_t, unsigned int);
 struct rde_prefixset *rde_find_prefixset(char *, struct rde_prefixset_head *);
 void		 rde_mark_prefixsets_dirty(struct rde_prefixset_head *,
 		    struct rde_prefixset_head *);
@@ -124,6 +139,9 @@ volatile sig_atomic_t	 rde_quit = 0;
 struct filter_head	*rules, *rules_tmp;
 struct rde_memstats	 rdemem;
 int			 softreconfig;
+static struct rde_prefixset_head prefixsets_reload =
+    SIMPLEQ_HEAD_INITIALIZER(prefixsets_reload);
+static long long	 reconf_in_filtered, reconf_in_skipped;
 static int		 rde_eval_all;
 
 extern struct peer_tree	 peertable;
@@ -132,6 +150,7 @@ extern struct rde_peer	*peerself;
 struct rde_dump_ctx {
 	LIST_ENTRY(rde_dump_ctx)	entry;
 	struct ctl_show_rib_request	req;
+	monotime_t			start;
 	uint32_t			peerid;
 	uint8_t				throttled;
 };
@@ -146,6 +165,131 @@ struct rde_mrt_ctx {
 LIST_HEAD(, rde_mrt_ctx) rde_mrts = LIST_HEAD_INITIALIZER(rde_mrts);
 u_int rde_mrt_cnt;
 
+/* prefix-set or as-set changed at runtime, paths need to be re-evaluated */
+struct rde_set_update {
+	TAILQ_ENTRY(rde_set_update)	 entry;
+	struct rde_filter_scope		**scopes;	/* per Loc-RIB */
+	void				*set;
+	char				 name[SET_NAME_LEN];
+	struct bgpd_addr		 prefix;
+	int				 type;
+	int				 pending;
+	uint16_t			 nscopes;
+	uint8_t				 prefixlen;
+	uint8_t				 in;
+	uint8_t				 out;
+	uint8_t				 aborted;
+};
+
+TAILQ_HEAD(, rde_set_update) rde_set_updates =
+    TAILQ_HEAD_INITIALIZER(rde_set_updates);
+
+/*
+ * Adaptive scheduler for the RDE work queues.
+ * Every work stage of the main loop has a quantum which limits the amount
+ * of work done per poll loop. After each loop the quantum is scaled based
+ * on the time the stage used compared to its share of the loop budget.
+ * The budget depends on the pending I/O: pending control and parent
+ * messages need a quick reply, session traffic should not be starved and
+ * if nothing else is pending large batches are processed.
+ */
+enum rde_sched_stage {
+	RDE_SCHED_IMSG,
+	RDE_SCHED_PEER,
+	RDE_SCHED_RIBDUMP,
+	RDE_SCHED_NEXTHOP,
+	RDE_SCHED_UPDATE,
+	RDE_SCHED_MAX
+};
+
+#define RDE_SCHED_CTL_USEC	5000
+#define RDE_SCHED_BUSY_USEC	20000
+#define RDE_SCHED_IDLE_USEC	100000
+
+static const struct rde_sched_limit {
+	unsigned int	min;
+	unsigned int	max;
+} rde_sched_limits[RDE_SCHED_MAX] = {
+	[RDE_SCHED_IMSG] = { 1, 64 },
+	[RDE_SCHED_PEER] = { 1, 64 },
+	/* the rib dump quantum is a time budget in usec */
+	[RDE_SCHED_RIBDUMP] = { 1000, RDE_SCHED_IDLE_USEC },
+	[RDE_SCHED_NEXTHOP] = { RDE_RUNNER_ROUNDS, 64 * RDE_RUNNER_ROUNDS },
+	[RDE_SCHED_UPDATE] = { RDE_RUNNER_ROUNDS, 64 * RDE_RUNNER_ROUNDS },
+};
+
+static struct rde_sched {
+	unsigned int	quantum[RDE_SCHED_MAX];
+	long long	budget;
+	uint8_t		pending;
+} rde_sched = {
+	.quantum = {
+		[RDE_SCHED_IMSG] = 1,
+		[RDE_SCHED_PEER] = 1,
+		[RDE_SCHED_RIBDUMP] = 10000,
+		[RDE_SCHED_NEXTHOP] = RDE_RUNNER_ROUNDS,
+		[RDE_SCHED_UPDATE] = RDE_RUNNER_ROUNDS,
+	},
+	.budget = RDE_SCHED_BUSY_USEC,
+};
+
+static int
+rde_sched_pending(void)
+{
+	rde_sched.pending = 0;
+	if (peer_work_pending())
+		rde_sched.pending |= 1 << RDE_SCHED_IMSG | 1 << RDE_SCHED_PEER;
+	if (rib_dump_pending())
+		rde_sched.pending |= 1 << RDE_SCHED_RIBDUMP;
+	if (nexthop_pending())
+		rde_sched.pending |= 1 << RDE_SCHED_NEXTHOP;
+	if (rde_update_queue_pending())
+		rde_sched.pending |= 1 << RDE_SCHED_UPDATE;
+	return rde_sched.pending != 0;
+}
+
+static void
+rde_sched_start(struct pollfd *pfd)
+{
+	if (pfd[PFD_PIPE_MAIN].revents & POLLIN ||
+	    pfd[PFD_PIPE_SESSION_CTL].revents & POLLIN)
+		rde_sched.budget = RDE_SCHED_CTL_USEC;
+	else if (pfd[PFD_PIPE_SESSION].revents & POLLIN ||
+	    pfd[PFD_PIPE_ROA].revents & POLLIN)
+		rde_sched.budget = RDE_SCHED_BUSY_USEC;
+	else
+		rde_sched.budget = RDE_SCHED_IDLE_USEC;
+}
+
+static void
+rde_sched_adjust(enum rde_sched_stage stage, long long usec)
+{
+	const struct rde_sched_limit *lim = &rde_sched_limits[stage];
+	unsigned int *quantum = &rde_sched.quantum[stage];
+	long long share;
+
+	if ((rde_sched.pending & (1 << stage)) == 0)
+		return;
+
+	share = rde_sched.budget / RDE_SCHED_MAX;
+	if (usec > share) {
+		/* stage used more than its share, back off */
+		*quantum /= 2;
+		if (*quantum < lim->min)
+			*quantum = lim->min;
+	} else if (usec < share / 2) {
+		/* work is pending and there is time left, grow */
+		if (*quantum > lim->max / 2)
+			*quantum = lim->max;
+		else
+			*quantum *= 2;
+	}
+
+	/* the rib dump budget is limited by the share */
+	if (stage == RDE_SCHED_RIBDUMP && *quantum > share)
+		*quantum = share > lim->min ? share : lim->min;
+}
+
 void
 rde_sighdlr(int sig)
 {
@@ -163,11 +307,12 @@ rde_main(int debug, int verbose)
 	struct passwd		*pw;
 	struct pollfd		*pfd = NULL;
 	struct rde_mrt_ctx	*mctx, *xmctx;
-	monotime_t		 loop_start, io_end, peer_end, adjout_end,
+	monotime_t		 loop_start, io_end, imsg_end, peer_end,
 				 dump_end, nh_end;
+	long long		 usec;
 	void			*newp;
 	u_int			 pfd_elms = 0, i, j;
-	int			 timeout;
+	int			 timeout, mrai_timeout;
 	u_int			 aid;
 
 	log_init(debug, LOG_DAEMON);
@@ -214,9 +359,11 @@ rde_main(int debug, int verbose)
 
 	pt_init();
 	attr_init();
+	attrcache_init();
 	path_init();
 	adjout_init();
 	communities_init();
+	rde_damp_init();
 	peer_init(rules);
 
 	/* make sure the default RIBs are setup */
@@ -240,7 +387,11 @@ rde_main(int debug, int verbose)
 			pfd = newp;
 			pfd_elms = PFD_PIPE_COUNT + rde_mrt_cnt;
 		}
-		timeout = -1;
+		timeout = rde_damp_timeout();
+		mrai_timeout = rde_update_queue_timeout();
+		if (mrai_timeout != -1 &&
+		    (timeout == -1 || mrai_timeout < timeout))
+			timeout = mrai_timeout;
 		memset(pfd, 0, sizeof(struct pollfd) * pfd_elms);
 
 		set_pollfd(&pfd[PFD_PIPE_MAIN], ibuf_main);
@@ -265,8 +416,7 @@ rde_main(int debug, int verbose)
 			}
 		}
 
-		if (peer_work_pending() || rde_update_queue_pending() ||
-		    nexthop_pending() || rib_dump_pending())
+		if (rde_sched_pending())
 			timeout = 0;
 
 		rdemem.rde_event_loop_usec +=
@@ -280,6 +430,7 @@ rde_main(int debug, int verbose)
 
 		rdemem.rde_event_loop_count++;
 		loop_start = getmonotime();
+		rde_sched_start(pfd);
 
 		if (handle_pollfd(&pfd[PFD_PIPE_MAIN], ibuf_main) == -1) {
 			log_warnx("RDE: Lost connection to parent");
@@ -325,37 +476,48 @@ rde_main(int debug, int verbose)
 		rdemem.rde_event_io_usec +=
 		    monotime_to_usec(monotime_sub(io_end, loop_start));
 
-		peer_foreach(rde_dispatch_imsg_peer, NULL);
+		peer_foreach(rde_dispatch_imsg_peer,
+		    &rde_sched.quantum[RDE_SCHED_IMSG]);
 
-		peer_end = getmonotime();
-		rdemem.rde_event_peer_usec +=
-		    monotime_to_usec(monotime_sub(peer_end, io_end));
+		imsg_end = getmonotime();
+		usec = monotime_to_usec(monotime_sub(imsg_end, io_end));
+		rdemem.rde_event_peer_usec += usec;
+		rde_sched_adjust(RDE_SCHED_IMSG, usec);
+
+		/* release dampened paths before the Adj-RIB-Out runs */
+		rde_damp_run();
 
-		peer_foreach(peer_process_updates, NULL);
+		peer_foreach(peer_process_updates,
+		    &rde_sched.quantum[RDE_SCHED_PEER]);
 
-		adjout_end = getmonotime();
-		rdemem.rde_event_adjout_usec +=
-		    monotime_to_usec(monotime_sub(adjout_end, peer_end));
+		peer_end = getmonotime();
+		usec = monotime_to_usec(monotime_sub(peer_end, imsg_end));
+		rdemem.rde_event_adjout_usec += usec;
+		rde_sched_adjust(RDE_SCHED_PEER, usec);
 
-		rib_dump_runner();
+		rib_dump_runner(rde_sched.quantum[RDE_SCHED_RIBDUMP]);
 
 		dump_end = getmonotime();
-		rdemem.rde_event_ribdump_usec +=
-		    monotime_to_usec(monotime_sub(dump_end, adjout_end));
+		usec = monotime_to_usec(monotime_sub(dump_end, peer_end));
+		rdemem.rde_event_ribdump_usec += usec;
+		rde_sched_adjust(RDE_SCHED_RIBDUMP, usec);
 
-		nexthop_runner();
+		nexthop_runner(rde_sched.quantum[RDE_SCHED_NEXTHOP]);
 
 		nh_end = getmonotime();
-		rdemem.rde_event_nexthop_usec +=
-		    monotime_to_usec(monotime_sub(nh_end, dump_end));
+		usec = monotime_to_usec(monotime_sub(nh_end, dump_end));
+		rdemem.rde_event_nexthop_usec += usec;
+		rde_sched_adjust(RDE_SCHED_NEXTHOP, usec);
 
 		if (ibuf_se && imsgbuf_queuelen(ibuf_se) < SESS_MSG_HIGH_MARK) {
 			for (aid = AID_MIN; aid < AID_MAX; aid++)
-				rde_update_queue_runner(aid);
+				rde_update_queue_runner(aid,
+				    rde_sched.quantum[RDE_SCHED_UPDATE]);
 		}
 
-		rdemem.rde_event_update_usec +=
-		    monotime_to_usec(monotime_sub(getmonotime(), nh_end));
+		usec = monotime_to_usec(monotime_sub(getmonotime(), nh_end));
+		rdemem.rde_event_update_usec += usec;
+		rde_sched_adjust(RDE_SCHED_UPDATE, usec);
 
 		/* commit pftable once per poll loop */
 		rde_commit_pftable();
@@ -456,6 +618,7 @@ rde_dispatch_imsg_session(struct imsgbuf *imsgbuf)
 	struct ibuf		 ibuf;
 	struct rde_peer_stats	 stats;
 	struct ctl_show_set	 cset;
+	struct ctl_set_update	 setupd;
 	struct ctl_show_rib	 csr;
 	struct ctl_show_rib_request	req;
 	struct session_up	 sup;
@@ -849,6 +1012,16 @@ badnetdel:
 			imsg_compose(ibuf_se_ctl, IMSG_CTL_END, 0, pid,
 			    -1, NULL, 0);
 			break;
+		case IMSG_CTL_SET_ADD:
+		case IMSG_CTL_SET_DELETE:
+			if (imsg_get_data(&imsg, &setupd,
+			    sizeof(setupd)) == -1) {
+				log_warnx("rde_dispatch: wrong imsg len");
+				break;
+			}
+			rde_set_update(&setupd,
+			    imsg_get_type(&imsg) == IMSG_CTL_SET_ADD, pid);
+			break;
 		case IMSG_CTL_LOG_VERBOSE:
 			if (imsg_get_data(&imsg, &verbose, sizeof(verbose)) ==
 			    -1)
@@ -904,7 +1077,8 @@ rde_dispatch_imsg_parent(struct imsgbuf *imsgbuf)
 	struct filterstate	 state;
 	struct kroute_nexthop	 knext;
 	struct mrt		 xmrt;
-	struct prefixset_item	 psi;
+	struct prefixset_item_msg psim;
+	struct bgpd_addr	 addr;
 	struct rde_rib		 rr;
 	struct roa		 roa;
 	char			 name[SET_NAME_LEN];
@@ -1200,24 +1374,43 @@ rde_dispatch_imsg_parent(struct imsgbuf *imsgbuf)
 			last_prefixset = ps;
 			break;
 		case IMSG_RECONF_ROA_ITEM:
-			if (imsg_get_data(&imsg, &roa, sizeof(roa)) == -1)
+			/* batch of roas */
+			if (imsg_get_ibuf(&imsg, &ibuf) == -1 ||
+			    ibuf_size(&ibuf) % sizeof(roa) != 0)
 				fatalx("IMSG_RECONF_ROA_ITEM bad len");
-			if (trie_roa_add(&last_prefixset->th, &roa) != 0) {
-				log_warnx("trie_roa_add %s failed",
-				    log_roa(&roa));
+			if (last_prefixset == NULL)
+				fatalx("King Bula has no originset");
+			while (ibuf_size(&ibuf) > 0) {
+				if (ibuf_get(&ibuf, &roa, sizeof(roa)) == -1)
+					fatal("ibuf_get");
+				if (trie_roa_add(&last_prefixset->th,
+				    &roa) != 0)
+					log_warnx("trie_roa_add %s failed",
+					    log_roa(&roa));
 			}
 			break;
 		case IMSG_RECONF_PREFIX_SET_ITEM:
-			if (imsg_get_data(&imsg, &psi, sizeof(psi)) == -1)
+			/* batch of prefixset_item_msg */
+			if (imsg_get_ibuf(&imsg, &ibuf) == -1 ||
+			    ibuf_size(&ibuf) % sizeof(psim) != 0)
 				fatalx("IMSG_RECONF_PREFIX_SET_ITEM bad len");
 			if (last_prefixset == NULL)
 				fatalx("King Bula has no prefixset");
-			if (trie_add(&last_prefixset->th,
-			    &psi.p.addr, psi.p.len,
-			    psi.p.len_min, psi.p.len_max) != 0) {
-				log_warnx("trie_add(%s) %s/%u failed",
-				    last_prefixset->name, log_addr(&psi.p.addr),
-				    psi.p.len);
+			while (ibuf_size(&ibuf) > 0) {
+				if (ibuf_get(&ibuf, &psim, sizeof(psim)) == -1)
+					fatal("ibuf_get");
+				memset(&addr, 0, sizeof(addr));
+				addr.aid = psim.aid;
+				if (addr.aid == AID_INET6)
+					addr.v6 = psim.addr.v6;
+				else
+					addr.v4 = psim.addr.v4;
+				if (trie_add(&last_prefixset->th, &addr,
+				    psim.len, psim.len_min,
+				    psim.len_max) != 0)
+					log_warnx("trie_add(%s) %s/%u failed",
+					    last_prefixset->name,
+					    log_addr(&addr), psim.len);
 			}
 			break;
 		case IMSG_RECONF_AS_SET:
@@ -1331,6 +1524,7 @@ rde_dispatch_imsg_rtr(struct imsgbuf *imsgbuf)
 {
 	static struct aspa_set	*aspa;
 	struct imsg		 imsg;
+	struct ibuf		 ibuf;
 	struct roa		 roa;
 	struct aspa_prep	 ap;
 	int			 n;
@@ -1347,11 +1541,16 @@ rde_dispatch_imsg_rtr(struct imsgbuf *imsgbuf)
 			trie_free(&roa_new.th);	/* clear new roa */
 			break;
 		case IMSG_RECONF_ROA_ITEM:
-			if (imsg_get_data(&imsg, &roa, sizeof(roa)) == -1)
+			/* batch of roas */
+			if (imsg_get_ibuf(&imsg, &ibuf) == -1 ||
+			    ibuf_size(&ibuf) % sizeof(roa) != 0)
 				fatalx("IMSG_RECONF_ROA_ITEM bad len");
-			if (trie_roa_add(&roa_new.th, &roa) != 0) {
-				log_warnx("trie_roa_add %s failed",
-				    log_roa(&roa));
+			while (ibuf_size(&ibuf) > 0) {
+				if (ibuf_get(&ibuf, &roa, sizeof(roa)) == -1)
+					fatal("ibuf_get");
+				if (trie_roa_add(&roa_new.th, &roa) != 0)
+					log_warnx("trie_roa_add %s failed",
+					    log_roa(&roa));
 			}
 			break;
 		case IMSG_RECONF_ASPA_PREP:
@@ -1401,27 +1600,59 @@ rde_dispatch_imsg_rtr(struct imsgbuf *imsgbuf)
 	}
 }
 
+/*
+ * Process up to *quantum queued imsgs of peer.
+ */
 void
-rde_dispatch_imsg_peer(struct rde_peer *peer, void *bula)
+rde_dispatch_imsg_peer(struct rde_peer *peer, void *arg)
 {
-	struct route_refresh rr;
-	struct imsg imsg;
-	struct ibuf ibuf;
+	unsigned int *quantum = arg, n;
 
-	if (!peer_is_up(peer)) {
-		peer_imsg_flush(peer);
-		return;
+	for (n = 0; n < *quantum; n++) {
+		if (!peer_is_up(peer)) {
+			peer_imsg_flush(peer);
+			return;
+		}
+		if (!rde_dispatch_imsg_peer_one(peer))
+			return;
 	}
+}
+
+static int
+rde_dispatch_imsg_peer_one(struct rde_peer *peer)
+{
+	struct route_refresh rr;
+	struct imsg imsg;
+	struct ibuf ibuf, msg;
+	monotime_t start;
+	unsigned long long queued;
+	uint16_t len;
 
 	if (!peer_imsg_pop(peer, &imsg))
-		return;
+		return 0;
 
 	switch (imsg_get_type(&imsg)) {
 	case IMSG_UPDATE:
-		if (imsg_get_ibuf(&imsg, &ibuf) == -1)
+		if (imsg_get_ibuf(&imsg, &ibuf) == -1) {
 			log_warn("update: bad imsg");
-		else
-			rde_update_dispatch(peer, &ibuf);
+			break;
+		}
+		/* batch of UPDATE messages, each prefixed by its length */
+		while (ibuf_size(&ibuf) > 0 && peer_is_up(peer)) {
+			if (ibuf_get_n16(&ibuf, &len) == -1 ||
+			    ibuf_get_ibuf(&ibuf, len, &msg) == -1) {
+				log_warnx("update: bad imsg");
+				break;
+			}
+			start = getmonotime();
+			queued = peer->stats.rib_entry_count;
+			rde_update_dispatch(peer, &msg);
+			/* done once the queued rib entries are processed */
+			if (peer->stats.rib_entry_count > queued)
+				peer_latency_mark(peer, start);
+			else
+				rde_latency_add(RDE_LAT_UPDATE, start);
+		}
 		break;
 	case IMSG_REFRESH:
 		if (imsg_get_data(&imsg, &rr, sizeof(rr)) == -1) {
@@ -1476,6 +1707,7 @@ rde_dispatch_imsg_peer(struct rde_peer *peer, void *bula)
 	}
 
 	imsg_free(&imsg);
+	return 1;
 }
 
 /* handle routing updates from the session engine. */
@@ -1483,11 +1715,15 @@ void
 rde_update_dispatch(struct rde_peer *peer, struct ibuf *buf)
 {
 	struct filterstate	 state;
+	struct attr_batch	 batch;
 	struct bgpd_addr	 prefix;
 	struct ibuf		 wdbuf, attrbuf, nlribuf, reachbuf, unreachbuf;
+	struct ibuf		 cachebuf;
+	uint64_t		 cachehash;
 	uint16_t		 afi, len;
 	uint8_t			 aid, prefixlen, safi, subtype;
 	uint32_t		 fas, pathid;
+	int			 cached;
 
 	if (ibuf_get_n16(buf, &len) == -1 ||
 	    ibuf_get_ibuf(buf, len, &wdbuf) == -1 ||
@@ -1517,11 +1753,22 @@ rde_update_dispatch(struct rde_peer *peer, struct ibuf *buf)
 	ibuf_from_buffer(&unreachbuf, NULL, 0);
 	rde_filterstate_init(&state);
 	if (ibuf_size(&attrbuf) != 0) {
-		/* parse path attributes */
-		while (ibuf_size(&attrbuf) > 0) {
-			if (rde_attr_parse(&attrbuf, peer, &state, &reachbuf,
-			    &unreachbuf) == -1)
-				goto done;
+		/* parse path attributes unless the same set was seen before */
+		ibuf_from_ibuf(&cachebuf, &attrbuf);
+		cached = attrcache_lookup(peer, &cachebuf, &state, &reachbuf,
+		    &unreachbuf, &cachehash);
+		if (cached != 1) {
+			attr_batch_init(&batch);
+			while (ibuf_size(&attrbuf) > 0) {
+				if (rde_attr_parse(&attrbuf, peer, &state,
+				    &batch, &reachbuf, &unreachbuf) == -1)
+					goto done;
+			}
+			/* intern all optional attributes in one go */
+			attr_batch_commit(&state.aspath, &batch);
+			if (cached == 0)
+				attrcache_insert(peer, &cachebuf, cachehash,
+				    &state);
 		}
 
 		/* check for missing but necessary attributes */
@@ -1978,10 +2225,12 @@ rde_update_update(struct rde_peer *peer, uint32_t path_id,
     struct filterstate *in, struct bgpd_addr *prefix, uint8_t prefixlen)
 {
 	struct filterstate	 state;
+	struct prefix		*p;
 	enum filter_action	 action;
 	uint32_t		 path_id_tx;
 	uint16_t		 i;
 	uint8_t			 roa_state, aspa_state;
+	int			 changed = 0;
 	const char		*wmsg = "filtered, withdraw";
 
 	peer->stats.prefix_rcvd_update++;
@@ -1992,6 +2241,17 @@ rde_update_update(struct rde_peer *peer, uint32_t path_id,
 	rde_filterstate_set_vstate(in, roa_state, aspa_state);
 
 	path_id_tx = pathid_assign(peer, path_id, prefix, prefixlen);
+	if (peer->flags & PEERFLAG_DAMPENING) {
+		/* an attribute change counts as a flap */
+		p = prefix_get(rib_byid(RIB_ADJ_IN), peer, path_id, prefix,
+		    prefixlen);
+		if (p != NULL && (prefix_nexthop(p) != in->nexthop ||
+		    !communities_equal(&in->communities,
+		    prefix_communities(p)) ||
+		    !path_equal(&in->aspath, prefix_aspath(p))))
+			changed = 1;
+	}
+
 	/* add original path to the Adj-RIB-In */
 	if (prefix_update(rib_byid(RIB_ADJ_IN), peer, path_id, path_id_tx,
 	    in, 0, prefix, prefixlen) == 1)
@@ -2009,6 +2269,25 @@ rde_update_update(struct rde_peer *peer, uint32_t path_id,
 	if (in->aspath.flags & F_ATTR_PARSE_ERR)
 		wmsg = "path invalid, withdraw";
 
+	/* dampened paths stay in the Adj-RIB-In but not in the Loc-RIBs */
+	if (peer->flags & PEERFLAG_DAMPENING) {
+		p = prefix_get(rib_byid(RIB_ADJ_IN), peer, path_id, prefix,
+		    prefixlen);
+		if (p != NULL && rde_damp_update(peer, path_id, p->pt,
+		    changed)) {
+			for (i = RIB_LOC_START; i < rib_size; i++) {
+				struct rib *rib = rib_byid(i);
+				if (rib == NULL)
+					continue;
+				if (prefix_withdraw(rib, peer, path_id, prefix,
+				    prefixlen))
+					rde_update_log("dampened, withdraw", i,
+					    peer, NULL, prefix, prefixlen);
+			}
+			return (0);
+		}
+	}
+
 	for (i = RIB_LOC_START; i < rib_size; i++) {
 		struct rib *rib = rib_byid(i);
 		if (rib == NULL)
@@ -2044,7 +2323,15 @@ void
 rde_update_withdraw(struct rde_peer *peer, uint32_t path_id,
     struct bgpd_addr *prefix, uint8_t prefixlen)
 {
-	uint16_t i;
+	struct prefix	*p;
+	uint16_t	 i;
+
+	if (peer->flags & PEERFLAG_DAMPENING) {
+		p = prefix_get(rib_byid(RIB_ADJ_IN), peer, path_id, prefix,
+		    prefixlen);
+		if (p != NULL)
+			rde_damp_withdraw(peer, path_id, p->pt);
+	}
 
 	for (i = RIB_LOC_START; i < rib_size; i++) {
 		struct rib *rib = rib_byid(i);
@@ -2073,7 +2360,8 @@ rde_update_withdraw(struct rde_peer *peer, uint32_t path_id,
 
 int
 rde_attr_parse(struct ibuf *buf, struct rde_peer *peer,
-    struct filterstate *state, struct ibuf *reach, struct ibuf *unreach)
+    struct filterstate *state, struct attr_batch *batch, struct ibuf *reach,
+    struct ibuf *unreach)
 {
 	struct bgpd_addr nexthop;
 	struct rde_aspath *a = &state->aspath;
@@ -2258,6 +2546,7 @@ rde_attr_parse(struct ibuf *buf, struct rde_peer *peer,
 				    "AS 0 not allowed, attribute discarded");
 				break;
 			}
+			/* t is on the stack, can't be batched */
 			if (attr_optadd(a, flags, type, t, sizeof(t)) == -1)
 				goto bad_list;
 			break;
@@ -2438,8 +2727,13 @@ rde_attr_parse(struct ibuf *buf, struct rde_peer *peer,
 			    &attrbuf);
 			return (-1);
 		}
+		/* nothing looks at unknown attributes, keep them packed */
+		if (attr_batch_opaque(batch, flags, type, ibuf_data(&attrbuf),
+		    ibuf_size(&attrbuf)) == -1)
+			goto bad_list;
+		break;
  optattr:
-		if (attr_optadd(a, flags, type, ibuf_data(&attrbuf),
+		if (attr_batch_add(a, batch, flags, type, ibuf_data(&attrbuf),
 		    ibuf_size(&attrbuf)) == -1)
 			goto bad_list;
 		break;
@@ -2497,6 +2791,8 @@ rde_attr_add(struct filterstate *state, struct ibuf *buf)
 		return (-1);
 
 	switch (type) {
+	case ATTR_OPAQUE:
+		return (-1);
 	case ATTR_COMMUNITIES:
 		return community_add(&state->communities, flags, buf);
 	case ATTR_LARGE_COMMUNITIES:
@@ -2915,6 +3211,31 @@ rde_reflector(struct rde_peer *peer, struct rde_aspath *asp)
 /*
  * control specific functions
  */
+static int
+rde_dump_attr(struct attr *a, pid_t pid)
+{
+	struct ibuf	*wbuf;
+	struct attr	 oa;
+	size_t		 off = 0;
+
+	if (a->type == ATTR_OPAQUE) {
+		while (attr_opaque_next(a, &off, &oa))
+			if (rde_dump_attr(&oa, pid) == -1)
+				return (-1);
+		return (0);
+	}
+
+	if ((wbuf = imsg_create(ibuf_se_ctl, IMSG_CTL_SHOW_RIB_ATTR, 0, pid,
+	    0)) == NULL)
+		return (-1);
+	if (attr_writebuf(wbuf, a->flags, a->type, a->data, a->len) == -1) {
+		ibuf_free(wbuf);
+		return (-1);
+	}
+	imsg_close(ibuf_se_ctl, wbuf);
+	return (0);
+}
+
 static void
 rde_dump_rib_as(struct prefix *p, struct rde_aspath *asp, pid_t pid, int flags)
 {
@@ -2987,6 +3308,8 @@ rde_dump_rib_as(struct prefix *p, struct rde_aspath *asp, pid_t pid, int flags)
 		rib.flags |= F_PREF_ELIGIBLE;
 	if (prefix_filtered(p))
 		rib.flags |= F_PREF_FILTERED;
+	if (rde_damp_suppressed(peer, p->path_id, p->pt))
+		rib.flags |= F_PREF_DAMPENED;
 	/* otc loop includes parse err so skip the latter if the first is set */
 	if (asp->flags & F_ATTR_OTC_LEAK)
 		rib.flags |= F_PREF_OTC_LEAK;
@@ -3022,15 +3345,8 @@ rde_dump_rib_as(struct prefix *p, struct rde_aspath *asp, pid_t pid, int flags)
 		for (l = 0; l < asp->others_len; l++) {
 			if ((a = asp->others[l]) == NULL)
 				break;
-			if ((wbuf = imsg_create(ibuf_se_ctl,
-			    IMSG_CTL_SHOW_RIB_ATTR, 0, pid, 0)) == NULL)
-				return;
-			if (attr_writebuf(wbuf, a->flags, a->type, a->data,
-			    a->len) == -1) {
-				ibuf_free(wbuf);
+			if (rde_dump_attr(a, pid) == -1)
 				return;
-			}
-			imsg_close(ibuf_se_ctl, wbuf);
 		}
 	}
 }
@@ -3101,15 +3417,8 @@ rde_dump_adjout_as(struct rde_peer *peer, struct pt_entry *pte,
 		for (l = 0; l < asp->others_len; l++) {
 			if ((a = asp->others[l]) == NULL)
 				break;
-			if ((wbuf = imsg_create(ibuf_se_ctl,
-			    IMSG_CTL_SHOW_RIB_ATTR, 0, pid, 0)) == NULL)
-				return;
-			if (attr_writebuf(wbuf, a->flags, a->type, a->data,
-			    a->len) == -1) {
-				ibuf_free(wbuf);
+			if (rde_dump_attr(a, pid) == -1)
 				return;
-			}
-			imsg_close(ibuf_se_ctl, wbuf);
 		}
 	}
 }
@@ -3148,6 +3457,9 @@ rde_dump_filter(struct prefix *p, struct ctl_show_rib_request *req)
 		return;
 	if ((req->flags & F_CTL_FILTERED) && !prefix_filtered(p))
 		return;
+	if ((req->flags & F_CTL_DAMPENED) &&
+	    !rde_damp_suppressed(prefix_peer(p), p->path_id, p->pt))
+		return;
 	if ((req->flags & F_CTL_INELIGIBLE) && prefix_eligible(p))
 		return;
 	if ((req->flags & F_CTL_LEAKED) &&
@@ -3264,6 +3576,7 @@ rde_dump_done(void *arg, uint8_t aid)
 	}
 done:
 	imsg_compose(ibuf_se_ctl, IMSG_CTL_END, 0, ctx->req.pid, -1, NULL, 0);
+	rde_latency_add(RDE_LAT_CONTROL, ctx->start);
 	LIST_REMOVE(ctx, entry);
 	free(ctx);
 	return;
@@ -3303,8 +3616,9 @@ rde_dump_ctx_new(struct ctl_show_rib_request *req, pid_t pid,
 	memcpy(&ctx->req, req, sizeof(struct ctl_show_rib_request));
 	ctx->req.pid = pid;
 	ctx->req.type = type;
+	ctx->start = getmonotime();
 
-	if (req->flags & (F_CTL_ADJ_IN | F_CTL_INVALID)) {
+	if (req->flags & (F_CTL_ADJ_IN | F_CTL_INVALID | F_CTL_DAMPENED)) {
 		rid = RIB_ADJ_IN;
 	} else if (req->flags & F_CTL_ADJ_OUT) {
 		struct rde_peer *peer;
@@ -3415,6 +3729,7 @@ rde_dump_ctx_new(struct ctl_show_rib_request *req, pid_t pid,
 
 			imsg_compose(ibuf_se_ctl, IMSG_CTL_END, 0, ctx->req.pid,
 			    -1, NULL, 0);
+			rde_latency_add(RDE_LAT_CONTROL, ctx->start);
 			free(ctx);
 			return;
 		default:
@@ -3486,6 +3801,7 @@ rde_dump_ctx_new(struct ctl_show_rib_request *req, pid_t pid,
 		}
 		imsg_compose(ibuf_se_ctl, IMSG_CTL_END, 0, ctx->req.pid,
 		    -1, NULL, 0);
+		rde_latency_add(RDE_LAT_CONTROL, ctx->start);
 		free(ctx);
 		return;
 	default:
@@ -3672,10 +3988,23 @@ rde_up_flush_upcall(struct pt_entry *pte, struct adjout_prefix *p,
 	adjout_prefix_withdraw(peer, pte, p, 0);
 }
 
+/*
+ * Check if updates to peer are held back by the minimum route
+ * advertisement interval. Withdraws are never delayed.
+ */
+static inline int
+rde_update_mrai_hold(struct rde_peer *peer, uint8_t aid, monotime_t now)
+{
+	if (peer->conf.mrai == 0)
+		return 0;
+	return monotime_cmp(now, peer->mrai_next[aid]) < 0;
+}
+
 int
 rde_update_queue_pending(void)
 {
 	struct rde_peer *peer;
+	monotime_t now = getmonotime();
 	u_int aid;
 
 	if (ibuf_se && imsgbuf_queuelen(ibuf_se) >= SESS_MSG_HIGH_MARK)
@@ -3689,19 +4018,53 @@ rde_update_queue_pending(void)
 		if (peer->throttled)
 			continue;
 		for (aid = AID_MIN; aid < AID_MAX; aid++) {
-			if (!TAILQ_EMPTY(&peer->updates[aid]) ||
-			    !TAILQ_EMPTY(&peer->withdraws[aid]))
+			if (!TAILQ_EMPTY(&peer->withdraws[aid]))
+				return 1;
+			if (!TAILQ_EMPTY(&peer->updates[aid]) &&
+			    !rde_update_mrai_hold(peer, aid, now))
 				return 1;
 		}
 	}
 	return 0;
 }
 
+/*
+ * Return the poll timeout in milliseconds until the first update held
+ * back by the advertisement interval can be sent or -1 if there is none.
+ */
+int
+rde_update_queue_timeout(void)
+{
+	struct rde_peer *peer;
+	monotime_t now = getmonotime(), next = monotime_clear();
+	u_int aid;
+
+	RB_FOREACH(peer, peer_tree, &peertable) {
+		if (peer->conf.id == 0 || peer->conf.mrai == 0)
+			continue;
+		if (!peer_is_up(peer))
+			continue;
+		for (aid = AID_MIN; aid < AID_MAX; aid++) {
+			if (TAILQ_EMPTY(&peer->updates[aid]) ||
+			    !rde_update_mrai_hold(peer, aid, now))
+				continue;
+			if (!monotime_valid(next) ||
+			    monotime_cmp(peer->mrai_next[aid], next) < 0)
+				next = peer->mrai_next[aid];
+		}
+	}
+	if (!monotime_valid(next))
+		return -1;
+	/* round up to not wake up just before the deadline */
+	return (monotime_to_usec(monotime_sub(next, now)) + 999) / 1000;
+}
+
 void
-rde_update_queue_runner(uint8_t aid)
+rde_update_queue_runner(uint8_t aid, unsigned int rounds)
 {
 	struct rde_peer		*peer;
-	int			 sent, max = RDE_RUNNER_ROUNDS;
+	monotime_t		 now = getmonotime();
+	int			 sent, max = rounds;
 
 	/* first withdraws ... */
 	do {
@@ -3723,7 +4086,7 @@ rde_update_queue_runner(uint8_t aid)
 	} while (sent != 0 && max > 0);
 
 	/* ... then updates */
-	max = RDE_RUNNER_ROUNDS;
+	max = rounds;
 	do {
 		sent = 0;
 		RB_FOREACH(peer, peer_tree, &peertable) {
@@ -3745,9 +4108,20 @@ rde_update_queue_runner(uint8_t aid)
 					    ROUTE_REFRESH_END_RR);
 				continue;
 			}
+			if (rde_update_mrai_hold(peer, aid, now))
+				continue;
 
 			up_dump_update(ibuf_se, peer, aid);
 			sent++;
+
+			/*
+			 * Once the queue is drained start the interval,
+			 * changes until then are collapsed in the queue.
+			 */
+			if (peer->conf.mrai != 0 &&
+			    TAILQ_EMPTY(&peer->updates[aid]))
+				peer->mrai_next[aid] = monotime_add(now,
+				    monotime_from_sec(peer->conf.mrai));
 		}
 		max -= sent;
 	} while (sent != 0 && max > 0);
@@ -3900,9 +4274,12 @@ rde_reload_done(void)
 	struct rde_prefixset_head originsets_old;
 	struct as_set_head	 as_sets_old;
 	uint16_t		 rid;
-	int			 reload = 0, force_locrib = 0;
+	int			 reload = 0, force_locrib = 0, scoped = 0;
+	int			 role_change = 0;
 
 	softreconfig = 0;
+	reconf_in_filtered = 0;
+	reconf_in_skipped = 0;
 
 	SIMPLEQ_INIT(&prefixsets_old);
 	SIMPLEQ_INIT(&originsets_old);
@@ -3919,6 +4296,7 @@ rde_reload_done(void)
 
 	/* merge the main config */
 	copy_config(conf, nconf);
+	rde_damp_config(&conf->damp);
 
 	/* need to copy the sets and roa table and clear them in nconf */
 	SIMPLEQ_CONCAT(&conf->rde_prefixsets, &nconf->rde_prefixsets);
@@ -3945,7 +4323,8 @@ rde_reload_done(void)
 	rde_mark_prefixsets_dirty(&prefixsets_old, &conf->rde_prefixsets);
 	rde_mark_prefixsets_dirty(&originsets_old, &conf->rde_originsets);
 	as_sets_mark_dirty(&as_sets_old, &conf->as_sets);
-
+	/* pending runtime set updates are covered by the reload */
+	rde_set_update_flush();
 
 	/* make sure that rde_eval_all is correctly set after a config change */
 	rde_eval_all = 0;
@@ -4028,9 +4407,13 @@ rde_reload_done(void)
 				log_debug("peer role change: "
 				    "reloading Adj-RIB-In");
 			peer->role = peer->conf.role;
+			role_change = 1;
 			reload++;
 		}
 		peer->export_type = peer->conf.export_type;
+		if ((peer->flags & PEERFLAG_DAMPENING) &&
+		    (peer->conf.flags & PEERFLAG_DAMPENING) == 0)
+			rde_damp_peer_flush(peer, 1);
 		peer->flags = peer->conf.flags;
 		if (peer->flags & PEERFLAG_EVALUATE_ALL)
 			rde_eval_all = 1;
@@ -4108,8 +4491,25 @@ rde_reload_done(void)
 			    rde_filter_equal(rib->in_rules, rib->in_rules_tmp))
 				/* rib is in sync */
 				break;
-			log_debug("filter change: reloading RIB %s",
-			    rib->name);
+			/*
+			 * Try to limit the reload to the affected paths.
+			 * A role change alters the ASPA state of all paths
+			 * of that peer, so any rule may match differently.
+			 */
+			if (!(force_locrib && rid == RIB_LOC_START) &&
+			    !role_change)
+				rib->in_scope = rde_filter_scope(rib->in_rules,
+				    rib->in_rules_tmp);
+			if (rib->in_scope != NULL) {
+				log_info("filter change: reloading RIB %s, "
+				    "%zu rules changed", rib->name,
+				    rib->in_scope->nchanges);
+				/* old rules are now owned by the scope */
+				rib->in_rules_tmp = NULL;
+				scoped = 1;
+			} else
+				log_debug("filter change: reloading RIB %s",
+				    rib->name);
 			rib->state = RECONF_RELOAD;
 			reload++;
 			break;
@@ -4126,6 +4526,9 @@ rde_reload_done(void)
 	}
 
 	/* old filters removed, free all sets */
+	if (scoped)
+		/* the old prefix-sets are needed by the scoped reload */
+		SIMPLEQ_CONCAT(&prefixsets_reload, &prefixsets_old);
 	free_rde_prefixsets(&prefixsets_old);
 	free_rde_prefixsets(&originsets_old);
 	as_sets_free(&as_sets_old);
@@ -4147,13 +4550,11 @@ rde_reload_done(void)
 static void
 rde_softreconfig_in(struct rib_entry *re, void *bula)
 {
-	struct filterstate	 state;
 	struct rib		*rib;
 	struct prefix		*p;
 	struct pt_entry		*pt;
 	struct rde_peer		*peer;
 	struct rde_aspath	*asp;
-	enum filter_action	 action;
 	struct bgpd_addr	 prefix;
 	uint16_t		 i;
 	uint8_t			 aspa_vstate;
@@ -4183,31 +4584,79 @@ rde_softreconfig_in(struct rib_entry *re, void *bula)
 			if (rib->state != RECONF_RELOAD)
 				continue;
 
-			rde_filterstate_prep(&state, p);
-			action = rde_filter(rib->in_rules, peer, peer, &prefix,
-			    pt->prefixlen, &state);
-
-			if (action == ACTION_ALLOW) {
-				/* update Local-RIB */
-				prefix_update(rib, peer, p->path_id,
-				    p->path_id_tx, &state, 0,
-				    &prefix, pt->prefixlen);
-			} else if (conf->filtered_in_locrib &&
-			    i == RIB_LOC_START) {
-				prefix_update(rib, peer, p->path_id,
-				    p->path_id_tx, &state, 1,
-				    &prefix, pt->prefixlen);
-			} else {
-				/* remove from Local-RIB */
-				prefix_withdraw(rib, peer, p->path_id, &prefix,
-				    pt->prefixlen);
+			if (rib->in_scope != NULL &&
+			    !rde_filter_scope_match(rib->in_scope, peer,
+			    &prefix, pt->prefixlen)) {
+				reconf_in_skipped++;
+				rdemem.rde_reconf_in_skipped++;
+				continue;
 			}
+			reconf_in_filtered++;
+			rdemem.rde_reconf_in_filtered++;
 
-			rde_filterstate_clean(&state);
+			rde_softreconfig_in_path(rib, p, &prefix,
+			    pt->prefixlen);
 		}
 	}
 }
 
+/*
+ * A dampened path can be used again, run it through the input filters
+ * of all Loc-RIBs.
+ */
+void
+rde_update_reuse(struct rde_peer *peer, uint32_t path_id, struct pt_entry *pt)
+{
+	struct bgpd_addr	 prefix;
+	struct prefix		*p;
+	uint16_t		 i;
+
+	pt_getaddr(pt, &prefix);
+	p = prefix_get(rib_byid(RIB_ADJ_IN), peer, path_id, &prefix,
+	    pt->prefixlen);
+	if (p == NULL)
+		return;
+
+	for (i = RIB_LOC_START; i < rib_size; i++) {
+		struct rib *rib = rib_byid(i);
+		if (rib == NULL)
+			continue;
+		rde_softreconfig_in_path(rib, p, &prefix, pt->prefixlen);
+	}
+}
+
+/* Run the input filter of rib on path p and update the Loc-RIB. */
+static void
+rde_softreconfig_in_path(struct rib *rib, struct prefix *p,
+    struct bgpd_addr *prefix, uint8_t plen)
+{
+	struct filterstate	 state;
+	struct rde_peer		*peer = prefix_peer(p);
+	enum filter_action	 action;
+
+	if (rde_damp_suppressed(peer, p->path_id, p->pt)) {
+		prefix_withdraw(rib, peer, p->path_id, prefix, plen);
+		return;
+	}
+
+	rde_filterstate_prep(&state, p);
+	action = rde_filter(rib->in_rules, peer, peer, prefix, plen, &state);
+
+	if (action == ACTION_ALLOW) {
+		/* update Local-RIB */
+		prefix_update(rib, peer, p->path_id, p->path_id_tx, &state, 0,
+		    prefix, plen);
+	} else if (conf->filtered_in_locrib && rib->id == RIB_LOC_START) {
+		prefix_update(rib, peer, p->path_id, p->path_id_tx, &state, 1,
+		    prefix, plen);
+	} else {
+		/* remove from Local-RIB */
+		prefix_withdraw(rib, peer, p->path_id, prefix, plen);
+	}
+
+	rde_filterstate_clean(&state);
+}
+
 static void
 rde_softreconfig_in_done(void *arg, uint8_t dummy)
 {
@@ -4220,7 +4669,8 @@ rde_softreconfig_in_done(void *arg, uint8_t dummy)
 		return;
 
 	if (arg == NULL)
-		log_info("softreconfig in done");
+		log_info("softreconfig in done, %lld paths filtered, "
+		    "%lld skipped", reconf_in_filtered, reconf_in_skipped);
 
 	/* now do the Adj-RIB-Out sync and a possible FIB sync */
 	softreconfig = 0;
@@ -4229,6 +4679,8 @@ rde_softreconfig_in_done(void *arg, uint8_t dummy)
 		if (rib == NULL)
 			continue;
 		rib->state = RECONF_NONE;
+		rde_filter_scope_free(rib->in_scope);
+		rib->in_scope = NULL;
 		if (rib->fibstate == RECONF_RELOAD) {
 			if (rib_dump_new(i, AID_UNSPEC, RDE_RUNNER_ROUNDS,
 			    rib, rde_softreconfig_sync_fib,
@@ -4248,6 +4700,8 @@ rde_softreconfig_in_done(void *arg, uint8_t dummy)
 		}
 	}
 
+	free_rde_prefixsets(&prefixsets_reload);
+
 	RB_FOREACH(peer, peer_tree, &peertable) {
 		u_int aid;
 
@@ -4399,6 +4853,304 @@ rde_softreconfig_sync_done(void *arg, uint8_t aid)
 		rde_softreconfig_done();
 }
 
+/*
+ * Runtime prefix-set and as-set updates. The set is modified in place and
+ * only paths that may be affected by the change are re-evaluated: paths
+ * of peers selected by a filter rule using the set and, for prefix-sets,
+ * only prefixes covered by the changed entry. The change is lost on the
+ * next config reload.
+ */
+static void
+rde_set_update(struct ctl_set_update *su, int add, pid_t pid)
+{
+	struct rde_set_update	*job;
+	struct rde_prefixset	*ps;
+	struct as_set		*aset;
+	struct rde_peer		*peer;
+	struct rib		*rib;
+	void			*set;
+	u_int			 error = CTL_RES_OK;
+	uint16_t		 i;
+	int			 r;
+
+	su->name[sizeof(su->name) - 1] = '\0';
+
+	/* a running reload would overwrite the change */
+	if (nconf != NULL || softreconfig != 0) {
+		error = CTL_RES_PENDING;
+		goto done;
+	}
+
+	switch (su->type) {
+	case PREFIX_SET:
+		if ((su->prefix.aid != AID_INET || su->max > 32) &&
+		    (su->prefix.aid != AID_INET6 || su->max > 128)) {
+			error = CTL_RES_PARSE_ERROR;
+			goto done;
+		}
+		ps = rde_find_prefixset(su->name, &conf->rde_prefixsets);
+		if (ps == NULL) {
+			error = CTL_RES_NOSUCHSET;
+			goto done;
+		}
+		if (add)
+			r = trie_add(&ps->th, &su->prefix, su->prefixlen,
+			    su->min, su->max);
+		else
+			r = trie_del(&ps->th, &su->prefix, su->prefixlen,
+			    su->min, su->max);
+		if (r == -1) {
+			error = CTL_RES_PARSE_ERROR;
+			goto done;
+		}
+		if (r == 1)
+			/* nothing changed */
+			goto done;
+		ps->lastchange = getmonotime();
+		set = ps;
+		break;
+	case ASNUM_SET:
+		if ((aset = as_sets_lookup(&conf->as_sets, su->name)) == NULL) {
+			error = CTL_RES_NOSUCHSET;
+			goto done;
+		}
+		if (add)
+			r = set_insert(aset->set, &su->as);
+		else
+			r = set_delete(aset->set, su->as);
+		if (r == -1) {
+			error = CTL_RES_NOMEM;
+			goto done;
+		}
+		if (r == 1)
+			/* nothing changed */
+			goto done;
+		aset->lastchange = getmonotime();
+		set = aset;
+		break;
+	default:
+		error = CTL_RES_PARSE_ERROR;
+		goto done;
+	}
+
+	if ((job = calloc(1, sizeof(*job))) == NULL)
+		fatal(NULL);
+	if ((job->scopes = calloc(rib_size, sizeof(*job->scopes))) == NULL)
+		fatal(NULL);
+	job->nscopes = rib_size;
+	job->set = set;
+	job->type = su->type;
+	strlcpy(job->name, su->name, sizeof(job->name));
+	if (su->type == PREFIX_SET) {
+		applymask(&job->prefix, &su->prefix, su->prefixlen);
+		job->prefixlen = su->prefixlen;
+	}
+
+	for (i = RIB_LOC_START; i < rib_size; i++) {
+		if ((rib = rib_byid(i)) == NULL)
+			continue;
+		job->scopes[i] = rde_filter_set_scope(rib->in_rules, set);
+		if (job->scopes[i] != NULL)
+			job->in = 1;
+	}
+	RB_FOREACH(peer, peer_tree, &peertable)
+		if (rde_filter_uses_set(peer->out_rules, set))
+			job->out = 1;
+
+	log_info("%s %s changed by bgpctl", su->type == PREFIX_SET ?
+	    "prefix-set" : "as-set", su->name);
+
+	TAILQ_INSERT_TAIL(&rde_set_updates, job, entry);
+	if (TAILQ_FIRST(&rde_set_updates) == job)
+		rde_set_update_start(job);
+
+ done:
+	imsg_compose(ibuf_se_ctl, IMSG_CTL_RESULT, 0, pid, -1, &error,
+	    sizeof(error));
+}
+
+static int
+rde_set_update_dump(struct rde_set_update *job, uint16_t rid,
+    void (*upcall)(struct rib_entry *, void *), void (*done)(void *, uint8_t))
+{
+	if (job->prefix.aid != AID_UNSPEC)
+		return rib_dump_subtree(rid, &job->prefix, job->prefixlen,
+		    RDE_RUNNER_ROUNDS, job, upcall, done, NULL);
+	return rib_dump_new(rid, AID_UNSPEC, RDE_RUNNER_ROUNDS, job, upcall,
+	    done, NULL);
+}
+
+static void
+rde_set_update_start(struct rde_set_update *job)
+{
+	if (!job->in) {
+		rde_set_update_in_done(job, AID_UNSPEC);
+		return;
+	}
+	if (rde_set_update_dump(job, RIB_ADJ_IN, rde_set_update_in,
+	    rde_set_update_in_done) == -1)
+		fatal("%s: rib_dump_new", __func__);
+}
+
+static void
+rde_set_update_in(struct rib_entry *re, void *arg)
+{
+	struct rde_set_update	*job = arg;
+	struct rib		*rib;
+	struct prefix		*p;
+	struct pt_entry		*pt;
+	struct rde_peer		*peer;
+	struct bgpd_addr	 prefix;
+	uint16_t		 i;
+
+	pt = re->prefix;
+	pt_getaddr(pt, &prefix);
+	TAILQ_FOREACH(p, &re->prefix_h, rib_l) {
+		/* skip announced networks, they are never filtered */
+		if (prefix_aspath(p)->flags & F_PREFIX_ANNOUNCED)
+			continue;
+
+		peer = prefix_peer(p);
+		for (i = RIB_LOC_START; i < job->nscopes; i++) {
+			if (job->scopes[i] == NULL)
+				continue;
+			if (!rde_filter_scope_match(job->scopes[i], peer,
+			    &prefix, pt->prefixlen))
+				continue;
+			if ((rib = rib_byid(i)) == NULL)
+				continue;
+			rde_softreconfig_in_path(rib, p, &prefix,
+			    pt->prefixlen);
+		}
+	}
+}
+
+static void
+rde_set_update_in_done(void *arg, uint8_t dummy)
+{
+	struct rde_set_update	*job = arg;
+	struct rde_peer		*peer;
+	struct rib		*rib;
+	uint16_t		 i;
+	int			 dump;
+	u_int			 aid;
+
+	/* flushed, rde_set_update_flush() frees the job */
+	if (job->aborted)
+		return;
+
+	if (!job->out) {
+		rde_set_update_done(job);
+		return;
+	}
+
+	/* now refresh the Adj-RIB-Out of peers with an out filter using set */
+	RB_FOREACH(peer, peer_tree, &peertable) {
+		if (!rde_filter_uses_set(peer->out_rules, job->set))
+			continue;
+		if (peer->export_type == EXPORT_NONE)
+			continue;
+		if (peer->export_type == EXPORT_DEFAULT_ROUTE) {
+			for (aid = AID_MIN; aid < AID_MAX; aid++) {
+				if (peer->capa.mp[aid])
+					up_generate_default(peer, aid);
+			}
+			continue;
+		}
+		peer->reconf_out = 1;
+	}
+
+	for (i = RIB_LOC_START; i < rib_size; i++) {
+		if ((rib = rib_byid(i)) == NULL)
+			continue;
+		dump = 0;
+		RB_FOREACH(peer, peer_tree, &peertable)
+			if (peer->reconf_out && peer->loc_rib_id == i)
+				dump = 1;
+		if (!dump)
+			continue;
+		if (rde_set_update_dump(job, i, rde_softreconfig_out,
+		    rde_set_update_out_done) == -1)
+			fatal("%s: rib_dump_new", __func__);
+		job->pending++;
+	}
+
+	if (job->pending == 0)
+		rde_set_update_done(job);
+}
+
+static void
+rde_set_update_out_done(void *arg, uint8_t dummy)
+{
+	struct rde_set_update	*job = arg;
+
+	if (job->aborted)
+		return;
+	if (--job->pending == 0)
+		rde_set_update_done(job);
+}
+
+static void
+rde_set_update_free(struct rde_set_update *job)
+{
+	uint16_t	i;
+
+	for (i = 0; i < job->nscopes; i++)
+		rde_filter_scope_free(job->scopes[i]);
+	free(job->scopes);
+	free(job);
+}
+
+static void
+rde_set_update_done(struct rde_set_update *job)
+{
+	struct rde_peer	*peer;
+
+	if (job->out)
+		RB_FOREACH(peer, peer_tree, &peertable)
+			peer->reconf_out = 0;
+
+	log_info("%s %s re-evaluation done", job->type == PREFIX_SET ?
+	    "prefix-set" : "as-set", job->name);
+
+	TAILQ_REMOVE(&rde_set_updates, job, entry);
+	rde_set_update_free(job);
+
+	if ((job = TAILQ_FIRST(&rde_set_updates)) != NULL)
+		rde_set_update_start(job);
+}
+
+/*
+ * Stop all pending set updates. The sets with pending changes are marked
+ * dirty so that the reload re-evaluates all paths depending on them.
+ */
+static void
+rde_set_update_flush(void)
+{
+	struct rde_set_update	*job;
+	struct rde_prefixset	*ps;
+	struct as_set		*aset;
+
+	while ((job = TAILQ_FIRST(&rde_set_updates)) != NULL) {
+		TAILQ_REMOVE(&rde_set_updates, job, entry);
+		/* the dump done callbacks must not touch the job */
+		job->aborted = 1;
+		rib_dump_terminate(job);
+
+		if (job->type == PREFIX_SET) {
+			ps = rde_find_prefixset(job->name,
+			    &conf->rde_prefixsets);
+			if (ps != NULL)
+				ps->dirty = 1;
+		} else {
+			aset = as_sets_lookup(&conf->as_sets, job->name);
+			if (aset != NULL)
+				aset->dirty = 1;
+		}
+		rde_set_update_free(job);
+	}
+}
+
 /*
  * ROA specific functions. The roa set is updated independent of the config
  * so this runs outside of the softreconfig handlers.
@@ -4447,6 +5199,9 @@ rde_rpki_softreload(struct rib_entry *re, void *bula)
 		/* skip announced networks, they are never filtered */
 		if (asp->flags & F_PREFIX_ANNOUNCED)
 			continue;
+		/* dampened paths are not in the Loc-RIBs */
+		if (rde_damp_suppressed(peer, p->path_id, pt))
+			continue;
 
 		for (i = RIB_LOC_START; i < rib_size; i++) {
 			rib = rib_byid(i);
@@ -4996,6 +5751,9 @@ rde_shutdown(void)
 	 * rde_shutdown depends on this.
 	 */
 
+	/* stop runtime set updates, they reference the config */
+	rde_set_update_flush();
+
 	/* First all peers go down */
 	peer_shutdown();
 
@@ -62,6 +62,7 @@ struct rib {
 	char			name[PEER_DESCR_LEN];
 	struct filter_head	*in_rules;
 	struct filter_head	*in_rules_tmp;
+	struct rde_filter_scope	*in_scope;
 	u_int			rtableid;
 	u_int			rtableid_tmp;
 	enum reconf_action	state, fibstate;
@@ -84,8 +85,21 @@ CH_HEAD(pend_prefix_hash, pend_prefix);
 TAILQ_HEAD(pend_prefix_queue, pend_prefix);
 CH_HEAD(pend_attr_hash, pend_prefix);
 TAILQ_HEAD(pend_attr_queue, pend_attr);
+CH_HEAD(rde_damp_hash, rde_damp);
+CH_HEAD(attr_blob_hash, attr_blob);
+TAILQ_HEAD(attr_blob_queue, attr_blob);
 struct rde_filter;
 
+/*
+ * UPDATE latency sample waiting for the rib entries it queued to be
+ * turned into adj-rib-out updates. Done once rib_pq_done reaches mark.
+ */
+#define RDE_LAT_MARKS	16
+struct rde_lat_mark {
+	monotime_t			 start;
+	unsigned long long		 mark;
+};
+
 struct rde_peer {
 	RB_ENTRY(rde_peer)		 entry;
 	struct peer_config		 conf;
@@ -99,13 +113,20 @@ struct rde_peer {
 	struct pend_prefix_queue	 withdraws[AID_MAX];
 	struct pend_attr_hash		 pend_attrs;
 	struct pend_prefix_hash		 pend_prefixes;
+	struct rde_damp_hash		 damp;
+	struct attr_blob_hash		 attrcache;
+	struct attr_blob_queue		 attrcache_lru;
 	struct rde_filter		*out_rules;
 	struct ibufqueue		*ibufq;
 	struct rib_queue		 rib_pq_head;
+	struct rde_lat_mark		 lat_marks[RDE_LAT_MARKS];
 	monotime_t			 staletime[AID_MAX];
+	monotime_t			 mrai_next[AID_MAX];
+	unsigned long long		 rib_pq_done;
 	uint32_t			 adjout_bid;
 	uint32_t			 remote_bgpid;
 	uint32_t			 path_id_tx;
+	uint32_t			 attrcache_cnt;
 	unsigned int			 local_if_scope;
 	enum peer_state			 state;
 	enum export_type		 export_type;
@@ -119,6 +140,8 @@ struct rde_peer {
 	uint8_t				 reconf_rib;	/* rib changed */
 	uint8_t				 throttled;
 	uint8_t				 flags;
+	uint8_t				 lat_first;
+	uint8_t				 lat_cnt;
 };
 
 struct rde_aspa;
@@ -184,6 +207,35 @@ struct attr {
 	uint8_t				 type;
 };
 
+/*
+ * Optional attributes of an UPDATE are collected in an attr_batch while
+ * parsing and interned together with attr_batch_commit().
+ * The data still points into the UPDATE message.
+ * Attributes the RDE does not look at are not interned one by one but
+ * packed into a single ATTR_OPAQUE attribute. They are only decoded with
+ * attr_opaque_next() when they need to be shown or sent out.
+ */
+#define ATTR_BATCH_MAX	16
+#define ATTR_OPAQUE	ATTR_UNDEF	/* type 0 is never stored otherwise */
+
+struct attr_batch {
+	struct {
+		const void		*data;
+		uint64_t		 hash;
+		uint16_t		 len;
+		uint8_t			 flags;
+		uint8_t			 type;
+	}				 ent[ATTR_BATCH_MAX];
+	size_t				 n;
+	struct {
+		const void		*data;
+		uint16_t		 len;
+		uint8_t			 flags;
+	}				 opq[256];
+	uint64_t			 opqmap[4];
+	size_t				 opqlen;
+};
+
 struct rde_community {
 	uint64_t			 hash;
 	int				 size;
@@ -327,11 +379,30 @@ struct pq_entry {
 	uint32_t		 path_id_tx;
 };
 
+/*
+ * Wire encoding of the path attributes of an adjout_attr. The encoding
+ * only depends on a few properties of the peer, the encoding class.
+ */
+#define ADJOUT_ENC_AS4BYTE	0x01
+#define ADJOUT_ENC_EBGP		0x02
+#define ADJOUT_ENC_TRANS_AS	0x04
+#define ADJOUT_ENC_INET		0x08
+#define ADJOUT_ENC_EXT_NH	0x10
+#define ADJOUT_ENC_MAX		4	/* max cached classes per adjout_attr */
+
+struct adjout_attr_enc {
+	struct adjout_attr_enc	*next;
+	uint16_t		 len;
+	uint8_t			 class;
+	u_char			 data[];
+};
+
 struct adjout_attr {
 	uint64_t		 hash;
 	struct rde_aspath	*aspath;
 	struct rde_community	*communities;
 	struct nexthop		*nexthop;
+	struct adjout_attr_enc	*enc;
 	int			 refcnt;
 };
 
@@ -363,6 +434,20 @@ struct filterstate {
 	uint8_t			 vstate;
 };
 
+/* filter rules changed by a config reload, see rde_filter_scope() */
+struct rde_filter_change {
+	struct filter_rule	*new;
+	struct filter_rule	*old;
+	int			 psonly;	/* only the prefix-set changed */
+};
+
+struct rde_filter_scope {
+	struct filter_head		*old_rules;
+	struct rde_filter_change	*changes;
+	size_t				 nchanges;
+	size_t				 size;
+};
+
 enum eval_mode {
 	EVAL_NONE,
 	EVAL_SYNC,
@@ -390,6 +475,35 @@ struct rib_context {
 
 extern struct rde_memstats rdemem;
 
+/*
+ * The decision process and the filters run once per prefix. Only every
+ * RDE_LAT_SAMPLE call is timed to keep the clock reads off the hot path.
+ */
+#define RDE_LAT_SAMPLE	64
+
+/*
+ * Static tracepoints in the hot paths of the RDE. If the system provides
+ * USDT probes via <sys/sdt.h> they are compiled in, else they are no-ops.
+ */
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define HAVE_SYS_SDT_H
+#endif
+#endif
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define RDE_TRACE(name, arg)	DTRACE_PROBE1(bgpd, name, arg)
+#else
+#define RDE_TRACE(name, arg)	do { } while (0)
+#endif
+
+static inline void
+rde_latency_add(enum rde_latency type, monotime_t start)
+{
+	latency_add(&rdemem.rde_latency[type], start);
+}
+
 /* prototypes */
 /* mrt.c */
 int		mrt_dump_v2_hdr(struct mrt *, struct bgpd_config *);
@@ -412,6 +526,7 @@ uint32_t	rde_local_as(void);
 int		rde_decisionflags(void);
 void		rde_peer_send_rrefresh(struct rde_peer *, uint8_t, uint8_t);
 int		rde_match_peer(struct rde_peer *, struct ctl_neighbor *);
+void		rde_update_reuse(struct rde_peer *, uint32_t, struct pt_entry *);
 
 /* rde_peer.c */
 int		 peer_has_as4byte(struct rde_peer *);
@@ -431,6 +546,7 @@ struct rde_filter	*peer_apply_out_filter(struct rde_peer *,
 void		 rde_enqueue_updates(struct rib_entry *, struct rde_peer *,
 		    struct prefix *, uint32_t, enum eval_mode);
 void		 peer_process_updates(struct rde_peer *, void *);
+void		 peer_latency_mark(struct rde_peer *, monotime_t);
 
 void		 peer_up(struct rde_peer *, struct session_up *);
 void		 peer_down(struct rde_peer *);
@@ -461,6 +577,13 @@ void		 attr_init(void);
 int		 attr_optadd(struct rde_aspath *, uint8_t, uint8_t,
 		    const void *, uint16_t);
 struct attr	*attr_optget(const struct rde_aspath *, uint8_t);
+void		 attr_batch_init(struct attr_batch *);
+int		 attr_batch_add(struct rde_aspath *, struct attr_batch *,
+		    uint8_t, uint8_t, const void *, uint16_t);
+int		 attr_batch_opaque(struct attr_batch *, uint8_t, uint8_t,
+		    const void *, uint16_t);
+void		 attr_batch_commit(struct rde_aspath *, struct attr_batch *);
+int		 attr_opaque_next(const struct attr *, size_t *, struct attr *);
 void		 attr_copy(struct rde_aspath *, const struct rde_aspath *);
 int		 attr_equal(const struct rde_aspath *,
 		    const struct rde_aspath *);
@@ -469,6 +592,16 @@ void		 attr_free(struct rde_aspath *, struct attr *);
 
 void		 attr_stats(struct ch_stats *);
 
+/* rde_attrcache.c */
+void		 attrcache_init(void);
+void		 attrcache_peer_init(struct rde_peer *);
+void		 attrcache_peer_flush(struct rde_peer *);
+int		 attrcache_lookup(struct rde_peer *, struct ibuf *,
+		    struct filterstate *, struct ibuf *, struct ibuf *,
+		    uint64_t *);
+void		 attrcache_insert(struct rde_peer *, struct ibuf *, uint64_t,
+		    struct filterstate *);
+
 struct aspath	*aspath_get(const void *, uint16_t);
 struct aspath	*aspath_copy(struct aspath *);
 void		 aspath_put(struct aspath *);
@@ -548,6 +681,17 @@ communities_unref(struct rde_community *comm)
 
 int	community_to_rd(struct community *, uint64_t *);
 
+/* rde_damp.c */
+void	 rde_damp_init(void);
+void	 rde_damp_config(const struct dampening_config *);
+void	 rde_damp_peer_init(struct rde_peer *);
+void	 rde_damp_peer_flush(struct rde_peer *, int);
+int	 rde_damp_withdraw(struct rde_peer *, uint32_t, struct pt_entry *);
+int	 rde_damp_update(struct rde_peer *, uint32_t, struct pt_entry *, int);
+int	 rde_damp_suppressed(struct rde_peer *, uint32_t, struct pt_entry *);
+int	 rde_damp_timeout(void);
+void	 rde_damp_run(void);
+
 /* rde_decide.c */
 int		 prefix_eligible(struct prefix *);
 struct prefix	*prefix_best(struct rib_entry *);
@@ -573,6 +717,14 @@ void	rde_filterstate_clean(struct filterstate *);
 uint64_t	rde_filterset_calc_hash(const struct rde_filter_set *);
 int	rde_filter_skip_rule(struct rde_peer *, struct filter_rule *);
 int	rde_filter_equal(struct filter_head *, struct filter_head *);
+struct rde_filter_scope	*rde_filter_scope(struct filter_head *,
+	    struct filter_head *);
+int	rde_filter_scope_match(struct rde_filter_scope *, struct rde_peer *,
+	    struct bgpd_addr *, uint8_t);
+void	rde_filter_scope_free(struct rde_filter_scope *);
+struct rde_filter_scope	*rde_filter_set_scope(struct filter_head *,
+	    const void *);
+int	rde_filter_uses_set(const struct rde_filter *, const void *);
 struct rde_filter_set	*rde_filterset_imsg_recv(struct imsg *);
 void	rde_filter_calc_skip_steps(struct filter_head *);
 enum filter_action rde_filter(struct filter_head *, struct rde_peer *,
@@ -634,7 +786,7 @@ struct rib_entry *rib_get(struct rib *, struct pt_entry *);
 struct rib_entry *rib_get_addr(struct rib *, struct bgpd_addr *, int);
 struct rib_entry *rib_match(struct rib *, struct bgpd_addr *);
 int		 rib_dump_pending(void);
-void		 rib_dump_runner(void);
+void		 rib_dump_runner(long long);
 void		 rib_dump_insert(struct rib_context *);
 int		 rib_dump_new(uint16_t, uint8_t, unsigned int, void *,
 		    void (*)(struct rib_entry *, void *),
@@ -763,7 +915,7 @@ prefix_filtered(struct prefix *p)
 
 void		 nexthop_shutdown(void);
 int		 nexthop_pending(void);
-void		 nexthop_runner(void);
+void		 nexthop_runner(unsigned int);
 void		 nexthop_modify(struct nexthop *, enum action_types, uint8_t,
 		    struct nexthop **, uint8_t *);
 void		 nexthop_link(struct prefix *);
@@ -810,6 +962,10 @@ void		 pend_prefix_add(struct rde_peer *, struct adjout_attr *,
 void		 pend_prefix_free(struct pend_prefix *,
 		    struct pend_prefix_queue *, struct rde_peer *);
 
+struct adjout_attr_enc	*adjout_attr_enc_get(struct adjout_attr *, uint8_t);
+void		 adjout_attr_enc_add(struct adjout_attr *, uint8_t,
+		    const void *, size_t);
+
 void		 pend_attr_stats(struct ch_stats *);
 void		 pend_prefix_stats(struct ch_stats *);
 void		 adjout_attr_stats(struct ch_stats *);
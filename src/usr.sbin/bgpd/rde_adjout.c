@@ -333,8 +333,17 @@ adjout_attr_alloc(struct rde_aspath *asp, struct rde_community *comm,
 static void
 adjout_attr_free(struct adjout_attr *a)
 {
+	struct adjout_attr_enc *enc;
+
 	CH_REMOVE(adjout_attr_tree, &attrtable, a);
 
+	while ((enc = a->enc) != NULL) {
+		a->enc = enc->next;
+		rdemem.adjout_attr_enc_cnt--;
+		rdemem.adjout_attr_enc_size -= sizeof(*enc) + enc->len;
+		free(enc);
+	}
+
 	/* destroy all references to other objects */
 	/* remove nexthop ref ... */
 	nexthop_unref(a->nexthop);
@@ -397,6 +406,50 @@ adjout_attr_get(struct filterstate *state)
 	return attr;
 }
 
+/*
+ * Return the cached wire encoding of the path attributes for class or
+ * NULL if there is none.
+ */
+struct adjout_attr_enc *
+adjout_attr_enc_get(struct adjout_attr *attrs, uint8_t class)
+{
+	struct adjout_attr_enc *enc;
+
+	for (enc = attrs->enc; enc != NULL; enc = enc->next)
+		if (enc->class == class)
+			return enc;
+	return NULL;
+}
+
+/*
+ * Cache the wire encoding of the path attributes for class. Only the
+ * first ADJOUT_ENC_MAX classes are cached, in most setups all peers
+ * fall into one or two classes.
+ */
+void
+adjout_attr_enc_add(struct adjout_attr *attrs, uint8_t class,
+    const void *data, size_t len)
+{
+	struct adjout_attr_enc *enc;
+	int n = 0;
+
+	for (enc = attrs->enc; enc != NULL; enc = enc->next)
+		if (++n >= ADJOUT_ENC_MAX)
+			return;
+	if (len > UINT16_MAX)
+		return;
+
+	if ((enc = malloc(sizeof(*enc) + len)) == NULL)
+		fatal(__func__);
+	rdemem.adjout_attr_enc_cnt++;
+	rdemem.adjout_attr_enc_size += sizeof(*enc) + len;
+	enc->class = class;
+	enc->len = len;
+	memcpy(enc->data, data, len);
+	enc->next = attrs->enc;
+	attrs->enc = enc;
+}
+
 void
 adjout_attr_stats(struct ch_stats *stats)
 {
@@ -424,6 +477,28 @@ adjout_prefix_index(struct pt_entry *pte, struct adjout_prefix *p)
 	return idx;
 }
 
+/*
+ * Return the index of the first entry in the pte adjout array with a
+ * path_id_tx greater or equal (upper == 0) or greater than (upper == 1)
+ * path_id_tx. With add-path send all the array holds an entry per path
+ * so do a binary search instead of walking it.
+ */
+static inline uint32_t
+adjout_prefix_bound(struct pt_entry *pte, uint32_t path_id_tx, int upper)
+{
+	uint32_t lo = 0, hi = pte->adjoutlen, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pte->adjout[mid].path_id_tx < path_id_tx ||
+		    (upper && pte->adjout[mid].path_id_tx == path_id_tx))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 /*
  * Search for specified prefix in the pte adjout array that is for the
  * specified path_id_tx and peer. Returns NULL if not found.
@@ -435,10 +510,9 @@ adjout_prefix_get(struct rde_peer *peer, uint32_t path_id_tx,
 	struct adjout_prefix *p;
 	uint32_t i;
 
-	for (i = 0; i < pte->adjoutlen; i++) {
+	for (i = adjout_prefix_bound(pte, path_id_tx, 0);
+	    i < pte->adjoutlen; i++) {
 		p = &pte->adjout[i];
-		if (p->path_id_tx < path_id_tx)
-			continue;
 		if (p->path_id_tx > path_id_tx)
 			break;
 		if (bitmap_test(&p->peermap, peer->adjout_bid))
@@ -459,10 +533,9 @@ adjout_prefix_with_attrs(struct pt_entry *pte, uint32_t path_id_tx,
 	struct adjout_prefix *p;
 	uint32_t i;
 
-	for (i = 0; i < pte->adjoutlen; i++) {
+	for (i = adjout_prefix_bound(pte, path_id_tx, 0);
+	    i < pte->adjoutlen; i++) {
 		p = &pte->adjout[i];
-		if (p->path_id_tx < path_id_tx)
-			continue;
 		if (p->path_id_tx > path_id_tx)
 			break;
 		if (p->attrs == attrs)
@@ -761,6 +834,36 @@ adjout_prefix_unlink(struct adjout_prefix *p, struct pt_entry *pte,
 	}
 }
 
+/*
+ * Shrink the pte adjout array after many paths got removed. Add-path send
+ * all can grow the array to many entries and it would stay that way.
+ */
+static void
+adjout_prefix_shrink(struct pt_entry *pte)
+{
+	struct adjout_prefix *new;
+	uint32_t newlen, avail;
+
+	avail = pte->adjoutavail;
+	if (pte->adjoutlen == 0) {
+		free(pte->adjout);
+		pte->adjout = NULL;
+		pte->adjoutavail = 0;
+		rdemem.adjout_prefix_size -= sizeof(*new) * avail;
+		return;
+	}
+
+	newlen = bin_of_adjout_prefixes(pte->adjoutlen);
+	if (newlen >= avail)
+		return;
+	if ((new = reallocarray(pte->adjout, newlen, sizeof(*new))) == NULL)
+		fatal(__func__);
+	rdemem.adjout_prefix_size -= sizeof(*new) * (avail - newlen);
+
+	pte->adjout = new;
+	pte->adjoutavail = newlen;
+}
+
 /* remove all tombstone entries from the pte adjout array */
 void
 adjout_prefix_collect(struct pt_entry *pte)
@@ -780,12 +883,15 @@ adjout_prefix_collect(struct pt_entry *pte)
 		pte->adjout[i] = pte->adjout[i + j];
 	}
 
-	/* TODO shrink array if X% empty */
 	if (i < pte->adjoutlen)
 		memset(&pte->adjout[i], 0, sizeof(pte->adjout[0]) * j);
 	pte->adjoutlen = i;
 
 	rdemem.adjout_prefix_cnt -= j;
+
+	/* shrink array once less than a quarter is used */
+	if (j > 0 && pte->adjoutlen < pte->adjoutavail / 4)
+		adjout_prefix_shrink(pte);
 }
 
 static void
@@ -819,10 +925,7 @@ adjout_prefix_alloc(struct pt_entry *pte, uint32_t path_id_tx)
 		adjout_prefix_resize(pte);
 
 	/* keep array sorted by path_id_tx */
-	for (i = 0; i < pte->adjoutlen; i++) {
-		if (pte->adjout[i].path_id_tx > path_id_tx)
-			break;
-	}
+	i = adjout_prefix_bound(pte, path_id_tx, 1);
 
 	p = &pte->adjout[i];
 	/* shift reminder by one slot */
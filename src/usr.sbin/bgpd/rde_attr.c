@@ -61,6 +61,7 @@ static struct attr *attr_alloc(uint8_t, uint8_t, const void *, uint16_t,
     uint64_t);
 static struct attr *attr_lookup(uint8_t, uint8_t, const void *, uint16_t,
     uint64_t);
+static void attr_link(struct rde_aspath *, struct attr *);
 static void attr_put(struct attr *);
 
 static SIPHASH_KEY	 attrkey;
@@ -98,8 +99,7 @@ attr_optadd(struct rde_aspath *asp, uint8_t flags, uint8_t type,
     const void *data, uint16_t len)
 {
 	unsigned int	 l;
-	struct attr	*a, *t;
-	struct attr	**p;
+	struct attr	*a;
 	uint64_t	 h;
 
 	/* attribute allowed only once */
@@ -117,6 +117,20 @@ attr_optadd(struct rde_aspath *asp, uint8_t flags, uint8_t type,
 	if ((a = attr_lookup(flags, type, data, len, h)) == NULL)
 		a = attr_alloc(flags, type, data, len, h);
 
+	attr_link(asp, a);
+	return (0);
+}
+
+/*
+ * Add attribute a to the sorted others array of asp and take a reference.
+ */
+static void
+attr_link(struct rde_aspath *asp, struct attr *a)
+{
+	unsigned int	 l;
+	struct attr	*t;
+	struct attr	**p;
+
 	/* add attribute to the table but first bump refcnt */
 	a->refcnt++;
 	rdemem.attr_refs++;
@@ -124,7 +138,7 @@ attr_optadd(struct rde_aspath *asp, uint8_t flags, uint8_t type,
 	for (l = 0; l < asp->others_len; l++) {
 		if (asp->others[l] == NULL) {
 			asp->others[l] = a;
-			return (0);
+			return;
 		}
 		/* list is sorted */
 		if (a->type < asp->others[l]->type) {
@@ -147,8 +161,6 @@ attr_optadd(struct rde_aspath *asp, uint8_t flags, uint8_t type,
 	asp->others = p;
 	asp->others[asp->others_len] = a;
 	asp->others_len = l;
-
-	return (0);
 }
 
 struct attr *
@@ -327,6 +339,175 @@ attr_lookup(uint8_t flags, uint8_t type, const void *data, uint16_t len,
 	return CH_LOCATE(attr_tree, &attrtable, hash, attr_match, &needle);
 }
 
+void
+attr_batch_init(struct attr_batch *b)
+{
+	b->n = 0;
+	memset(b->opqmap, 0, sizeof(b->opqmap));
+	b->opqlen = 0;
+}
+
+static void attr_batch_flush(struct rde_aspath *, struct attr_batch *);
+
+/*
+ * Queue an optional attribute for asp. Like attr_optadd() but the
+ * attribute is only interned by attr_batch_commit(), data needs to stay
+ * valid until then. Returns -1 if the attribute is already present.
+ */
+int
+attr_batch_add(struct rde_aspath *asp, struct attr_batch *b, uint8_t flags,
+    uint8_t type, const void *data, uint16_t len)
+{
+	size_t i;
+
+	/* attribute allowed only once */
+	if (attr_optget(asp, type) != NULL)
+		return (-1);
+	for (i = 0; i < b->n; i++)
+		if (b->ent[i].type == type)
+			return (-1);
+
+	if (b->n == ATTR_BATCH_MAX)
+		attr_batch_flush(asp, b);
+
+	b->ent[b->n].data = data;
+	b->ent[b->n].len = len;
+	b->ent[b->n].flags = flags & ~ATTR_DEFMASK;
+	b->ent[b->n].type = type;
+	b->ent[b->n].hash = attr_calc_hash(type, data, len);
+	b->n++;
+	return (0);
+}
+
+/*
+ * Queue an optional attribute which is not inspected by the RDE. All
+ * of them end up in one ATTR_OPAQUE attribute sorted by type.
+ * Returns -1 if the attribute is already present.
+ */
+int
+attr_batch_opaque(struct attr_batch *b, uint8_t flags, uint8_t type,
+    const void *data, uint16_t len)
+{
+	uint64_t bit = 1ULL << (type % 64);
+
+	/* attribute allowed only once */
+	if (b->opqmap[type / 64] & bit)
+		return (-1);
+	b->opqmap[type / 64] |= bit;
+
+	b->opq[type].data = data;
+	b->opq[type].len = len;
+	b->opq[type].flags = flags & ~ATTR_DEFMASK;
+	b->opqlen += 4 + len;
+	return (0);
+}
+
+/*
+ * Intern all queued attributes with one batched table lookup and add
+ * them to asp.
+ */
+static void
+attr_batch_flush(struct rde_aspath *asp, struct attr_batch *b)
+{
+	struct lookup_attr	 needles[ATTR_BATCH_MAX];
+	const void		*args[ATTR_BATCH_MAX];
+	uint64_t		 hashes[ATTR_BATCH_MAX];
+	struct attr		*res[ATTR_BATCH_MAX], *a;
+	size_t			 i;
+
+	for (i = 0; i < b->n; i++) {
+		needles[i].data = b->ent[i].data;
+		needles[i].len = b->ent[i].len;
+		needles[i].flags = b->ent[i].flags;
+		needles[i].type = b->ent[i].type;
+		args[i] = &needles[i];
+		hashes[i] = b->ent[i].hash;
+	}
+	CH_LOCATE_BATCH(attr_tree, &attrtable, b->n, hashes, attr_match,
+	    args, res);
+
+	for (i = 0; i < b->n; i++) {
+		if ((a = res[i]) == NULL)
+			a = attr_alloc(b->ent[i].flags, b->ent[i].type,
+			    b->ent[i].data, b->ent[i].len, b->ent[i].hash);
+		attr_link(asp, a);
+	}
+	b->n = 0;
+}
+
+/*
+ * Intern all queued attributes and pack the opaque ones. Each packed
+ * attribute is stored as flags, type, 2 byte length and data.
+ */
+void
+attr_batch_commit(struct rde_aspath *asp, struct attr_batch *b)
+{
+	static u_char	 opqbuf[UINT16_MAX];
+	size_t		 off = 0;
+	uint16_t	 len;
+	int		 i, type;
+
+	attr_batch_flush(asp, b);
+	if (b->opqlen == 0)
+		return;
+
+	for (i = 0; i < 4; i++) {
+		if (b->opqmap[i] == 0)
+			continue;
+		for (type = i * 64; type < (i + 1) * 64; type++) {
+			if ((b->opqmap[i] & (1ULL << (type % 64))) == 0)
+				continue;
+			if (b->opqlen > sizeof(opqbuf)) {
+				/* too big to pack, store them one by one */
+				if (attr_optadd(asp, b->opq[type].flags, type,
+				    b->opq[type].data, b->opq[type].len) == -1)
+					fatalx("%s: duplicate attribute",
+					    __func__);
+				continue;
+			}
+			opqbuf[off] = b->opq[type].flags;
+			opqbuf[off + 1] = type;
+			len = htobe16(b->opq[type].len);
+			memcpy(opqbuf + off + 2, &len, sizeof(len));
+			memcpy(opqbuf + off + 4, b->opq[type].data,
+			    b->opq[type].len);
+			off += 4 + b->opq[type].len;
+		}
+	}
+	if (off > 0 && attr_optadd(asp, ATTR_OPTIONAL, ATTR_OPAQUE, opqbuf,
+	    off) == -1)
+		fatalx("%s: duplicate opaque attribute", __func__);
+	memset(b->opqmap, 0, sizeof(b->opqmap));
+	b->opqlen = 0;
+}
+
+/*
+ * Unpack the next attribute of the ATTR_OPAQUE attribute opq into a.
+ * off must be 0 on the first call. Returns 0 once all attributes were
+ * returned. a points into opq and is only valid as long as opq is.
+ */
+int
+attr_opaque_next(const struct attr *opq, size_t *off, struct attr *a)
+{
+	uint16_t	len;
+
+	if (*off + 4 > opq->len)
+		return (0);
+	memcpy(&len, opq->data + *off + 2, sizeof(len));
+	len = be16toh(len);
+	if (*off + 4 + len > opq->len)
+		return (0);
+
+	a->hash = 0;
+	a->refcnt = 0;
+	a->flags = opq->data[*off];
+	a->type = opq->data[*off + 1];
+	a->len = len;
+	a->data = opq->data + *off + 4;
+	*off += 4 + len;
+	return (1);
+}
+
 void
 attr_put(struct attr *a)
 {
@@ -0,0 +1,302 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <siphash.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bgpd.h"
+#include "rde.h"
+
+/*
+ * Per peer cache of parsed path attribute sections.
+ * During a table dump a peer often sends the same path attributes in many
+ * UPDATEs. The wire encoding of the attributes, without MP_REACH_NLRI and
+ * MP_UNREACH_NLRI since those carry the prefixes, is mapped to the
+ * filterstate rde_attr_parse() produced for it. A hit skips parsing,
+ * validation and interning of the attributes.
+ * The parse result depends on the session (4-byte AS, ebgp, ...) so the
+ * cache is flushed whenever the session or the peer config changes.
+ * The key includes AFI and SAFI of the MP attributes so entries are
+ * per address family.
+ */
+
+#define ATTRCACHE_MAX		128	/* entries per peer */
+#define ATTRCACHE_MAXLEN	4096	/* larger sections are not cached */
+
+struct attr_blob {
+	TAILQ_ENTRY(attr_blob)	 entry;
+	struct filterstate	 state;
+	uint64_t		 hash;
+	uint8_t			 mp[8];
+	size_t			 len;
+	u_char			 data[];
+};
+
+struct attr_blob_key {
+	struct ibuf		*attrbuf;
+	uint8_t			 mp[8];
+};
+
+static SIPHASH_KEY	attrcache_key;
+
+static inline uint64_t
+attr_blob_hash(const struct attr_blob *ab)
+{
+	return ab->hash;
+}
+
+static inline int
+attr_blob_eq(const struct attr_blob *a, const struct attr_blob *b)
+{
+	return a->hash == b->hash && a->len == b->len &&
+	    memcmp(a->mp, b->mp, sizeof(a->mp)) == 0 &&
+	    memcmp(a->data, b->data, a->len) == 0;
+}
+
+CH_PROTOTYPE(attr_blob_hash, attr_blob, attr_blob_hash);
+
+/*
+ * Split off the next attribute of buf. tlv covers the full attribute,
+ * data only the attribute value.
+ */
+static int
+attrcache_next(struct ibuf *buf, struct ibuf *tlv, struct ibuf *data,
+    uint8_t *flags, uint8_t *type)
+{
+	size_t		 hlen;
+	uint16_t	 alen16;
+	uint8_t		 alen8;
+
+	ibuf_from_ibuf(data, buf);
+	if (ibuf_get_n8(data, flags) == -1 ||
+	    ibuf_get_n8(data, type) == -1)
+		return (-1);
+	if (*flags & ATTR_EXTLEN) {
+		if (ibuf_get_n16(data, &alen16) == -1)
+			return (-1);
+		hlen = 4;
+	} else {
+		if (ibuf_get_n8(data, &alen8) == -1)
+			return (-1);
+		alen16 = alen8;
+		hlen = 3;
+	}
+	if (ibuf_truncate(data, alen16) == -1)
+		return (-1);
+	ibuf_from_ibuf(tlv, buf);
+	if (ibuf_truncate(tlv, hlen + alen16) == -1 ||
+	    ibuf_skip(buf, hlen + alen16) == -1)
+		return (-1);
+	return (0);
+}
+
+/*
+ * Walk the attribute section, extract the MP attributes into reach and
+ * unreach and feed all other attributes to the hash. Does the same checks
+ * on the MP attributes as rde_attr_parse(). Returns -1 if the attribute
+ * section can't be cached, in that case the normal parser takes over and
+ * reports any error.
+ */
+static int
+attrcache_walk(struct ibuf *attrbuf, struct ibuf *reach, struct ibuf *unreach,
+    uint8_t *mp, uint64_t *hash)
+{
+	SIPHASH_CTX	 ctx;
+	struct ibuf	 buf, tlv, data;
+	uint8_t		 flags, type;
+
+	if (ibuf_size(attrbuf) > ATTRCACHE_MAXLEN)
+		return (-1);
+
+	memset(mp, 0, 8);
+	SipHash24_Init(&ctx, &attrcache_key);
+	ibuf_from_ibuf(&buf, attrbuf);
+	while (ibuf_size(&buf) > 0) {
+		if (attrcache_next(&buf, &tlv, &data, &flags, &type) == -1)
+			return (-1);
+		switch (type) {
+		case ATTR_MP_REACH_NLRI:
+			if ((flags & ~(ATTR_DEFMASK)) != ATTR_OPTIONAL ||
+			    ibuf_size(&data) < 5 || mp[0] != 0)
+				return (-1);
+			mp[0] = 1;
+			memcpy(&mp[1], ibuf_data(&data), 3);
+			*reach = data;
+			break;
+		case ATTR_MP_UNREACH_NLRI:
+			if ((flags & ~(ATTR_DEFMASK)) != ATTR_OPTIONAL ||
+			    ibuf_size(&data) < 3 || mp[4] != 0)
+				return (-1);
+			mp[4] = 1;
+			memcpy(&mp[5], ibuf_data(&data), 3);
+			*unreach = data;
+			break;
+		default:
+			SipHash24_Update(&ctx, ibuf_data(&tlv),
+			    ibuf_size(&tlv));
+			break;
+		}
+	}
+	SipHash24_Update(&ctx, mp, 8);
+	*hash = SipHash24_End(&ctx);
+	return (0);
+}
+
+/* compare the attribute section against the cached blob */
+static int
+attrcache_match(const void *va, const void *vb)
+{
+	const struct attr_blob		*ab = va;
+	const struct attr_blob_key	*key = vb;
+	struct ibuf			 buf, tlv, data;
+	size_t				 off = 0;
+	uint8_t				 flags, type;
+
+	if (memcmp(ab->mp, key->mp, sizeof(ab->mp)) != 0)
+		return 0;
+
+	ibuf_from_ibuf(&buf, key->attrbuf);
+	while (ibuf_size(&buf) > 0) {
+		if (attrcache_next(&buf, &tlv, &data, &flags, &type) == -1)
+			return 0;
+		if (type == ATTR_MP_REACH_NLRI || type == ATTR_MP_UNREACH_NLRI)
+			continue;
+		if (ibuf_size(&tlv) > ab->len - off ||
+		    memcmp(ab->data + off, ibuf_data(&tlv),
+		    ibuf_size(&tlv)) != 0)
+			return 0;
+		off += ibuf_size(&tlv);
+	}
+	return off == ab->len;
+}
+
+void
+attrcache_init(void)
+{
+	arc4random_buf(&attrcache_key, sizeof(attrcache_key));
+}
+
+void
+attrcache_peer_init(struct rde_peer *peer)
+{
+	CH_INIT(attr_blob_hash, &peer->attrcache);
+	TAILQ_INIT(&peer->attrcache_lru);
+	peer->attrcache_cnt = 0;
+}
+
+static void
+attrcache_free(struct rde_peer *peer, struct attr_blob *ab)
+{
+	CH_REMOVE(attr_blob_hash, &peer->attrcache, ab);
+	TAILQ_REMOVE(&peer->attrcache_lru, ab, entry);
+	peer->attrcache_cnt--;
+	rde_filterstate_clean(&ab->state);
+	free(ab);
+}
+
+void
+attrcache_peer_flush(struct rde_peer *peer)
+{
+	struct attr_blob *ab;
+
+	while ((ab = TAILQ_FIRST(&peer->attrcache_lru)) != NULL)
+		attrcache_free(peer, ab);
+	CH_DESTROY(attr_blob_hash, &peer->attrcache);
+}
+
+/*
+ * Look up the attribute section attrbuf in the cache of peer. On a hit
+ * state is set up like rde_attr_parse() would, reach and unreach point to
+ * the MP attributes and 1 is returned. On a miss 0 is returned and hash
+ * is set for attrcache_insert(). If the section is not cacheable -1 is
+ * returned.
+ */
+int
+attrcache_lookup(struct rde_peer *peer, struct ibuf *attrbuf,
+    struct filterstate *state, struct ibuf *reach, struct ibuf *unreach,
+    uint64_t *hash)
+{
+	struct attr_blob_key	 key;
+	struct attr_blob	*ab;
+
+	if (attrcache_walk(attrbuf, reach, unreach, key.mp, hash) == -1)
+		return (-1);
+
+	key.attrbuf = attrbuf;
+	ab = CH_LOCATE(attr_blob_hash, &peer->attrcache, *hash,
+	    attrcache_match, &key);
+	if (ab == NULL)
+		return (0);
+
+	TAILQ_REMOVE(&peer->attrcache_lru, ab, entry);
+	TAILQ_INSERT_HEAD(&peer->attrcache_lru, ab, entry);
+	rde_filterstate_copy(state, &ab->state);
+	return (1);
+}
+
+/*
+ * Add the parse result state of attrbuf to the cache. Must only be called
+ * after a miss in attrcache_lookup() and a successful parse.
+ */
+void
+attrcache_insert(struct rde_peer *peer, struct ibuf *attrbuf, uint64_t hash,
+    struct filterstate *state)
+{
+	struct attr_blob	*ab;
+	struct ibuf		 buf, tlv, data, reach, unreach;
+	uint8_t			 flags, type, mp[8];
+	uint64_t		 h;
+	size_t			 len = 0;
+
+	/* recompute the MP key, len is less or equal ibuf_size(attrbuf) */
+	if (attrcache_walk(attrbuf, &reach, &unreach, mp, &h) == -1 ||
+	    h != hash)
+		return;
+
+	if (peer->attrcache_cnt >= ATTRCACHE_MAX)
+		attrcache_free(peer, TAILQ_LAST(&peer->attrcache_lru,
+		    attr_blob_queue));
+
+	if ((ab = malloc(sizeof(*ab) + ibuf_size(attrbuf))) == NULL)
+		fatal(__func__);
+
+	ibuf_from_ibuf(&buf, attrbuf);
+	while (ibuf_size(&buf) > 0) {
+		if (attrcache_next(&buf, &tlv, &data, &flags, &type) == -1)
+			fatalx("%s: attribute section changed", __func__);
+		if (type == ATTR_MP_REACH_NLRI || type == ATTR_MP_UNREACH_NLRI)
+			continue;
+		memcpy(ab->data + len, ibuf_data(&tlv), ibuf_size(&tlv));
+		len += ibuf_size(&tlv);
+	}
+	ab->len = len;
+	ab->hash = hash;
+	memcpy(ab->mp, mp, sizeof(ab->mp));
+	rde_filterstate_copy(&ab->state, state);
+
+	if (CH_INSERT(attr_blob_hash, &peer->attrcache, ab, NULL) != 1)
+		fatalx("%s: insert failed", __func__);
+	TAILQ_INSERT_HEAD(&peer->attrcache_lru, ab, entry);
+	peer->attrcache_cnt++;
+}
+
+CH_GENERATE(attr_blob_hash, attr_blob, attr_blob_eq, attr_blob_hash);
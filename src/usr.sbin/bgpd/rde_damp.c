@@ -0,0 +1,432 @@
+/*	$OpenBSD$ */
+
+/*
+ * Copyright (c) 2026 The OpenBGPD project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Route flap dampening as described in RFC 2439.
+ *
+ * The penalty state is kept in a per peer hash table keyed by pt_entry
+ * and path_id, so struct prefix does not grow. The penalty is decayed
+ * lazily whenever the entry is touched. Every entry sits on a timer
+ * wheel with the time at which it needs to be looked at again: either
+ * when a suppressed path can be reused or when the penalty dropped low
+ * enough that the entry can be forgotten.
+ */
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bgpd.h"
+#include "rde.h"
+#include "log.h"
+#include "chash.h"
+
+#define DAMP_WHEEL_SLOTS	256
+#define DAMP_WHEEL_TICK		10	/* seconds per slot */
+
+struct rde_damp {
+	LIST_ENTRY(rde_damp)	 wheel;
+	struct pt_entry		*pt;
+	struct rde_peer		*peer;
+	uint32_t		 path_id;
+	uint32_t		 penalty;
+	uint32_t		 lastupdate;	/* monotime in seconds */
+	uint32_t		 deadline;	/* monotime in seconds */
+	uint8_t			 suppressed;
+};
+
+LIST_HEAD(damp_slot, rde_damp);
+
+/* 2^(-k/64) in 16.16 fixed point */
+static const uint32_t damp_decay_tbl[64] = {
+	65536, 64830, 64132, 63441, 62757, 62081, 61413, 60751,
+	60097, 59449, 58809, 58176, 57549, 56929, 56316, 55709,
+	55109, 54515, 53928, 53347, 52773, 52204, 51642, 51085,
+	50535, 49991, 49452, 48920, 48393, 47871, 47356, 46846,
+	46341, 45842, 45348, 44859, 44376, 43898, 43425, 42958,
+	42495, 42037, 41584, 41136, 40693, 40255, 39821, 39392,
+	38968, 38548, 38133, 37722, 37316, 36914, 36516, 36123,
+	35734, 35349, 34968, 34591, 34219, 33850, 33486, 33125,
+};
+
+static struct damp_slot		 damp_wheel[DAMP_WHEEL_SLOTS];
+static struct dampening_config	 damp_conf = {
+	.halflife = DAMP_HALFLIFE,
+	.maxsuppress = DAMP_MAXSUPPRESS,
+	.reuse = DAMP_REUSE,
+	.suppress = DAMP_SUPPRESS,
+};
+static uint64_t			 damp_key;
+static uint32_t			 damp_ceiling;
+static uint32_t			 damp_tick;
+static uint32_t			 damp_cnt;
+
+static inline uint64_t
+damp_hash(const struct rde_damp *d)
+{
+	uint64_t	h = damp_key;
+
+	h = ch_qhash64(h, (uintptr_t)d->pt);
+	h = ch_qhash64(h, d->path_id);
+	return h;
+}
+
+static inline int
+damp_eq(const struct rde_damp *a, const struct rde_damp *b)
+{
+	if (a->pt != b->pt)
+		return 0;
+	if (a->path_id != b->path_id)
+		return 0;
+	return 1;
+}
+
+CH_PROTOTYPE(rde_damp_hash, rde_damp, damp_hash);
+
+static uint32_t
+damp_now(void)
+{
+	return monotime_to_sec(getmonotime());
+}
+
+/* Decay penalty for dt seconds: penalty * 2^(-dt / halflife). */
+static uint32_t
+damp_decay(uint32_t penalty, uint32_t dt)
+{
+	uint32_t n, frac;
+
+	n = dt / damp_conf.halflife;
+	if (n >= 32)
+		return 0;
+	frac = (uint64_t)(dt % damp_conf.halflife) * 64 / damp_conf.halflife;
+	return ((uint64_t)(penalty >> n) * damp_decay_tbl[frac]) >> 16;
+}
+
+/* Seconds until penalty decayed below limit. */
+static uint32_t
+damp_time_to(uint32_t penalty, uint32_t limit)
+{
+	uint32_t n = 0, k, p;
+
+	if (limit == 0)
+		limit = 1;
+	if (penalty < limit)
+		return 0;
+	while ((penalty >> (n + 1)) >= limit)
+		n++;
+	p = penalty >> n;
+	for (k = 0; k < 64; k++)
+		if ((((uint64_t)p * damp_decay_tbl[k]) >> 16) < limit)
+			break;
+	return n * damp_conf.halflife + (k * damp_conf.halflife + 63) / 64;
+}
+
+static void
+damp_schedule(struct rde_damp *d, uint32_t now)
+{
+	uint32_t wait, tick;
+
+	if (d->suppressed)
+		wait = damp_time_to(d->penalty, damp_conf.reuse);
+	else
+		wait = damp_time_to(d->penalty, damp_conf.reuse / 2);
+	/* the penalty is valid at lastupdate, which may lag behind now */
+	d->deadline = d->lastupdate + wait;
+	if (d->deadline <= now)
+		d->deadline = now + 1;
+
+	tick = (d->deadline + DAMP_WHEEL_TICK - 1) / DAMP_WHEEL_TICK;
+	if (d->wheel.le_prev != NULL)
+		LIST_REMOVE(d, wheel);
+	LIST_INSERT_HEAD(&damp_wheel[tick % DAMP_WHEEL_SLOTS], d, wheel);
+}
+
+static struct rde_damp *
+damp_lookup(struct rde_peer *peer, uint32_t path_id, struct pt_entry *pt)
+{
+	struct rde_damp needle = { .pt = pt, .path_id = path_id };
+
+	return CH_FIND(rde_damp_hash, &peer->damp, &needle);
+}
+
+static struct rde_damp *
+damp_alloc(struct rde_peer *peer, uint32_t path_id, struct pt_entry *pt,
+    uint32_t now)
+{
+	struct rde_damp *d;
+
+	if ((d = calloc(1, sizeof(*d))) == NULL)
+		fatal(__func__);
+	d->pt = pt_ref(pt);
+	d->peer = peer;
+	d->path_id = path_id;
+	d->lastupdate = now;
+
+	if (CH_INSERT(rde_damp_hash, &peer->damp, d, NULL) != 1)
+		fatalx("%s: object already in table", __func__);
+	damp_cnt++;
+	return d;
+}
+
+static void
+damp_free(struct rde_damp *d)
+{
+	if (d->wheel.le_prev != NULL)
+		LIST_REMOVE(d, wheel);
+	pt_unref(d->pt);
+	damp_cnt--;
+	free(d);
+}
+
+static void
+damp_remove(struct rde_damp *d)
+{
+	if (CH_REMOVE(rde_damp_hash, &d->peer->damp, d) != d)
+		fatalx("%s: missing dampening entry in hash table", __func__);
+	damp_free(d);
+}
+
+/* Bring the penalty up to date, returns 1 if the path is still suppressed. */
+static int
+damp_refresh(struct rde_damp *d, uint32_t now)
+{
+	uint32_t dt, n, frac;
+
+	dt = now - d->lastupdate;
+	d->penalty = damp_decay(d->penalty, dt);
+	/*
+	 * The decay table works in steps of halflife / 64. Only advance
+	 * lastupdate by the time that was accounted for, else frequent
+	 * refreshes would lose the remainder and the penalty never decays.
+	 */
+	n = dt / damp_conf.halflife;
+	if (n >= 32)
+		d->lastupdate = now;
+	else {
+		frac = (uint64_t)(dt % damp_conf.halflife) * 64 /
+		    damp_conf.halflife;
+		d->lastupdate += n * damp_conf.halflife +
+		    (frac * damp_conf.halflife + 63) / 64;
+	}
+	if (d->suppressed && d->penalty < damp_conf.reuse)
+		d->suppressed = 0;
+	return d->suppressed;
+}
+
+static int
+damp_penalize(struct rde_peer *peer, uint32_t path_id, struct pt_entry *pt,
+    uint32_t penalty)
+{
+	struct rde_damp *d;
+	uint32_t now = damp_now();
+
+	if ((d = damp_lookup(peer, path_id, pt)) == NULL)
+		d = damp_alloc(peer, path_id, pt, now);
+
+	damp_refresh(d, now);
+	d->penalty += penalty;
+	if (d->penalty > damp_ceiling)
+		d->penalty = damp_ceiling;
+	if (!d->suppressed && d->penalty > damp_conf.suppress)
+		d->suppressed = 1;
+	damp_schedule(d, now);
+	return d->suppressed;
+}
+
+void
+rde_damp_init(void)
+{
+	unsigned int i;
+
+	arc4random_buf(&damp_key, sizeof(damp_key));
+	for (i = 0; i < DAMP_WHEEL_SLOTS; i++)
+		LIST_INIT(&damp_wheel[i]);
+	damp_tick = damp_now() / DAMP_WHEEL_TICK;
+	rde_damp_config(&damp_conf);
+}
+
+/*
+ * Apply new dampening parameters. Existing entries keep their penalty
+ * and pick up the new parameters the next time they are looked at.
+ */
+void
+rde_damp_config(const struct dampening_config *dc)
+{
+	uint64_t ceiling;
+	uint32_t n, frac;
+
+	damp_conf = *dc;
+
+	/*
+	 * maximum penalty: reuse * 2^(maxsuppress / halflife) minus one
+	 * so that the penalty drops below reuse after maxsuppress seconds.
+	 */
+	n = damp_conf.maxsuppress / damp_conf.halflife;
+	frac = (uint64_t)(damp_conf.maxsuppress % damp_conf.halflife) * 64 /
+	    damp_conf.halflife;
+	if (n >= 32)
+		ceiling = UINT32_MAX;
+	else
+		ceiling = ((uint64_t)damp_conf.reuse << n << 16) /
+		    damp_decay_tbl[frac] - 1;
+	/* leave room so adding a penalty can not overflow */
+	if (ceiling > UINT32_MAX / 2)
+		ceiling = UINT32_MAX / 2;
+	damp_ceiling = ceiling;
+}
+
+void
+rde_damp_peer_init(struct rde_peer *peer)
+{
+	CH_INIT(rde_damp_hash, &peer->damp);
+}
+
+/*
+ * Forget all dampening state of a peer. If reuse is set suppressed paths
+ * are reinstated in the Loc-RIBs.
+ */
+void
+rde_damp_peer_flush(struct rde_peer *peer, int reuse)
+{
+	struct damp_slot	 flush = LIST_HEAD_INITIALIZER(flush);
+	struct rde_damp		*d;
+	struct ch_iter		 iter;
+
+	CH_FOREACH(d, rde_damp_hash, &peer->damp, &iter) {
+		LIST_REMOVE(d, wheel);
+		LIST_INSERT_HEAD(&flush, d, wheel);
+	}
+	CH_DESTROY(rde_damp_hash, &peer->damp);
+
+	while ((d = LIST_FIRST(&flush)) != NULL) {
+		if (reuse && d->suppressed) {
+			d->suppressed = 0;
+			rde_update_reuse(peer, d->path_id, d->pt);
+		}
+		damp_free(d);
+	}
+}
+
+/*
+ * Account a withdraw of a path, returns 1 if the path is suppressed.
+ */
+int
+rde_damp_withdraw(struct rde_peer *peer, uint32_t path_id,
+    struct pt_entry *pt)
+{
+	return damp_penalize(peer, path_id, pt, DAMP_PENALTY_WITHDRAW);
+}
+
+/*
+ * Account an update of a path, changed is set if the path attributes
+ * differ from the ones in the Adj-RIB-In. A readvertisement after a
+ * withdraw is not penalized again. Returns 1 if the path is suppressed.
+ */
+int
+rde_damp_update(struct rde_peer *peer, uint32_t path_id,
+    struct pt_entry *pt, int changed)
+{
+	struct rde_damp *d;
+
+	if (changed)
+		return damp_penalize(peer, path_id, pt, DAMP_PENALTY_CHANGE);
+	if ((d = damp_lookup(peer, path_id, pt)) == NULL)
+		return 0;
+	return damp_refresh(d, damp_now());
+}
+
+int
+rde_damp_suppressed(struct rde_peer *peer, uint32_t path_id,
+    struct pt_entry *pt)
+{
+	struct rde_damp *d;
+
+	if ((peer->flags & PEERFLAG_DAMPENING) == 0)
+		return 0;
+	if ((d = damp_lookup(peer, path_id, pt)) == NULL)
+		return 0;
+	return d->suppressed;
+}
+
+/*
+ * Return the poll timeout in milliseconds until the next wheel tick
+ * or -1 if there is nothing to do.
+ */
+int
+rde_damp_timeout(void)
+{
+	long long next;
+
+	if (damp_cnt == 0)
+		return -1;
+	next = (long long)(damp_tick + 1) * DAMP_WHEEL_TICK * 1000 -
+	    monotime_to_msec(getmonotime());
+	if (next < 0)
+		return 0;
+	return next;
+}
+
+static void
+damp_expire(struct rde_damp *d, uint32_t now)
+{
+	if (d->suppressed) {
+		if (!damp_refresh(d, now))
+			rde_update_reuse(d->peer, d->path_id, d->pt);
+	} else {
+		damp_refresh(d, now);
+		if (d->penalty < damp_conf.reuse / 2) {
+			damp_remove(d);
+			return;
+		}
+	}
+	damp_schedule(d, now);
+}
+
+/*
+ * Advance the timer wheel and handle all entries that are due.
+ */
+void
+rde_damp_run(void)
+{
+	struct rde_damp	*d, *nd;
+	uint32_t	 now, tick, t;
+
+	now = damp_now();
+	tick = now / DAMP_WHEEL_TICK;
+	if (tick == damp_tick)
+		return;
+
+	t = damp_tick + 1;
+	/* after a long pause one rotation covers all slots */
+	if (tick - damp_tick > DAMP_WHEEL_SLOTS)
+		t = tick - DAMP_WHEEL_SLOTS + 1;
+	for (; t <= tick; t++) {
+		LIST_FOREACH_SAFE(d, &damp_wheel[t % DAMP_WHEEL_SLOTS],
+		    wheel, nd) {
+			if (d->deadline > now)
+				continue;
+			damp_expire(d, now);
+		}
+	}
+	damp_tick = tick;
+}
+
+CH_GENERATE(rde_damp_hash, rde_damp, damp_eq, damp_hash);
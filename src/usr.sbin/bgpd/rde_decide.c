@@ -530,8 +530,8 @@ prefix_best(struct rib_entry *re)
  * with new = prefix, old = NULL. This ensures proper evaluation in case
  * the prefix change influences prefix_eligible() or MED handling.
  */
-void
-prefix_evaluate(struct rib_entry *re, struct prefix *new, struct prefix *old)
+static void
+prefix_evaluate_r(struct rib_entry *re, struct prefix *new, struct prefix *old)
 {
 	struct prefix	*newbest, *oldbest;
 	struct rde_peer	*peer = NULL;
@@ -600,6 +600,23 @@ prefix_evaluate(struct rib_entry *re, struct prefix *new, struct prefix *old)
 	}
 }
 
+void
+prefix_evaluate(struct rib_entry *re, struct prefix *new, struct prefix *old)
+{
+	static unsigned int	 sample;
+	monotime_t		 start;
+
+	RDE_TRACE(prefix_evaluate_start, re);
+	if (++sample % RDE_LAT_SAMPLE != 0) {
+		prefix_evaluate_r(re, new, old);
+	} else {
+		start = getmonotime();
+		prefix_evaluate_r(re, new, old);
+		rde_latency_add(RDE_LAT_DECISION, start);
+	}
+	RDE_TRACE(prefix_evaluate_done, re);
+}
+
 void
 prefix_evaluate_nexthop(struct prefix *p, enum nexthop_state state,
     enum nexthop_state oldstate)
@@ -391,14 +391,79 @@ rde_filter_skip_rule(struct rde_peer *peer, struct filter_rule *f)
 	return (0);
 }
 
-int
-rde_filter_equal(struct filter_head *a, struct filter_head *b)
+enum rule_cmp {
+	RULE_EQUAL,
+	RULE_PSET_CHANGED,
+	RULE_CHANGED,
+};
+
+/*
+ * Compare two rules, rule fa is from the new ruleset where the sets are
+ * marked dirty if they changed. Return RULE_PSET_CHANGED if the only
+ * difference is a changed prefix-set.
+ */
+static enum rule_cmp
+rde_filter_rule_cmp(struct filter_rule *fa, struct filter_rule *fb)
 {
-	struct filter_rule	*fa, *fb;
 	struct rde_prefixset	*psa, *psb, *osa, *osb;
 	struct as_set		*asa, *asb;
 	int			 r;
 
+	if (fa->action != fb->action || fa->quick != fb->quick)
+		return (RULE_CHANGED);
+	if (memcmp(&fa->peer, &fb->peer, sizeof(fa->peer)))
+		return (RULE_CHANGED);
+
+	/* compare filter_rule.match without the prefixset pointer */
+	psa = fa->match.prefixset.ps;
+	psb = fb->match.prefixset.ps;
+	osa = fa->match.originset.ps;
+	osb = fb->match.originset.ps;
+	asa = fa->match.as.aset;
+	asb = fb->match.as.aset;
+	fa->match.prefixset.ps = fb->match.prefixset.ps = NULL;
+	fa->match.originset.ps = fb->match.originset.ps = NULL;
+	fa->match.as.aset = fb->match.as.aset = NULL;
+	r = memcmp(&fa->match, &fb->match, sizeof(fa->match));
+	/* fixup the struct again */
+	fa->match.prefixset.ps = psa;
+	fb->match.prefixset.ps = psb;
+	fa->match.originset.ps = osa;
+	fb->match.originset.ps = osb;
+	fa->match.as.aset = asa;
+	fb->match.as.aset = asb;
+	if (r != 0)
+		return (RULE_CHANGED);
+	if (fa->match.originset.ps != NULL &&
+	    fa->match.originset.ps->dirty) {
+		log_debug("%s: originset %s has changed",
+		    __func__, fa->match.originset.name);
+		return (RULE_CHANGED);
+	}
+	if ((fa->match.as.flags & AS_FLAG_AS_SET) &&
+	    fa->match.as.aset->dirty) {
+		log_debug("%s: as-set %s has changed",
+		    __func__, fa->match.as.name);
+		return (RULE_CHANGED);
+	}
+	if (!rde_filterset_equal(fa->rde_set, fb->rde_set))
+		return (RULE_CHANGED);
+	if (fa->match.prefixset.ps != NULL &&
+	    fa->match.prefixset.ps->dirty) {
+		log_debug("%s: prefixset %s has changed",
+		    __func__, fa->match.prefixset.name);
+		if (psb == NULL)
+			return (RULE_CHANGED);
+		return (RULE_PSET_CHANGED);
+	}
+	return (RULE_EQUAL);
+}
+
+int
+rde_filter_equal(struct filter_head *a, struct filter_head *b)
+{
+	struct filter_rule	*fa, *fb;
+
 	fa = a ? TAILQ_FIRST(a) : NULL;
 	fb = b ? TAILQ_FIRST(b) : NULL;
 
@@ -407,58 +472,205 @@ rde_filter_equal(struct filter_head *a, struct filter_head *b)
 		if ((fa == NULL && fb != NULL) || (fa != NULL && fb == NULL))
 			/* new rule added or removed */
 			return (0);
-
-		if (fa->action != fb->action || fa->quick != fb->quick)
-			return (0);
-		if (memcmp(&fa->peer, &fb->peer, sizeof(fa->peer)))
+		if (rde_filter_rule_cmp(fa, fb) != RULE_EQUAL)
 			return (0);
 
-		/* compare filter_rule.match without the prefixset pointer */
-		psa = fa->match.prefixset.ps;
-		psb = fb->match.prefixset.ps;
-		osa = fa->match.originset.ps;
-		osb = fb->match.originset.ps;
-		asa = fa->match.as.aset;
-		asb = fb->match.as.aset;
-		fa->match.prefixset.ps = fb->match.prefixset.ps = NULL;
-		fa->match.originset.ps = fb->match.originset.ps = NULL;
-		fa->match.as.aset = fb->match.as.aset = NULL;
-		r = memcmp(&fa->match, &fb->match, sizeof(fa->match));
-		/* fixup the struct again */
-		fa->match.prefixset.ps = psa;
-		fb->match.prefixset.ps = psb;
-		fa->match.originset.ps = osa;
-		fb->match.originset.ps = osb;
-		fa->match.as.aset = asa;
-		fb->match.as.aset = asb;
-		if (r != 0)
-			return (0);
-		if (fa->match.prefixset.ps != NULL &&
-		    fa->match.prefixset.ps->dirty) {
-			log_debug("%s: prefixset %s has changed",
-			    __func__, fa->match.prefixset.name);
-			return (0);
-		}
-		if (fa->match.originset.ps != NULL &&
-		    fa->match.originset.ps->dirty) {
-			log_debug("%s: originset %s has changed",
-			    __func__, fa->match.originset.name);
-			return (0);
-		}
-		if ((fa->match.as.flags & AS_FLAG_AS_SET) &&
-		    fa->match.as.aset->dirty) {
-			log_debug("%s: as-set %s has changed",
-			    __func__, fa->match.as.name);
-			return (0);
-		}
+		fa = TAILQ_NEXT(fa, entry);
+		fb = TAILQ_NEXT(fb, entry);
+	}
+	return (1);
+}
 
-		if (!rde_filterset_equal(fa->rde_set, fb->rde_set))
-			return (0);
+static int
+rde_filter_scope_add(struct rde_filter_scope *fs, struct filter_rule *new,
+    struct filter_rule *old, int psonly)
+{
+	struct rde_filter_change	*fc;
+	size_t				 size;
+
+	if (fs->nchanges == fs->size) {
+		size = fs->size == 0 ? 8 : fs->size * 2;
+		fc = reallocarray(fs->changes, size, sizeof(*fc));
+		if (fc == NULL)
+			return (-1);
+		fs->changes = fc;
+		fs->size = size;
+	}
+	fc = &fs->changes[fs->nchanges++];
+	fc->new = new;
+	fc->old = old;
+	fc->psonly = psonly;
+	return (0);
+}
 
+/* a rule without any peer selector applies to all peers */
+static int
+rde_filter_rule_any_peer(struct filter_rule *r)
+{
+	return (r != NULL && r->peer.peerid == 0 && r->peer.groupid == 0 &&
+	    r->peer.remote_as == 0 && r->peer.ebgp == 0 && r->peer.ibgp == 0);
+}
+
+/*
+ * Compare the new ruleset a with the old ruleset b and collect the rules
+ * that differ. The rulesets are compared from the front and the back, the
+ * block of rules in between is considered changed. Paths from peers that
+ * are not selected by any of the changed rules are not affected by the
+ * change. The same is true for prefixes that got the same result from the
+ * old and new prefix-set. Returns NULL if every path is affected and a
+ * full reload is needed.
+ */
+struct rde_filter_scope *
+rde_filter_scope(struct filter_head *a, struct filter_head *b)
+{
+	struct rde_filter_scope	*fs;
+	struct filter_rule	*fa, *fb, *la, *lb;
+	size_t			 na = 0, nb = 0, n, i, t;
+	enum rule_cmp		 cmp;
+
+	if (a == NULL || b == NULL)
+		return (NULL);
+	if ((fs = calloc(1, sizeof(*fs))) == NULL)
+		return (NULL);
+
+	TAILQ_FOREACH(fa, a, entry)
+		na++;
+	TAILQ_FOREACH(fb, b, entry)
+		nb++;
+	n = na < nb ? na : nb;
+
+	/* common head of the rulesets */
+	fa = TAILQ_FIRST(a);
+	fb = TAILQ_FIRST(b);
+	for (i = 0; i < n; i++) {
+		if ((cmp = rde_filter_rule_cmp(fa, fb)) == RULE_CHANGED)
+			break;
+		if (cmp == RULE_PSET_CHANGED &&
+		    rde_filter_scope_add(fs, fa, fb, 1) == -1)
+			goto fail;
 		fa = TAILQ_NEXT(fa, entry);
 		fb = TAILQ_NEXT(fb, entry);
 	}
-	return (1);
+
+	/* common tail of the rulesets */
+	la = TAILQ_LAST(a, filter_head);
+	lb = TAILQ_LAST(b, filter_head);
+	for (t = 0; t < n - i; t++) {
+		if ((cmp = rde_filter_rule_cmp(la, lb)) == RULE_CHANGED)
+			break;
+		if (cmp == RULE_PSET_CHANGED &&
+		    rde_filter_scope_add(fs, la, lb, 1) == -1)
+			goto fail;
+		la = TAILQ_PREV(la, filter_head, entry);
+		lb = TAILQ_PREV(lb, filter_head, entry);
+	}
+
+	/* everything in between was added, removed or modified */
+	for (n = na - i - t; n > 0; n--, fa = TAILQ_NEXT(fa, entry))
+		if (rde_filter_rule_any_peer(fa) ||
+		    rde_filter_scope_add(fs, fa, NULL, 0) == -1)
+			goto fail;
+	for (n = nb - i - t; n > 0; n--, fb = TAILQ_NEXT(fb, entry))
+		if (rde_filter_rule_any_peer(fb) ||
+		    rde_filter_scope_add(fs, NULL, fb, 0) == -1)
+			goto fail;
+
+	fs->old_rules = b;
+	return (fs);
+
+ fail:
+	rde_filter_scope_free(fs);
+	return (NULL);
+}
+
+/*
+ * Return 1 if the path of peer for prefix/plen may be affected by the
+ * changes recorded in the scope.
+ */
+int
+rde_filter_scope_match(struct rde_filter_scope *fs, struct rde_peer *peer,
+    struct bgpd_addr *prefix, uint8_t plen)
+{
+	struct rde_filter_change	*fc;
+	size_t				 i;
+	int				 longer;
+
+	for (i = 0; i < fs->nchanges; i++) {
+		fc = &fs->changes[i];
+		if ((fc->new == NULL || rde_filter_skip_rule(peer, fc->new)) &&
+		    (fc->old == NULL || rde_filter_skip_rule(peer, fc->old)))
+			continue;
+		if (!fc->psonly)
+			return (1);
+		longer = fc->new->match.prefixset.flags & PREFIXSET_FLAG_LONGER;
+		if (trie_match(&fc->new->match.prefixset.ps->th, prefix, plen,
+		    longer) != trie_match(&fc->old->match.prefixset.ps->th,
+		    prefix, plen, longer))
+			return (1);
+	}
+	return (0);
+}
+
+void
+rde_filter_scope_free(struct rde_filter_scope *fs)
+{
+	if (fs == NULL)
+		return;
+	filterlist_free(fs->old_rules);
+	free(fs->changes);
+	free(fs);
+}
+
+static int
+rde_filter_match_set(const struct filter_match *m, const void *set)
+{
+	if (m->prefixset.ps == set || m->originset.ps == set)
+		return (1);
+	if ((m->as.flags & AS_FLAG_AS_SET) && m->as.aset == set)
+		return (1);
+	return (0);
+}
+
+/*
+ * Build a scope covering all rules in rules that use set. Used when a
+ * prefix-set or as-set is modified at runtime. Returns NULL if no rule
+ * references the set.
+ */
+struct rde_filter_scope *
+rde_filter_set_scope(struct filter_head *rules, const void *set)
+{
+	struct rde_filter_scope	*fs;
+	struct filter_rule	*r;
+
+	if (rules == NULL)
+		return (NULL);
+	if ((fs = calloc(1, sizeof(*fs))) == NULL)
+		fatal(NULL);
+	TAILQ_FOREACH(r, rules, entry) {
+		if (!rde_filter_match_set(&r->match, set))
+			continue;
+		if (rde_filter_scope_add(fs, r, NULL, 0) == -1)
+			fatal(NULL);
+	}
+	if (fs->nchanges == 0) {
+		rde_filter_scope_free(fs);
+		return (NULL);
+	}
+	return (fs);
+}
+
+/* Return 1 if any rule of the compiled out filter uses set. */
+int
+rde_filter_uses_set(const struct rde_filter *rf, const void *set)
+{
+	size_t	i;
+
+	if (rf == NULL)
+		return (0);
+	for (i = 0; i < rf->len; i++)
+		if (rde_filter_match_set(&rf->rules[i].match, set))
+			return (1);
+	return (0);
 }
 
 static SIPHASH_KEY	rfkey;
@@ -1097,8 +1309,8 @@ rde_filter_calc_skip_steps(struct filter_head *rules)
 
 }
 
-enum filter_action
-rde_filter(struct filter_head *rules, struct rde_peer *peer,
+static enum filter_action
+rde_filter_r(struct filter_head *rules, struct rde_peer *peer,
     struct rde_peer *from, struct bgpd_addr *prefix, uint8_t plen,
     struct filterstate *state)
 {
@@ -1156,6 +1368,27 @@ rde_filter(struct filter_head *rules, struct rde_peer *peer,
 	return (action);
 }
 
+enum filter_action
+rde_filter(struct filter_head *rules, struct rde_peer *peer,
+    struct rde_peer *from, struct bgpd_addr *prefix, uint8_t plen,
+    struct filterstate *state)
+{
+	static unsigned int	 sample;
+	enum filter_action	 action;
+	monotime_t		 start;
+
+	RDE_TRACE(rde_filter_start, prefix);
+	if (++sample % RDE_LAT_SAMPLE != 0) {
+		action = rde_filter_r(rules, peer, from, prefix, plen, state);
+	} else {
+		start = getmonotime();
+		action = rde_filter_r(rules, peer, from, prefix, plen, state);
+		rde_latency_add(RDE_LAT_FILTER, start);
+	}
+	RDE_TRACE(rde_filter_done, action);
+	return (action);
+}
+
 enum filter_action
 rde_filter_out(struct rde_filter *rf, struct rde_peer *peer,
     struct rde_peer *from, struct bgpd_addr *prefix, uint8_t plen,
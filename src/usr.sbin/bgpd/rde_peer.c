@@ -154,6 +154,8 @@ peer_add(uint32_t id, struct peer_config *p_conf, struct filter_head *rules)
 
 	if ((peer = peer_get(id))) {
 		memcpy(&peer->conf, p_conf, sizeof(struct peer_config));
+		/* cached parse results may depend on the old config */
+		attrcache_peer_flush(peer);
 		return peer;
 	}
 
@@ -176,6 +178,8 @@ peer_add(uint32_t id, struct peer_config *p_conf, struct filter_head *rules)
 		fatal(NULL);
 
 	adjout_peer_init(peer);
+	rde_damp_peer_init(peer);
+	attrcache_peer_init(peer);
 	if (peer_apply_out_filter(peer, rules) != NULL)
 		fatalx("peer add: peer_apply_out_filter failed");
 
@@ -332,24 +336,72 @@ rde_enqueue_updates(struct rib_entry *re, struct rde_peer *peer,
 		re->pq_mode = mode;
 }
 
+/*
+ * Remember the start of an UPDATE that queued rib entries on peer.
+ * The UPDATE latency is recorded once all entries queued so far have
+ * been processed by peer_process_updates(). If too many samples are
+ * outstanding the sample is dropped.
+ */
 void
-peer_process_updates(struct rde_peer *peer, void *bula)
+peer_latency_mark(struct rde_peer *peer, monotime_t start)
+{
+	struct rde_lat_mark *lm;
+
+	if (peer->lat_cnt >= RDE_LAT_MARKS)
+		return;
+	lm = &peer->lat_marks[(peer->lat_first + peer->lat_cnt) %
+	    RDE_LAT_MARKS];
+	lm->start = start;
+	lm->mark = peer->rib_pq_done + peer->stats.rib_entry_count;
+	peer->lat_cnt++;
+}
+
+static void
+peer_latency_done(struct rde_peer *peer)
+{
+	struct rde_lat_mark *lm;
+
+	while (peer->lat_cnt > 0) {
+		lm = &peer->lat_marks[peer->lat_first];
+		if (lm->mark > peer->rib_pq_done)
+			break;
+		rde_latency_add(RDE_LAT_UPDATE, lm->start);
+		peer->lat_first = (peer->lat_first + 1) % RDE_LAT_MARKS;
+		peer->lat_cnt--;
+	}
+}
+
+/*
+ * Process up to *quantum queued rib entries of peer and generate
+ * the updates for all other peers.
+ */
+void
+peer_process_updates(struct rde_peer *peer, void *arg)
 {
 	struct rib_entry *re;
 	struct rde_peer *p;
+	monotime_t start;
+	unsigned int *quantum = arg, n;
 
-	re = TAILQ_FIRST(&peer->rib_pq_head);
-	if (re == NULL)
-		return;
-	TAILQ_REMOVE(&peer->rib_pq_head, re, rib_queue);
-	rdemem.rde_rib_entry_count--;
-	peer->stats.rib_entry_count--;
+	for (n = 0; n < *quantum; n++) {
+		re = TAILQ_FIRST(&peer->rib_pq_head);
+		if (re == NULL)
+			return;
+		TAILQ_REMOVE(&peer->rib_pq_head, re, rib_queue);
+		rdemem.rde_rib_entry_count--;
+		peer->stats.rib_entry_count--;
 
-	RB_FOREACH(p, peer_tree, &peertable)
-		peer_generate_update(p, re, re->pq_mode);
+		start = getmonotime();
+		RB_FOREACH(p, peer_tree, &peertable)
+			peer_generate_update(p, re, re->pq_mode);
 
-	adjout_prefix_collect(re->prefix);
-	rib_pq_dequeue(re);
+		adjout_prefix_collect(re->prefix);
+		rib_pq_dequeue(re);
+		rde_latency_add(RDE_LAT_ADJOUT, start);
+
+		peer->rib_pq_done++;
+		peer_latency_done(peer);
+	}
 }
 
 /*
@@ -441,6 +493,7 @@ peer_up(struct rde_peer *peer, struct session_up *sup)
 	peer->remote_bgpid = sup->remote_bgpid;
 	peer->local_if_scope = sup->if_scope;
 	peer->short_as = sup->short_as;
+	attrcache_peer_flush(peer);
 
 	/* clear eor markers depending on GR flags */
 	if (peer->capa.grestart.restart) {
@@ -451,6 +504,8 @@ peer_up(struct rde_peer *peer, struct session_up *sup)
 		peer->sent_eor = ~0;
 		peer->recv_eor = ~0;
 	}
+	/* the initial table dump is not rate limited */
+	memset(peer->mrai_next, 0, sizeof(peer->mrai_next));
 	peer->state = PEER_UP;
 
 	if (!force_sync) {
@@ -482,6 +537,7 @@ peer_down(struct rde_peer *peer)
 	rib_dump_terminate(peer);
 	adjout_peer_flush_pending(peer);
 	peer_imsg_flush(peer);
+	attrcache_peer_flush(peer);
 
 	/* flush Adj-RIB-In */
 	peer_flush(peer, AID_UNSPEC, monotime_clear());
@@ -521,6 +577,8 @@ peer_delete(struct rde_peer *peer)
 
 	rde_filter_unref(peer->out_rules);
 	adjout_peer_free(peer);
+	rde_damp_peer_flush(peer, 0);
+	attrcache_peer_flush(peer);
 
 	TAILQ_CONCAT(&peerself->rib_pq_head, &peer->rib_pq_head, rib_queue);
 	peerself->stats.rib_entry_count += peer->stats.rib_entry_count;
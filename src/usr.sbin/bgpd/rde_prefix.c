@@ -667,6 +667,35 @@ pt_free(struct pt_entry *pte)
 	free(pte);
 }
 
+/*
+ * Dump an IPv4 or IPv6 prefix into buf. The prefix is stored masked and in
+ * network byte order so the wire format is the prefixlen followed by the
+ * significant bytes of the address.
+ */
+static inline int
+pt_writebuf_inet(struct ibuf *buf, struct pt_entry *pte, int withdraw,
+    int add_path, uint32_t pathid)
+{
+	uint8_t		*p;
+	size_t		 psize, len;
+
+	psize = PREFIX_SIZE(pte->prefixlen);
+	len = psize + (add_path ? sizeof(pathid) : 0);
+	/* keep 2 bytes reserved in the withdraw case for IPv4 encoding */
+	if (ibuf_left(buf) < len + (withdraw ? 2 : 0))
+		return -1;
+	if ((p = ibuf_reserve(buf, len)) == NULL)
+		return -1;
+	if (add_path) {
+		pathid = htobe32(pathid);
+		memcpy(p, &pathid, sizeof(pathid));
+		p += sizeof(pathid);
+	}
+	p[0] = pte->prefixlen;
+	memcpy(p + 1, pte->data, psize - 1);
+	return 0;
+}
+
 /* dump a prefix into specified buffer */
 int
 pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
@@ -676,27 +705,21 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 	struct pt_entry_vpn6	*pvpn6 = (struct pt_entry_vpn6 *)pte;
 	struct pt_entry_flow	*pflow = (struct pt_entry_flow *)pte;
 	struct pt_entry_evpn	*pevpn = (struct pt_entry_evpn *)pte;
-	struct ibuf		*tmp;
+	size_t			 off;
 	int			 flowlen, psize;
 	uint16_t		 plen;
 
-	if ((tmp = ibuf_dynamic(32, UINT16_MAX)) == NULL)
-		goto fail;
+	if (pte->aid == AID_INET || pte->aid == AID_INET6)
+		return pt_writebuf_inet(buf, pte, withdraw, add_path, pathid);
 
+	/* written in place, on failure buf is truncated back to off */
+	off = ibuf_size(buf);
 	if (add_path) {
-		if (ibuf_add_n32(tmp, pathid) == -1)
+		if (ibuf_add_n32(buf, pathid) == -1)
 			goto fail;
 	}
 
 	switch (pte->aid) {
-	case AID_INET:
-	case AID_INET6:
-		plen = pte->prefixlen;
-		if (ibuf_add_n8(tmp, plen) == -1)
-			goto fail;
-		if (ibuf_add(tmp, pte->data, PREFIX_SIZE(plen) - 1) == -1)
-			goto fail;
-		break;
 	case AID_VPN_IPv4:
 		plen = pvpn4->prefixlen;
 		psize = PREFIX_SIZE(plen) - 1;
@@ -708,20 +731,20 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 			plen += pvpn4->labellen * 8;
 		}
 
-		if (ibuf_add_n8(tmp, plen) == -1)
+		if (ibuf_add_n8(buf, plen) == -1)
 			goto fail;
 		if (withdraw) {
 			/* magic compatibility label as per rfc8277 */
-			if (ibuf_add_n8(tmp, 0x80) == -1 ||
-			    ibuf_add_zero(tmp, 2) == -1)
+			if (ibuf_add_n8(buf, 0x80) == -1 ||
+			    ibuf_add_zero(buf, 2) == -1)
 				goto fail;
 		} else {
-			if (ibuf_add(tmp, &pvpn4->labelstack,
+			if (ibuf_add(buf, &pvpn4->labelstack,
 			    pvpn4->labellen) == -1)
 				goto fail;
 		}
-		if (ibuf_add(tmp, &pvpn4->rd, sizeof(pvpn4->rd)) == -1 ||
-		    ibuf_add(tmp, &pvpn4->prefix4, psize) == -1)
+		if (ibuf_add(buf, &pvpn4->rd, sizeof(pvpn4->rd)) == -1 ||
+		    ibuf_add(buf, &pvpn4->prefix4, psize) == -1)
 			goto fail;
 		break;
 	case AID_VPN_IPv6:
@@ -735,24 +758,24 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 			plen += pvpn6->labellen * 8;
 		}
 
-		if (ibuf_add_n8(tmp, plen) == -1)
+		if (ibuf_add_n8(buf, plen) == -1)
 			goto fail;
 		if (withdraw) {
 			/* magic compatibility label as per rfc8277 */
-			if (ibuf_add_n8(tmp, 0x80) == -1 ||
-			    ibuf_add_zero(tmp, 2) == -1)
+			if (ibuf_add_n8(buf, 0x80) == -1 ||
+			    ibuf_add_zero(buf, 2) == -1)
 				goto fail;
 		} else {
-			if (ibuf_add(tmp, &pvpn6->labelstack,
+			if (ibuf_add(buf, &pvpn6->labelstack,
 			    pvpn6->labellen) == -1)
 				goto fail;
 		}
-		if (ibuf_add(tmp, &pvpn6->rd, sizeof(pvpn6->rd)) == -1 ||
-		    ibuf_add(tmp, &pvpn6->prefix6, psize) == -1)
+		if (ibuf_add(buf, &pvpn6->rd, sizeof(pvpn6->rd)) == -1 ||
+		    ibuf_add(buf, &pvpn6->prefix6, psize) == -1)
 			goto fail;
 		break;
 	case AID_EVPN:
-		if (ibuf_add_n8(tmp, pevpn->type) == -1)
+		if (ibuf_add_n8(buf, pevpn->type) == -1)
 			goto fail;
 		switch (pevpn->type) {
 		case EVPN_ROUTE_TYPE_2:
@@ -764,36 +787,36 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 			plen += 8;	/* IP length */
 			plen += pevpn->prefixlen;
 			plen += pevpn->labellen * 8;
-			if (ibuf_add_n8(tmp, PREFIX_SIZE(plen) - 1) == -1)
+			if (ibuf_add_n8(buf, PREFIX_SIZE(plen) - 1) == -1)
 				goto fail;
-			if (ibuf_add_h64(tmp, pevpn->rd) == -1 ||
-			    ibuf_add(tmp, pevpn->esi,
+			if (ibuf_add_h64(buf, pevpn->rd) == -1 ||
+			    ibuf_add(buf, pevpn->esi,
 			    sizeof(pevpn->esi)) == -1 ||
-			    ibuf_add_h32(tmp, pevpn->ethtag) == -1)
+			    ibuf_add_h32(buf, pevpn->ethtag) == -1)
 				goto fail;
-			if (ibuf_add_n8(tmp, sizeof(pevpn->mac) * 8) == -1 ||
-			    ibuf_add(tmp, pevpn->mac, sizeof(pevpn->mac)) == -1)
+			if (ibuf_add_n8(buf, sizeof(pevpn->mac) * 8) == -1 ||
+			    ibuf_add(buf, pevpn->mac, sizeof(pevpn->mac)) == -1)
 				goto fail;
-			if (ibuf_add_n8(tmp, pevpn->prefixlen) == -1)
+			if (ibuf_add_n8(buf, pevpn->prefixlen) == -1)
 				goto fail;
 			switch (pevpn->vpnaid) {
 			case AID_UNSPEC:
 				/* See rfc7432 section 7.2 */
 				break;
 			case AID_INET:
-				if (ibuf_add(tmp, &pevpn->prefix4,
+				if (ibuf_add(buf, &pevpn->prefix4,
 				    sizeof(pevpn->prefix4)) == -1)
 					goto fail;
 				break;
 			case AID_INET6:
-				if (ibuf_add(tmp, &pevpn->prefix6,
+				if (ibuf_add(buf, &pevpn->prefix6,
 				sizeof(pevpn->prefix6)) == -1)
 					goto fail;
 				break;
 			default:
 				goto fail;
 			}
-			if (ibuf_add(tmp, pevpn->labelstack,
+			if (ibuf_add(buf, pevpn->labelstack,
 			    pevpn->labellen) == -1)
 				goto fail;
 			break;
@@ -802,21 +825,21 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 			plen += sizeof(pevpn->ethtag) * 8;
 			plen += 8;	/* IP length */
 			plen += pevpn->prefixlen;
-			if (ibuf_add_n8(tmp, PREFIX_SIZE(plen) - 1) == -1)
+			if (ibuf_add_n8(buf, PREFIX_SIZE(plen) - 1) == -1)
 				goto fail;
-			if (ibuf_add_h64(tmp, pevpn->rd) == -1 ||
-			    ibuf_add_h32(tmp, pevpn->ethtag) == -1)
+			if (ibuf_add_h64(buf, pevpn->rd) == -1 ||
+			    ibuf_add_h32(buf, pevpn->ethtag) == -1)
 				goto fail;
-			if (ibuf_add_n8(tmp, pevpn->prefixlen) == -1)
+			if (ibuf_add_n8(buf, pevpn->prefixlen) == -1)
 				goto fail;
 			switch (pevpn->vpnaid) {
 			case AID_INET:
-				if (ibuf_add(tmp, &pevpn->prefix4,
+				if (ibuf_add(buf, &pevpn->prefix4,
 				    sizeof(pevpn->prefix4)) == -1)
 					goto fail;
 				break;
 			case AID_INET6:
-				if (ibuf_add(tmp, &pevpn->prefix6,
+				if (ibuf_add(buf, &pevpn->prefix6,
 				    sizeof(pevpn->prefix6)) == -1)
 					goto fail;
 				break;
@@ -829,14 +852,14 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 	case AID_FLOWSPECv6:
 		flowlen = pflow->len - PT_FLOW_SIZE;
 		if (flowlen < FLOWSPEC_LEN_LIMIT) {
-			if (ibuf_add_n8(tmp, flowlen) == -1)
+			if (ibuf_add_n8(buf, flowlen) == -1)
 				goto fail;
 		} else {
-			if (ibuf_add_n8(tmp, 0xf0 | (flowlen >> 8)) == -1 ||
-			    ibuf_add_n8(tmp, flowlen) == -1)
+			if (ibuf_add_n8(buf, 0xf0 | (flowlen >> 8)) == -1 ||
+			    ibuf_add_n8(buf, flowlen) == -1)
 				goto fail;
 		}
-		if (ibuf_add(tmp, &pflow->flow, flowlen) == -1)
+		if (ibuf_add(buf, &pflow->flow, flowlen) == -1)
 			goto fail;
 		break;
 	default:
@@ -844,14 +867,11 @@ pt_writebuf(struct ibuf *buf, struct pt_entry *pte, int withdraw,
 	}
 
 	/* keep 2 bytes reserved in the withdraw case for IPv4 encoding */
-	if (withdraw && ibuf_left(buf) < ibuf_size(tmp) + 2)
-		goto fail;
-	if (ibuf_add_ibuf(buf, tmp) == -1)
+	if (withdraw && ibuf_left(buf) < 2)
 		goto fail;
-	ibuf_free(tmp);
 	return 0;
 
  fail:
-	ibuf_free(tmp);
+	ibuf_truncate(buf, off);
 	return -1;
 }
@@ -520,31 +520,40 @@ rib_dump_pending(void)
 	return 0;
 }
 
+/*
+ * Run the pending rib dumps for at most budget microseconds.
+ * If all dumps got a turn and there is time left start another round.
+ */
 void
-rib_dump_runner(void)
+rib_dump_runner(long long budget)
 {
 	struct rib_context *ctx, *next;
 	monotime_t start;
 
 	start = getmonotime();
 
-	if (rib_dump_ctx != NULL)
-		ctx = rib_dump_ctx;
-	else
-		ctx = LIST_FIRST(&rib_dumps);
-
-	for (; ctx != NULL; ctx = next) {
-		next = LIST_NEXT(ctx, entry);
-		if (monotime_to_msec(monotime_sub(getmonotime(), start)) > 10)
-			break;
-		if (ctx->ctx_throttle && ctx->ctx_throttle(ctx->ctx_arg))
-			continue;
-		if (ctx->ctx_rib_call != NULL)
-			rib_dump_r(ctx);
+	do {
+		if (rib_dump_ctx != NULL)
+			ctx = rib_dump_ctx;
 		else
-			adjout_prefix_dump_r(ctx);
-	}
-	rib_dump_ctx = ctx;
+			ctx = LIST_FIRST(&rib_dumps);
+
+		for (; ctx != NULL; ctx = next) {
+			next = LIST_NEXT(ctx, entry);
+			if (monotime_to_usec(monotime_sub(getmonotime(),
+			    start)) > budget)
+				break;
+			if (ctx->ctx_throttle &&
+			    ctx->ctx_throttle(ctx->ctx_arg))
+				continue;
+			if (ctx->ctx_rib_call != NULL)
+				rib_dump_r(ctx);
+			else
+				adjout_prefix_dump_r(ctx);
+		}
+		rib_dump_ctx = ctx;
+	} while (ctx == NULL && rib_dump_pending() &&
+	    monotime_to_usec(monotime_sub(getmonotime(), start)) <= budget);
 }
 
 static void
@@ -1330,33 +1339,37 @@ nexthop_pending(void)
 	return !TAILQ_EMPTY(&nexthop_runners);
 }
 
+/*
+ * Reevaluate up to count prefixes of the queued nexthops. Each nexthop
+ * is processed for at most RDE_RUNNER_ROUNDS prefixes before the next
+ * one in the queue gets its turn.
+ */
 void
-nexthop_runner(void)
+nexthop_runner(unsigned int count)
 {
 	struct nexthop *nh;
 	struct prefix *p;
 	uint32_t j;
 
-	nh = TAILQ_FIRST(&nexthop_runners);
-	if (nh == NULL)
-		return;
+	while (count > 0 && (nh = TAILQ_FIRST(&nexthop_runners)) != NULL) {
+		/* remove from runnner queue */
+		TAILQ_REMOVE(&nexthop_runners, nh, runner_l);
 
-	/* remove from runnner queue */
-	TAILQ_REMOVE(&nexthop_runners, nh, runner_l);
+		p = nh->next_prefix;
+		for (j = 0; p != NULL && j < RDE_RUNNER_ROUNDS && count > 0;
+		    j++, count--) {
+			prefix_evaluate_nexthop(p, nh->state, nh->oldstate);
+			p = LIST_NEXT(p, nexthop_l);
+		}
 
-	p = nh->next_prefix;
-	for (j = 0; p != NULL && j < RDE_RUNNER_ROUNDS; j++) {
-		prefix_evaluate_nexthop(p, nh->state, nh->oldstate);
-		p = LIST_NEXT(p, nexthop_l);
+		/* prep for next run, if not finished readd to tail of queue */
+		nh->next_prefix = p;
+		if (p != NULL)
+			TAILQ_INSERT_TAIL(&nexthop_runners, nh, runner_l);
+		else
+			log_debug("nexthop %s update finished",
+			    log_addr(&nh->exit_nexthop));
 	}
-
-	/* prep for next run, if not finished readd to tail of queue */
-	nh->next_prefix = p;
-	if (p != NULL)
-		TAILQ_INSERT_TAIL(&nexthop_runners, nh, runner_l);
-	else
-		log_debug("nexthop %s update finished",
-		    log_addr(&nh->exit_nexthop));
 }
 
 void
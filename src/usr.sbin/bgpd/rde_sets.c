@@ -215,6 +215,56 @@ set_match(const struct set_table *a, uint32_t asnum)
 	return bsearch(&asnum, a->set, a->nmemb, a->size, set_cmp);
 }
 
+/*
+ * Insert a single element into a prepared set and keep the set sorted.
+ * Returns 1 if the element is already part of the set.
+ */
+int
+set_insert(struct set_table *set, void *elm)
+{
+	uint8_t	*s;
+	size_t	 lo = 0, hi = set->nmemb, mid;
+	int	 c;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		c = set_cmp(elm, (uint8_t *)set->set + mid * set->size);
+		if (c == 0)
+			return 1;
+		if (c > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* append to grow the table, then move the element into place */
+	if (set_add(set, elm, 1) != 0)
+		return -1;
+	s = set->set;
+	memmove(s + (lo + 1) * set->size, s + lo * set->size,
+	    (set->nmemb - 1 - lo) * set->size);
+	memcpy(s + lo * set->size, elm, set->size);
+	return 0;
+}
+
+/*
+ * Remove asnum from a prepared set.
+ * Returns 1 if the element is not part of the set.
+ */
+int
+set_delete(struct set_table *set, uint32_t asnum)
+{
+	uint8_t	*s, *e;
+
+	if ((e = set_match(set, asnum)) == NULL)
+		return 1;
+	s = set->set;
+	memmove(e, e + set->size, s + set->nmemb * set->size - e - set->size);
+	set->nmemb--;
+	rdemem.aset_nmemb--;
+	return 0;
+}
+
 int
 set_equal(const struct set_table *a, const struct set_table *b)
 {
@@ -50,15 +50,24 @@
  * To only match the prefix itself min and max are set to plen.
  * If a same prefix (addr/plen) is added to the trie but with different
  * min & max values then the masks of both nodes are merged with a binary OR.
+ * Every node also keeps the list of min & max ranges added to it, so that
+ * on removal of one range the mask can be rebuilt from the remaining ones.
  * The match function returns true the moment the first node is found which
  * covers the looked up prefix and where the prefixlen mask matches for the
  * looked up prefixlen. The moment the plen of a node is bigger than the
  * prefixlen of the looked up prefix the search can be stopped since
  * there will be no match.
  */
+struct trie_range {
+	uint8_t			 min;
+	uint8_t			 max;
+};
+
 struct tentry_v4 {
 	struct tentry_v4	*trie[2];
 	struct set_table	*set;	/* for roa source-as set */
+	struct trie_range	*ranges;
+	uint32_t		 nranges;
 	struct in_addr		 addr;
 	struct in_addr		 plenmask;
 	uint8_t			 plen;
@@ -68,6 +77,8 @@ struct tentry_v4 {
 struct tentry_v6 {
 	struct tentry_v6	*trie[2];
 	struct set_table	*set;	/* for roa source-as set */
+	struct trie_range	*ranges;
+	uint32_t		 nranges;
 	struct in6_addr		 addr;
 	struct in6_addr		 plenmask;
 	uint8_t			 plen;
@@ -142,6 +153,52 @@ inet6setbit(struct in6_addr *addr, uint8_t bit)
 	addr->s6_addr[bit / 8] |= (0x80 >> (bit % 8));
 }
 
+/*
+ * Remember the prefixlen range min - max in the range list of a node.
+ */
+static int
+trie_range_add(struct trie_range **ranges, uint32_t *nranges, uint8_t min,
+    uint8_t max)
+{
+	struct trie_range *r;
+
+	r = reallocarray(*ranges, *nranges + 1, sizeof(*r));
+	if (r == NULL)
+		return -1;
+	r[*nranges].min = min;
+	r[*nranges].max = max;
+	*ranges = r;
+	(*nranges)++;
+	rdemem.pset_size += sizeof(*r);
+	return 0;
+}
+
+/*
+ * Remove one instance of the prefixlen range min - max from the range list.
+ * Return 0 if the range was found, -1 otherwise.
+ */
+static int
+trie_range_del(struct trie_range **ranges, uint32_t *nranges, uint8_t min,
+    uint8_t max)
+{
+	struct trie_range *r = *ranges;
+	uint32_t i;
+
+	for (i = 0; i < *nranges; i++)
+		if (r[i].min == min && r[i].max == max)
+			break;
+	if (i == *nranges)
+		return -1;
+
+	r[i] = r[--(*nranges)];
+	rdemem.pset_size -= sizeof(*r);
+	if (*nranges == 0) {
+		free(r);
+		*ranges = NULL;
+	}
+	return 0;
+}
+
 static struct tentry_v4 *
 trie_add_v4(struct trie_head *th, struct in_addr *prefix, uint8_t plen)
 {
@@ -320,24 +377,26 @@ trie_add(struct trie_head *th, struct bgpd_addr *prefix, uint8_t plen,
 {
 	struct tentry_v4 *n4;
 	struct tentry_v6 *n6;
-	uint8_t i;
+	uint8_t i, omin = min;
 
 	/* precondition plen <= min <= max */
 	if (plen > min || min > max)
 		return -1;
 	if (prefix->aid != AID_INET && prefix->aid != AID_INET6)
 		return -1;
+	if (max > (prefix->aid == AID_INET ? 32 : 128))
+		return -1;
 
 	/*
 	 * Check for default route, this is special cased since prefixlen 0
 	 * can't be checked in the prefixlen mask plenmask.  Also there is
-	 * only one default route so using a flag for this works.
+	 * only one default route so counting the entries covering it works.
 	 */
 	if (min == 0) {
 		if (prefix->aid == AID_INET)
-			th->match_default_v4 = 1;
+			th->match_default_v4++;
 		else
-			th->match_default_v6 = 1;
+			th->match_default_v6++;
 
 		if (max == 0)	/* just the default route */
 			return 0;
@@ -346,12 +405,11 @@ trie_add(struct trie_head *th, struct bgpd_addr *prefix, uint8_t plen,
 
 	switch (prefix->aid) {
 	case AID_INET:
-		if (max > 32)
-			return -1;
-
 		n4 = trie_add_v4(th, &prefix->v4, plen);
 		if (n4 == NULL)
 			return -1;
+		if (trie_range_add(&n4->ranges, &n4->nranges, omin, max) == -1)
+			return -1;
 		/*
 		 * The prefixlen min - max goes from 1 to 32 but the bitmask
 		 * starts at 0 and so all bits are set with an offset of -1.
@@ -361,12 +419,11 @@ trie_add(struct trie_head *th, struct bgpd_addr *prefix, uint8_t plen,
 			inet4setbit(&n4->plenmask, i - 1);
 		break;
 	case AID_INET6:
-		if (max > 128)
-			return -1;
-
 		n6 = trie_add_v6(th, &prefix->v6, plen);
 		if (n6 == NULL)
 			return -1;
+		if (trie_range_add(&n6->ranges, &n6->nranges, omin, max) == -1)
+			return -1;
 
 		/* See above for the - 1 reason. */
 		for (i = min; i <= max; i++)
@@ -376,6 +433,202 @@ trie_add(struct trie_head *th, struct bgpd_addr *prefix, uint8_t plen,
 	return 0;
 }
 
+/*
+ * Remove node n linked via prev if it is no longer needed. Only nodes
+ * with less than two children can be removed, the remaining child
+ * takes the place of n.
+ */
+static int
+trie_unlink_v4(struct tentry_v4 **prev, struct tentry_v4 *n)
+{
+	if (n->node || (n->trie[0] != NULL && n->trie[1] != NULL))
+		return 0;
+	*prev = n->trie[0] != NULL ? n->trie[0] : n->trie[1];
+	set_free(n->set);
+	free(n);
+	rdemem.pset_cnt--;
+	rdemem.pset_size -= sizeof(*n);
+	return 1;
+}
+
+static int
+trie_unlink_v6(struct tentry_v6 **prev, struct tentry_v6 *n)
+{
+	if (n->node || (n->trie[0] != NULL && n->trie[1] != NULL))
+		return 0;
+	*prev = n->trie[0] != NULL ? n->trie[0] : n->trie[1];
+	set_free(n->set);
+	free(n);
+	rdemem.pset_cnt--;
+	rdemem.pset_size -= sizeof(*n);
+	return 1;
+}
+
+static int
+trie_del_v4(struct trie_head *th, struct in_addr *prefix, uint8_t plen,
+    uint8_t min, uint8_t max)
+{
+	struct tentry_v4 *n, *parent = NULL, **prev, **pprev = NULL;
+	struct in_addr p, mp;
+	uint32_t r;
+	uint8_t i;
+
+	inet4applymask(&p, prefix, plen);
+
+	prev = &th->root_v4;
+	while ((n = *prev) != NULL) {
+		if (n->plen > plen)
+			return -1;	/* not in the trie */
+		inet4applymask(&mp, &p, n->plen);
+		if (n->addr.s_addr != mp.s_addr)
+			return -1;	/* off path, not in the trie */
+		if (n->plen == plen)
+			break;
+		pprev = prev;
+		parent = n;
+		if (inet4isset(&p, n->plen))
+			prev = &n->trie[1];
+		else
+			prev = &n->trie[0];
+	}
+	if (n == NULL || n->node == 0)
+		return -1;
+	if (trie_range_del(&n->ranges, &n->nranges, min, max) == -1)
+		return -1;
+
+	/* other ranges may cover the same prefixlen, rebuild the mask */
+	n->plenmask.s_addr = 0;
+	for (r = 0; r < n->nranges; r++) {
+		/* prefixlen 0 is the default route, see trie_add() */
+		i = n->ranges[r].min == 0 ? 1 : n->ranges[r].min;
+		for (; i <= n->ranges[r].max; i++)
+			inet4setbit(&n->plenmask, i - 1);
+	}
+	if (n->nranges != 0)
+		return 0;
+
+	/* no prefixlen left, turn n into a branch node or remove it */
+	n->node = 0;
+	th->v4_cnt--;
+	if (trie_unlink_v4(prev, n) && parent != NULL)
+		trie_unlink_v4(pprev, parent);
+	return 0;
+}
+
+static int
+trie_del_v6(struct trie_head *th, struct in6_addr *prefix, uint8_t plen,
+    uint8_t min, uint8_t max)
+{
+	struct tentry_v6 *n, *parent = NULL, **prev, **pprev = NULL;
+	struct in6_addr p, mp;
+	uint32_t r;
+	uint8_t i;
+
+	inet6applymask(&p, prefix, plen);
+
+	prev = &th->root_v6;
+	while ((n = *prev) != NULL) {
+		if (n->plen > plen)
+			return -1;	/* not in the trie */
+		inet6applymask(&mp, &p, n->plen);
+		if (memcmp(&n->addr, &mp, sizeof(mp)) != 0)
+			return -1;	/* off path, not in the trie */
+		if (n->plen == plen)
+			break;
+		pprev = prev;
+		parent = n;
+		if (inet6isset(&p, n->plen))
+			prev = &n->trie[1];
+		else
+			prev = &n->trie[0];
+	}
+	if (n == NULL || n->node == 0)
+		return -1;
+	if (trie_range_del(&n->ranges, &n->nranges, min, max) == -1)
+		return -1;
+
+	/* other ranges may cover the same prefixlen, rebuild the mask */
+	memset(&n->plenmask, 0, sizeof(n->plenmask));
+	for (r = 0; r < n->nranges; r++) {
+		/* prefixlen 0 is the default route, see trie_add() */
+		i = n->ranges[r].min == 0 ? 1 : n->ranges[r].min;
+		for (; i <= n->ranges[r].max; i++)
+			inet6setbit(&n->plenmask, i - 1);
+	}
+	if (n->nranges != 0)
+		return 0;
+
+	/* no prefixlen left, turn n into a branch node or remove it */
+	n->node = 0;
+	th->v6_cnt--;
+	if (trie_unlink_v6(prev, n) && parent != NULL)
+		trie_unlink_v6(pprev, parent);
+	return 0;
+}
+
+/*
+ * Remove the prefixlen range min - max of prefix/plen from the trie.
+ * This is the reverse of trie_add(), only a range added before with
+ * the same min and max is removed. Ranges of other entries on the
+ * same prefix stay and nodes which no longer cover any prefixlen are
+ * removed. Returns 1 if the range is not part of the trie.
+ */
+int
+trie_del(struct trie_head *th, struct bgpd_addr *prefix, uint8_t plen,
+    uint8_t min, uint8_t max)
+{
+	struct trie_range *ranges = NULL;
+	uint32_t i, nranges = 0, ndefault = 0;
+	int *match_default;
+	int r;
+
+	/* precondition plen <= min <= max */
+	if (plen > min || min > max)
+		return -1;
+	if (prefix->aid != AID_INET && prefix->aid != AID_INET6)
+		return -1;
+	if (max > (prefix->aid == AID_INET ? 32 : 128))
+		return -1;
+
+	if (prefix->aid == AID_INET)
+		match_default = &th->match_default_v4;
+	else
+		match_default = &th->match_default_v6;
+
+	if (min == 0 && max == 0) {
+		/*
+		 * Just the default route. match_default also counts the
+		 * ranges starting at 0, those are on the /0 node.
+		 */
+		if (prefix->aid == AID_INET && th->root_v4 != NULL &&
+		    th->root_v4->plen == 0) {
+			ranges = th->root_v4->ranges;
+			nranges = th->root_v4->nranges;
+		} else if (prefix->aid == AID_INET6 && th->root_v6 != NULL &&
+		    th->root_v6->plen == 0) {
+			ranges = th->root_v6->ranges;
+			nranges = th->root_v6->nranges;
+		}
+		for (i = 0; i < nranges; i++)
+			if (ranges[i].min == 0)
+				ndefault++;
+		if (*match_default <= (int)ndefault)
+			return 1;
+		(*match_default)--;
+		return 0;
+	}
+
+	if (prefix->aid == AID_INET)
+		r = trie_del_v4(th, &prefix->v4, plen, min, max);
+	else
+		r = trie_del_v6(th, &prefix->v6, plen, min, max);
+	if (r == -1)
+		return 1;
+	if (min == 0)
+		(*match_default)--;
+	return 0;
+}
+
 /*
  * Insert a ROA entry for prefix/plen. The prefix will insert a set with
  * source_as and the maxlen as data. This makes it possible to validate if a
@@ -446,6 +699,8 @@ trie_free_v4(struct tentry_v4 *n)
 	trie_free_v4(n->trie[0]);
 	trie_free_v4(n->trie[1]);
 	set_free(n->set);
+	free(n->ranges);
+	rdemem.pset_size -= n->nranges * sizeof(*n->ranges);
 	free(n);
 	rdemem.pset_cnt--;
 	rdemem.pset_size -= sizeof(*n);
@@ -459,6 +714,8 @@ trie_free_v6(struct tentry_v6 *n)
 	trie_free_v6(n->trie[0]);
 	trie_free_v6(n->trie[1]);
 	set_free(n->set);
+	free(n->ranges);
+	rdemem.pset_size -= n->nranges * sizeof(*n->ranges);
 	free(n);
 	rdemem.pset_cnt--;
 	rdemem.pset_size -= sizeof(*n);
@@ -739,8 +996,9 @@ trie_equal_v6(struct tentry_v6 *a, struct tentry_v6 *b)
 int
 trie_equal(struct trie_head *a, struct trie_head *b)
 {
-	if (a->match_default_v4 != b->match_default_v4 ||
-	    a->match_default_v6 != b->match_default_v6)
+	/* the default route flags count entries, only compare the match */
+	if ((a->match_default_v4 != 0) != (b->match_default_v4 != 0) ||
+	    (a->match_default_v6 != 0) != (b->match_default_v6 != 0))
 		return 0;
 	if (trie_equal_v4(a->root_v4, b->root_v4) == 0)
 		return 0;
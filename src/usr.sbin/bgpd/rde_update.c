@@ -264,6 +264,12 @@ done:
 		adjout_prefix_withdraw(peer, re->prefix, p, mode == EVAL_SYNC);
 }
 
+/* paths sent to a peer before an add-path update, see up_generate_addpath() */
+struct addpath_sent {
+	uint32_t	path_id_tx;
+	int		stale;
+};
+
 /*
  * Generate updates for the add-path send case. Depending on the
  * peer eval settings prefixes are selected and distributed.
@@ -275,20 +281,34 @@ void
 up_generate_addpath(struct rde_peer *peer, struct rib_entry *re,
     enum eval_mode mode)
 {
+	static struct addpath_sent	*addpath_prefix_list;
+	static unsigned int		 addpath_prefix_size;
+	struct addpath_sent	*list;
 	struct prefix		*new;
 	struct adjout_prefix	*head, *p;
-	uint32_t		addpath_prefix_list[2000];	/* XXX */
 	int			maxpaths = 0, extrapaths = 0, extra;
 	int			checkmode = 1;
-	unsigned int		pidx = 0, i;
+	unsigned int		pidx = 0, i, lo, hi;
 
-	/* collect all current paths */
+	/*
+	 * collect all current paths, the list is sorted by path_id_tx
+	 * and grows as needed.
+	 */
 	head = adjout_prefix_first(re->prefix, peer->adjout_bid);
 	for (p = head; p != NULL;
 	    p = adjout_prefix_next(re->prefix, peer->adjout_bid, p)) {
-		addpath_prefix_list[pidx++] = p->path_id_tx;
-		if (pidx >= nitems(addpath_prefix_list))
-			fatalx("too many addpath paths to select from");
+		if (pidx >= addpath_prefix_size) {
+			if ((list = recallocarray(addpath_prefix_list,
+			    addpath_prefix_size, addpath_prefix_size + 64,
+			    sizeof(*list))) == NULL)
+				fatal(__func__);
+			addpath_prefix_list = list;
+			addpath_prefix_size += 64;
+		}
+		addpath_prefix_list[pidx].path_id_tx = p->path_id_tx;
+		/* path_id_tx 0 is not an add-path path, leave it alone */
+		addpath_prefix_list[pidx].stale = p->path_id_tx != 0;
+		pidx++;
 	}
 
 	/* update paths */
@@ -338,12 +358,19 @@ up_generate_addpath(struct rde_peer *peer, struct rib_entry *re,
 		case UP_OK:
 			maxpaths++;
 			extrapaths += extra;
-			for (i = 0; i < pidx; i++) {
-				if (addpath_prefix_list[i] == new->path_id_tx) {
-					addpath_prefix_list[i] = 0;
-					break;
-				}
+			/* path is still sent, remove it from the stale list */
+			for (lo = 0, hi = pidx; lo < hi; ) {
+				i = lo + (hi - lo) / 2;
+				if (addpath_prefix_list[i].path_id_tx <
+				    new->path_id_tx)
+					lo = i + 1;
+				else
+					hi = i;
 			}
+			if (lo < pidx &&
+			    addpath_prefix_list[lo].path_id_tx ==
+			    new->path_id_tx)
+				addpath_prefix_list[lo].stale = 0;
 			break;
 		case UP_FILTERED:
 		case UP_EXCLUDED:
@@ -361,9 +388,9 @@ up_generate_addpath(struct rde_peer *peer, struct rib_entry *re,
 
 	/* withdraw stale paths */
 	for (i = 0; i < pidx; i++) {
-		if (addpath_prefix_list[i] != 0) {
-			p = adjout_prefix_get(peer, addpath_prefix_list[i],
-			    re->prefix);
+		if (addpath_prefix_list[i].stale) {
+			p = adjout_prefix_get(peer,
+			    addpath_prefix_list[i].path_id_tx, re->prefix);
 			if (p != NULL)
 				adjout_prefix_withdraw(peer, re->prefix, p,
 				    mode == EVAL_SYNC);
@@ -604,9 +631,11 @@ up_generate_attr(struct ibuf *buf, struct rde_peer *peer,
     struct rde_aspath *asp, struct rde_community *comm, struct nexthop *nh,
     uint8_t aid)
 {
-	struct attr	*oa = NULL, *newaggr = NULL;
+	struct attr	*oa = NULL, *newaggr = NULL, *a;
+	struct attr	*opq = NULL, *op = NULL, opqattr;
 	u_char		*pdata;
 	uint32_t	 tmp32;
+	size_t		 opqoff = 0;
 	unsigned int	 oalen = 0;
 	int		 flags, neednewpath = 0, rv;
 	uint16_t	 plen;
@@ -615,6 +644,13 @@ up_generate_attr(struct ibuf *buf, struct rde_peer *peer,
 	if (asp->others_len > 0)
 		oa = asp->others[oalen++];
 
+	/* the packed unknown attributes are merged in by type */
+	if (oa != NULL && oa->type == ATTR_OPAQUE) {
+		opq = oa;
+		if (attr_opaque_next(opq, &opqoff, &opqattr))
+			op = &opqattr;
+	}
+
 	/* dump attributes in ascending order */
 	for (type = ATTR_ORIGIN; type < 255; type++) {
 		while (oa && oa->type < type) {
@@ -623,6 +659,10 @@ up_generate_attr(struct ibuf *buf, struct rde_peer *peer,
 			else
 				oa = NULL;
 		}
+		while (op && op->type < type) {
+			if (!attr_opaque_next(opq, &opqoff, &opqattr))
+				op = NULL;
+		}
 
 		switch (type) {
 		/*
@@ -801,14 +841,19 @@ up_generate_attr(struct ibuf *buf, struct rde_peer *peer,
 				return -1;
 			break;
 		default:
-			if (oa == NULL && type >= ATTR_FIRST_UNKNOWN)
+			if (oa == NULL && op == NULL &&
+			    type >= ATTR_FIRST_UNKNOWN)
 				/* there is no attribute left to dump */
 				return (0);
 
-			if (oa == NULL || oa->type != type)
+			if (op != NULL && op->type == type)
+				a = op;
+			else if (oa != NULL && oa->type == type)
+				a = oa;
+			else
 				break;
 			/* unknown attribute */
-			if (!(oa->flags & ATTR_TRANSITIVE)) {
+			if (!(a->flags & ATTR_TRANSITIVE)) {
 				/*
 				 * RFC 1771:
 				 * Unrecognized non-transitive optional
@@ -817,14 +862,62 @@ up_generate_attr(struct ibuf *buf, struct rde_peer *peer,
 				 */
 				break;
 			}
-			if (attr_writebuf(buf, oa->flags | ATTR_PARTIAL,
-			    oa->type, oa->data, oa->len) == -1)
+			if (attr_writebuf(buf, a->flags | ATTR_PARTIAL,
+			    a->type, a->data, a->len) == -1)
 				return -1;
 		}
 	}
 	return 0;
 }
 
+/*
+ * The path attributes written by up_generate_attr() depend only on these
+ * properties of the peer.
+ */
+static uint8_t
+up_encoding_class(struct rde_peer *peer, uint8_t aid)
+{
+	uint8_t class = 0;
+
+	if (peer_has_as4byte(peer))
+		class |= ADJOUT_ENC_AS4BYTE;
+	if (peer->conf.ebgp)
+		class |= ADJOUT_ENC_EBGP;
+	if (peer->flags & PEERFLAG_TRANS_AS)
+		class |= ADJOUT_ENC_TRANS_AS;
+	if (aid == AID_INET) {
+		class |= ADJOUT_ENC_INET;
+		if (peer_has_ext_nexthop(peer, AID_INET))
+			class |= ADJOUT_ENC_EXT_NH;
+	}
+	return class;
+}
+
+/*
+ * Write the path attributes of attrs, use the cached encoding if there is
+ * one for this peer. Else generate them and cache the result.
+ */
+static int
+up_generate_attr_cached(struct ibuf *buf, struct rde_peer *peer,
+    struct adjout_attr *attrs, uint8_t aid)
+{
+	struct adjout_attr_enc	*enc;
+	size_t			 off, len;
+	uint8_t			 class;
+
+	class = up_encoding_class(peer, aid);
+	if ((enc = adjout_attr_enc_get(attrs, class)) != NULL)
+		return ibuf_add(buf, enc->data, enc->len);
+
+	off = ibuf_size(buf);
+	if (up_generate_attr(buf, peer, attrs->aspath, attrs->communities,
+	    attrs->nexthop, aid) == -1)
+		return -1;
+	len = ibuf_size(buf) - off;
+	adjout_attr_enc_add(attrs, class, ibuf_seek(buf, off, len), len);
+	return 0;
+}
+
 /*
  * Check if the pending element is a EoR marker. If so remove it from the
  * tree and return 1.
@@ -855,24 +948,27 @@ up_dump_prefix(struct ibuf *buf, struct pend_prefix_queue *prefix_head,
     struct rde_peer *peer, int withdraw)
 {
 	struct pend_prefix	*p, *np;
-	int			 has_ap = -1, rv = -1;
+	uint64_t		 n = 0;
+	int			 has_ap;
 
+	if ((p = TAILQ_FIRST(prefix_head)) == NULL)
+		return -1;
+	has_ap = peer_has_add_path(peer, p->pt->aid, CAPA_AP_SEND);
+
+	/* all prefixes are of the same aid, pt_writebuf() does the rest */
 	TAILQ_FOREACH_SAFE(p, prefix_head, entry, np) {
-		if (has_ap == -1)
-			has_ap = peer_has_add_path(peer, p->pt->aid,
-			    CAPA_AP_SEND);
 		if (pt_writebuf(buf, p->pt, withdraw, has_ap, p->path_id_tx) ==
 		    -1)
 			break;
-
-		rv = 0;
-		if (withdraw)
-			peer->stats.prefix_sent_withdraw++;
-		else
-			peer->stats.prefix_sent_update++;
 		pend_prefix_free(p, prefix_head, peer);
+		n++;
 	}
-	return rv;
+
+	if (withdraw)
+		peer->stats.prefix_sent_withdraw += n;
+	else
+		peer->stats.prefix_sent_update += n;
+	return n == 0 ? -1 : 0;
 }
 
 static int
@@ -1175,6 +1271,8 @@ up_dump_update(struct imsgbuf *imsg, struct rde_peer *peer, uint8_t aid)
 	if (pa == NULL)
 		return;
 
+	RDE_TRACE(up_dump_update, peer->conf.id);
+
 	if (aid == AID_INET && peer_has_ext_nexthop(peer, AID_INET)) {
 		struct nexthop *nh = pa->attrs->nexthop;
 		if (nh != NULL && nh->exit_nexthop.aid == AID_INET6)
@@ -1199,8 +1297,7 @@ up_dump_update(struct imsgbuf *imsg, struct rde_peer *peer, uint8_t aid)
 	if (ibuf_add_zero(buf, sizeof(len)) == -1)
 		goto fail;
 
-	if (up_generate_attr(buf, peer, pa->attrs->aspath,
-	    pa->attrs->communities, pa->attrs->nexthop, aid) == -1)
+	if (up_generate_attr_cached(buf, peer, pa->attrs, aid) == -1)
 		goto drop;
 
 	if (aid != AID_INET || force_ip4mp) {
@@ -316,6 +316,7 @@ rtr_dispatch_imsg_parent(struct imsgbuf *imsgbuf)
 {
 	static struct aspa_set	*aspa;
 	struct imsg		 imsg;
+	struct ibuf		 ibuf;
 	struct roa		 roa;
 	struct rtr_config_msg	 rtrconf;
 	struct rtr_session	*rs;
@@ -370,9 +371,15 @@ rtr_dispatch_imsg_parent(struct imsgbuf *imsgbuf)
 			rtr_config_prep();
 			break;
 		case IMSG_RECONF_ROA_ITEM:
-			if (imsg_get_data(&imsg, &roa, sizeof(roa)) == -1)
-				fatal("imsg_get_data");
-			rtr_roa_insert(&nconf->roa, &roa);
+			/* batch of roas */
+			if (imsg_get_ibuf(&imsg, &ibuf) == -1 ||
+			    ibuf_size(&ibuf) % sizeof(roa) != 0)
+				fatalx("IMSG_RECONF_ROA_ITEM bad len");
+			while (ibuf_size(&ibuf) > 0) {
+				if (ibuf_get(&ibuf, &roa, sizeof(roa)) == -1)
+					fatal("ibuf_get");
+				rtr_roa_insert(&nconf->roa, &roa);
+			}
 			break;
 		case IMSG_RECONF_ASPA:
 			if (aspa != NULL)
@@ -511,6 +518,7 @@ rtr_recalc(void)
 	struct roa *roa, *nr;
 	struct aspa_set *aspa;
 	struct aspa_prep ap = { 0 };
+	struct ibuf *batch = NULL;
 
 	if (rtr_recalc_semaphore > 0)
 		return;
@@ -524,9 +532,11 @@ rtr_recalc(void)
 
 	imsg_compose(ibuf_rde, IMSG_RECONF_ROA_SET, 0, 0, -1, NULL, 0);
 	RB_FOREACH_SAFE(roa, roa_tree, &rt, nr) {
-		imsg_compose(ibuf_rde, IMSG_RECONF_ROA_ITEM, 0, 0, -1,
-		    roa, sizeof(*roa));
+		if (imsg_batch_add(ibuf_rde, &batch, IMSG_RECONF_ROA_ITEM,
+		    roa, sizeof(*roa)) == -1)
+			fatal("%s: imsg_batch_add", __func__);
 	}
+	imsg_batch_close(ibuf_rde, &batch);
 	free_roatree(&rt);
 
 	RB_FOREACH(aspa, aspa_tree, &conf->aspa)
@@ -250,6 +250,7 @@ session_main(int debug, int verbose)
 					imsg_rde(IMSG_SESSION_DELETE,
 					    p->conf.id, NULL, 0);
 					msgbuf_free(p->wbuf);
+					ibufq_free(p->bulkq);
 					RB_REMOVE(peer_head, &conf->peers, p);
 					log_peer_warnx(&p->conf, "removed");
 					free(p);
@@ -347,6 +348,16 @@ session_main(int debug, int verbose)
 			if ((pt = timer_nextisdue(&p->timers, now)) != NULL) {
 				switch (pt->type) {
 				case Timer_Hold:
+					/*
+					 * Messages of this peer are still
+					 * queued, the peer is alive. Check
+					 * again after the backlog is processed.
+					 */
+					if (p->rpending) {
+						timer_set(&p->timers,
+						    Timer_Hold, 1);
+						break;
+					}
 					bgp_fsm(p, EVNT_TIMER_HOLDTIME, NULL);
 					break;
 				case Timer_SendHold:
@@ -403,18 +414,19 @@ session_main(int debug, int verbose)
 
 			/* check if peer needs throttling or not */
 			if (!p->throttled &&
-			    msgbuf_queuelen(p->wbuf) > SESS_MSG_HIGH_MARK) {
+			    session_queuelen(p) > SESS_MSG_HIGH_MARK) {
 				imsg_rde(IMSG_XOFF, p->conf.id, NULL, 0);
 				p->throttled = 1;
 			}
 			if (p->throttled &&
-			    msgbuf_queuelen(p->wbuf) < SESS_MSG_LOW_MARK) {
+			    session_queuelen(p) < SESS_MSG_LOW_MARK) {
 				imsg_rde(IMSG_XON, p->conf.id, NULL, 0);
 				p->throttled = 0;
 			}
 
 			/* are we waiting for a write? */
 			events = POLLIN;
+			session_bulk_refill(p);
 			if (msgbuf_queuelen(p->wbuf) > 0 ||
 			    p->state == STATE_CONNECT)
 				events |= POLLOUT;
@@ -574,6 +586,8 @@ init_peer(struct peer *p, struct bgpd_config *c)
 	if ((p->wbuf = msgbuf_new_reader(MSGSIZE_HEADER, parse_header, p)) ==
 	    NULL)
 		fatal(NULL);
+	if ((p->bulkq = ibufq_new()) == NULL)
+		fatal(NULL);
 
 	if (p->conf.if_depend[0])
 		imsg_compose(ibuf_main, IMSG_SESSION_DEPENDON, 0, 0, -1,
@@ -611,7 +625,7 @@ int
 session_dispatch_msg(struct pollfd *pfd, struct peer *p)
 {
 	socklen_t	len;
-	int		error;
+	int		error, i;
 
 	if (p->state == STATE_CONNECT) {
 		if (pfd->revents & POLLOUT) {
@@ -655,13 +669,26 @@ session_dispatch_msg(struct pollfd *pfd, struct peer *p)
 	}
 
 	if (pfd->revents & POLLOUT && msgbuf_queuelen(p->wbuf) > 0) {
-		if (ibuf_write(p->fd, p->wbuf) == -1) {
-			if (errno == EPIPE)
-				log_peer_warnx(&p->conf, "Connection closed");
-			else
-				log_peer_warn(&p->conf, "write error");
-			bgp_fsm(p, EVNT_CON_FATAL, NULL);
-			return (1);
+		/*
+		 * Each ibuf_write() does one writev() of the whole write
+		 * buffer. If the socket took everything refill and write
+		 * again to send large bursts in few rounds.
+		 */
+		for (i = 0; i < SESS_WRITE_ROUNDS; i++) {
+			session_bulk_refill(p);
+			if (msgbuf_queuelen(p->wbuf) == 0)
+				break;
+			if (ibuf_write(p->fd, p->wbuf) == -1) {
+				if (errno == EPIPE)
+					log_peer_warnx(&p->conf,
+					    "Connection closed");
+				else
+					log_peer_warn(&p->conf, "write error");
+				bgp_fsm(p, EVNT_CON_FATAL, NULL);
+				return (1);
+			}
+			if (msgbuf_queuelen(p->wbuf) != 0)
+				break;
 		}
 		p->stats.last_write = getmonotime();
 		start_timer_sendholdtime(p);
@@ -912,6 +939,17 @@ session_setup_socket(struct peer *p)
 	setsockopt(p->fd, SOL_SOCKET, SO_RCVBUF, &bsize, sizeof(bsize));
 	setsockopt(p->fd, SOL_SOCKET, SO_SNDBUF, &bsize, sizeof(bsize));
 
+#ifdef TCP_NOTSENT_LOWAT
+	/*
+	 * Keep unsent data in our queues instead of the socket buffer so
+	 * keepalives only wait behind a small amount of UPDATEs.
+	 * Also no biggie if it fails.
+	 */
+	bsize = SESS_NOTSENT_LOWAT;
+	setsockopt(p->fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bsize,
+	    sizeof(bsize));
+#endif
+
 	return (0);
 }
 
@@ -1021,11 +1059,39 @@ get_alternate_addr(struct bgpd_addr *local, struct bgpd_addr *remote,
 	freeifaddrs(ifap);
 }
 
+/*
+ * Pass the message verbatim to the rde. UPDATEs are batched per peer,
+ * each message is prefixed with its length. The batch is sent by
+ * session_update_flush() at the latest before any other imsg for the peer.
+ */
 void
 session_handle_update(struct peer *peer, struct ibuf *msg)
 {
-	/* pass the message verbatim to the rde. */
-	imsg_rde(IMSG_UPDATE, peer->conf.id, ibuf_data(msg), ibuf_size(msg));
+	size_t len = ibuf_size(msg);
+
+	if (ibuf_rde == NULL)
+		return;
+	if (peer->rbatch != NULL && ibuf_size(peer->rbatch) +
+	    sizeof(uint16_t) + len > UPDATE_BATCH_SIZE)
+		session_update_flush(peer);
+	if (peer->rbatch == NULL) {
+		peer->rbatch = imsg_create(ibuf_rde, IMSG_UPDATE,
+		    peer->conf.id, 0, MAX_PKTSIZE);
+		if (peer->rbatch == NULL)
+			fatal("imsg_create");
+	}
+	if (ibuf_add_n16(peer->rbatch, len) == -1 ||
+	    ibuf_add_ibuf(peer->rbatch, msg) == -1)
+		fatal("%s", __func__);
+}
+
+void
+session_update_flush(struct peer *peer)
+{
+	if (peer->rbatch == NULL)
+		return;
+	imsg_close(ibuf_rde, peer->rbatch);
+	peer->rbatch = NULL;
 }
 
 void
@@ -1632,6 +1698,7 @@ getpeerbyip(struct bgpd_config *c, struct sockaddr *ip)
 		newpeer->reconf_action = RECONF_KEEP;
 		newpeer->rpending = 0;
 		newpeer->wbuf = NULL;
+		newpeer->bulkq = NULL;
 		init_peer(newpeer, c);
 		/* start delete timer, it is stopped when session goes up. */
 		timer_set(&newpeer->timers, Timer_SessionDown,
@@ -1809,8 +1876,13 @@ imsg_ctl_rde_msg(int type, uint32_t peerid, pid_t pid)
 void
 imsg_rde(int type, uint32_t peerid, void *data, uint16_t datalen)
 {
+	struct peer *p;
+
 	if (ibuf_rde == NULL)
 		return;
+	/* keep the order with UPDATEs still in the batch */
+	if (peerid != 0 && (p = getpeerbyid(conf, peerid)) != NULL)
+		session_update_flush(p);
 	if (imsg_compose(ibuf_rde, type, peerid, 0, -1, data, datalen) == -1)
 		fatal("imsg_compose");
 }
@@ -38,6 +38,7 @@
 #define	MSGSIZE_RREFRESH		(MSGSIZE_HEADER + 4)
 #define	MSGSIZE_RREFRESH_MIN		MSGSIZE_RREFRESH
 #define	MSG_PROCESS_LIMIT		25
+#define	UPDATE_BATCH_SIZE		(64 * 1024)
 #define	SESSION_CLEAR_DELAY		5
 #define	PAUSEACCEPT_TIMEOUT		1
 
@@ -137,6 +138,10 @@ struct peer {
 	struct bgpd_addr	 remote;
 	struct timer_head	 timers;
 	struct msgbuf		*wbuf;
+	struct ibuf		*rbatch;	/* UPDATEs for the RDE */
+	struct ibufqueue	*bulkq;		/* UPDATEs and route refresh */
+	monotime_t		 qsample_time;
+	uint32_t		 qsample_pos;
 	struct peer		*template;
 	int			 fd;
 	int			 lasterr;
@@ -255,6 +260,7 @@ struct peer	*getpeerbydesc(struct bgpd_config *, const char *);
 struct peer	*getpeerbyip(struct bgpd_config *, struct sockaddr *);
 struct peer	*getpeerbyid(struct bgpd_config *, uint32_t);
 void		 session_handle_update(struct peer *, struct ibuf *);
+void		 session_update_flush(struct peer *);
 void		 session_handle_rrefresh(struct peer *, struct route_refresh *);
 void		 session_graceful_restart(struct peer *);
 void		 session_graceful_flush(struct peer *, u_int, const char *);
@@ -278,6 +284,9 @@ struct bgpd_addr *session_localaddr(struct peer *);
 void	session_open(struct peer *);
 void	session_keepalive(struct peer *);
 void	session_update(struct peer *, struct ibuf *);
+void	session_bulk_refill(struct peer *);
+void	session_bulk_flush(struct peer *);
+uint32_t session_queuelen(struct peer *);
 void	session_notification(struct peer *, uint8_t, uint8_t, struct ibuf *);
 void	session_notification_data(struct peer *, uint8_t, uint8_t, void *,
 	    size_t);
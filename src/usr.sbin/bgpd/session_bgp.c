@@ -66,7 +66,74 @@ session_sendmsg(struct ibuf *msg, struct peer *p, enum msg_type msgtype)
 {
 	session_mrt_dump_bgp_msg(p, msg, msgtype, DIR_OUT);
 
-	ibuf_close(p->wbuf, msg);
+	switch (msgtype) {
+	case BGP_UPDATE:
+	case BGP_RREFRESH:
+		/*
+		 * Bulk messages are queued in order and moved to the write
+		 * buffer in small batches by session_bulk_refill().
+		 * Keepalives and notifications are written ahead of them.
+		 * One message at a time is sampled for the queue delay.
+		 */
+		ibufq_push(p->bulkq, msg);
+		if (p->qsample_pos == 0) {
+			p->qsample_pos = ibufq_queuelen(p->bulkq);
+			p->qsample_time = getmonotime();
+		}
+		break;
+	case BGP_NOTIFICATION:
+		/* the session is closed, nothing is sent after this */
+		session_bulk_flush(p);
+		/* FALLTHROUGH */
+	default:
+		ibuf_close(p->wbuf, msg);
+		break;
+	}
+}
+
+static void
+session_qdelay_add(struct peer *p)
+{
+	long long ms, lim = 1;
+	int i;
+
+	ms = monotime_to_msec(monotime_sub(getmonotime(), p->qsample_time));
+	for (i = 0; i < QDELAY_BUCKETS - 1 && ms >= lim; i++)
+		lim *= 10;
+	p->stats.qdelay[i]++;
+}
+
+/*
+ * Move bulk messages into the write buffer. At most SESS_WBUF_BATCH
+ * messages are in the write buffer so a keepalive only waits behind
+ * a small batch of UPDATEs.
+ */
+void
+session_bulk_refill(struct peer *p)
+{
+	struct ibuf	*buf;
+	uint32_t	 n;
+
+	for (n = msgbuf_queuelen(p->wbuf); n < SESS_WBUF_BATCH; n++) {
+		if ((buf = ibufq_pop(p->bulkq)) == NULL)
+			break;
+		ibuf_close(p->wbuf, buf);
+		if (p->qsample_pos != 0 && --p->qsample_pos == 0)
+			session_qdelay_add(p);
+	}
+}
+
+void
+session_bulk_flush(struct peer *p)
+{
+	ibufq_flush(p->bulkq);
+	p->qsample_pos = 0;
+}
+
+uint32_t
+session_queuelen(struct peer *p)
+{
+	return msgbuf_queuelen(p->wbuf) + ibufq_queuelen(p->bulkq);
 }
 
 /*
@@ -1231,6 +1298,7 @@ session_process_msg(struct peer *p)
 			log_peer_warn(&p->conf, "process message failed");
 			bgp_fsm(p, EVNT_CON_FATAL, NULL);
 			ibuf_free(msg);
+			session_update_flush(p);
 			return;
 		}
 		ibuf_rewind(msg);
@@ -1273,6 +1341,7 @@ session_process_msg(struct peer *p)
 			break;
 		}
 	}
+	session_update_flush(p);
 }
 
 static int
@@ -1849,6 +1918,7 @@ change_state(struct peer *peer, enum session_state state,
 		timer_stop(&peer->timers, Timer_IdleHoldReset);
 		session_close(peer);
 		msgbuf_clear(peer->wbuf);
+		session_bulk_flush(peer);
 		peer->rpending = 0;
 		memset(&peer->capa.peer, 0, sizeof(peer->capa.peer));
 		session_md5_reload(peer);
@@ -1910,6 +1980,7 @@ change_state(struct peer *peer, enum session_state state,
 			timer_stop(&peer->timers, Timer_IdleHoldReset);
 			session_close(peer);
 			msgbuf_clear(peer->wbuf);
+			session_bulk_flush(peer);
 			memset(&peer->capa.peer, 0, sizeof(peer->capa.peer));
 		}
 		break;